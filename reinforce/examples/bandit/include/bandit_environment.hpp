@@ -184,8 +184,8 @@ struct BanditEnvironment : environment::FiniteEnvironment<BanditStep<N_BANDITS>,
   }
   std::unordered_set<ActionSpace, typename ActionSpace::Hash> getAllPossibleActions() const {
     std::unordered_set<ActionSpace, typename ActionSpace::Hash> actions;
-    for (int i = 0; i < N_BANDITS; i++) {
-      actions.emplace(actionFromIndex(i));
+    for (const auto &action : spec::values<BanditActionSpec<N_BANDITS>>()) {
+      actions.emplace(ActionSpace(action));
     }
     return actions;
   }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <reinforce/environment.hpp>
+#include <reinforce/markov_decision_process/finite_transition_model.hpp>
+#include <reinforce/rng/engine.hpp>
+
+namespace examples::benchmarks {
+
+// A synthetic sparse MDP for timing the dynamic programming solvers. Each of
+// the N states has M actions and every action leads to B successors clustered
+// around a different offset on a ring of states, with random probabilities.
+// Landing on every 7th state pays a reward of 1.
+
+template <std::size_t N, std::size_t M, std::size_t B>
+struct random_mdp_builder {
+
+  using StateType0 = state::State<float, spec::CompositeArraySpec<spec::BoundedAarraySpec<int, 0, N, 1>>>;
+  using ActionType0 = action::Action<StateType0, spec::CompositeArraySpec<spec::BoundedAarraySpec<int, 0, M, 1>>>;
+  using StepType0 = step::Step<ActionType0>;
+
+  struct RewardType0 : reward::Reward<ActionType0> {
+    using typename reward::Reward<ActionType0>::PrecisionType;
+    using typename reward::Reward<ActionType0>::TransitionType;
+    static PrecisionType reward(const TransitionType &t) {
+      return std::get<0>(t.nextState.observable)[0] % 7 == 0 ? 1.0F : 0.0F;
+    }
+  };
+  using ReturnType0 = returns::Return<RewardType0>;
+
+  struct type : environment::MarkovDecisionEnvironment<StepType0, RewardType0, ReturnType0> {
+    SETUP_TYPES(SINGLE_ARG(environment::MarkovDecisionEnvironment<StepType0, RewardType0, ReturnType0>));
+    using typename BaseType::TransitionModel;
+
+    static TransitionModel makeTransitionModel(std::uint64_t seed) {
+      auto engine = rng::Engine(seed);
+      auto model = TransitionModel{};
+      model.transitions.reserve(N * M * B);
+      for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t a = 0; a < M; ++a) {
+          auto weights = std::array<double, B>{};
+          double total = 0;
+          for (auto &w : weights)
+            total += (w = rng::uniform(engine) + 1e-3);
+          for (std::size_t k = 0; k < B; ++k) {
+            const auto next = (i + a * (N / M) + k) % N;
+            model.transitions.emplace(
+                TransitionType{StateType(i, {}), ActionSpace(a), StateType(next, {})},
+                static_cast<PrecisionType>(weights[k] / total));
+          }
+        }
+      }
+      for (std::size_t i = 0; i < N; ++i)
+        model.states[i] = StateType{i, {}};
+      for (std::size_t a = 0; a < M; ++a)
+        model.actions[a] = ActionSpace{a};
+      return model;
+    }
+
+    explicit type(std::uint64_t seed = rng::defaultSeed) : BaseType(makeTransitionModel(seed)) {}
+
+    StateType reset() override { return StateType{}; }
+    StateType getNullState() const override { return StateType{0, {}}; }
+  };
+};
+
+template <std::size_t N, std::size_t M, std::size_t B>
+using RandomMDP = typename random_mdp_builder<N, M, B>::type;
+
+} // namespace examples::benchmarks
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include <reinforce/markov_decision_process/prioritized_sweeping.hpp>
+#include <reinforce/markov_decision_process/synchronous.hpp>
+#include <reinforce/markov_decision_process/value_iteration.hpp>
+#include <reinforce/policy/objectives/finite_value_function.hpp>
+
+#include "random_mdp.hpp"
+
+using namespace examples::benchmarks;
+using namespace markov_decision_process;
+
+// Times value iteration on a sparse random MDP, first with the in place serial
+// sweeps and prioritized sweeping and then with synchronous sweeps on 1, 2, 4,
+// ... threads. Reports the speedup over the single threaded synchronous run and
+// the largest difference from the serial values.
+
+using EnvT = RandomMDP<8192, 4, 8>;
+using ValueFunctionT = policy::objectives::FiniteStateValueFunction<EnvT, 0.0F, 0.95F>;
+
+template <typename F>
+double seconds(F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+  constexpr float epsilon = 1e-5F;
+  const auto environment = std::make_unique<EnvT>();
+  const auto &model = environment->indexedTransitionModel;
+  std::cout << "States " << model.nStates() << ", actions " << model.nActions() << ", transitions "
+            << model.nEntries() << "\n";
+
+  auto serial = ValueFunctionT{};
+  const auto serialTime =
+      seconds([&] { value_iteration::value_iteration_policy_estimation(serial, *environment, epsilon); });
+  std::cout << "serial in place      " << std::fixed << std::setprecision(3) << serialTime << "s\n";
+
+  auto prioritized = ValueFunctionT{};
+  std::size_t backups = 0;
+  const auto prioritizedTime = seconds([&] {
+    backups = prioritized_sweeping::value_iteration_policy_estimation(prioritized, *environment, epsilon);
+  });
+  std::cout << "prioritized sweeping " << prioritizedTime << "s  " << backups << " backups\n";
+
+  double baseline = 0;
+  const auto maxThreads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  for (std::size_t nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+    auto pool = utils::ThreadPool(nThreads);
+    auto values = ValueFunctionT{};
+    const auto time =
+        seconds([&] { synchronous::value_iteration_policy_estimation(values, *environment, epsilon, pool); });
+    if (nThreads == 1)
+      baseline = time;
+
+    float maxDifference = 0;
+    for (const auto &state : model.states)
+      maxDifference = std::max(maxDifference, std::abs(values.valueAt(state) - serial.valueAt(state)));
+
+    std::cout << "synchronous " << std::setw(3) << nThreads << " threads " << time << "s  speedup " << std::setw(5)
+              << std::setprecision(2) << baseline / time << "  max |v - v_serial| " << std::scientific
+              << maxDifference << std::fixed << std::setprecision(3) << "\n";
+  }
+}
@@ -133,57 +133,44 @@ struct BlackjackReward : reward::Reward<BlackjackAction> {
 
 using BlackjackReturn = returns::Return<BlackjackReward>;
 
-constexpr auto maxVal = 21; // cant go above this value
-constexpr auto nHasAce = 2;
-constexpr auto nStates = maxVal * nHasAce * maxVal * nHasAce;
-constexpr auto nActions = 2;
-
 template <environment::RewardType REWARD_T, environment::ReturnType RETURN_T>
 struct BlackjackEnvironment : environment::FiniteEnvironment<BlackjackStep, REWARD_T, RETURN_T> {
 
   SETUP_TYPES_W_ENVIRON(
       SINGLE_ARG(environment::Environment<BlackjackStep, REWARD_T, RETURN_T>), SINGLE_ARG(BlackjackEnvironment));
 
-  // init random device
-  std::random_device rd;
-  std::mt19937 gen{rd()};
+  constexpr static bool isSpecEnumerable = true;
 
   Cards dealerDraw() {
     std::uniform_int_distribution<> dis(1, 13);
-    return Cards{dis(gen)};
+    return Cards{dis(this->gen)};
   }
 
   StateType stateFromIndex(std::size_t index) const override {
-    auto i = index / (nHasAce * maxVal * nHasAce);
-    auto j = (index - i * nHasAce * maxVal * nHasAce) / (maxVal * nHasAce);
-    auto k = (index - i * nHasAce * maxVal * nHasAce - j * maxVal * nHasAce) / nHasAce;
-    auto l = index - i * nHasAce * maxVal * nHasAce - j * maxVal * nHasAce - k * nHasAce;
-    return StateType({{static_cast<int>(i)}, {static_cast<int>(j)}, {static_cast<int>(k)}, {static_cast<int>(l)}}, {});
+    return StateType(spec::fromIndex<BlackjackStateSpec>(index), {});
   };
 
-  ActionSpace actionFromIndex(std::size_t index) const override { return ActionSpace(static_cast<int>(index)); };
+  ActionSpace actionFromIndex(std::size_t index) const override {
+    return ActionSpace(spec::fromIndex<BlackjackActionSpec>(index));
+  };
 
   std::unordered_set<StateType, typename StateType::Hash> getAllPossibleStates() const override {
     auto states = std::unordered_set<StateType, typename StateType::Hash>{};
-    for (auto i = 0; i < maxVal; ++i)
-      for (auto j = 0; j < nHasAce; ++j)
-        for (auto k = 0; k < maxVal; ++k)
-          for (auto l = 0; l < nHasAce; ++l)
-            states.emplace(StateType(
-                {{static_cast<int>(i)}, {static_cast<int>(j)}, {static_cast<int>(k)}, {static_cast<int>(l)}}, {}));
+    for (const auto &observable : spec::values<BlackjackStateSpec>())
+      states.emplace(StateType(observable, {}));
     return states;
   };
 
   std::unordered_set<ActionSpace, typename ActionSpace::Hash> getAllPossibleActions() const {
     auto actions = std::unordered_set<ActionSpace, typename ActionSpace::Hash>{};
-    for (auto i = 0; i < nActions; ++i)
-      actions.emplace(ActionSpace(i));
+    for (const auto &action : spec::values<BlackjackActionSpec>())
+      actions.emplace(ActionSpace(action));
     return actions;
   };
 
   StateType reset() override {
 
-    auto observable = ::policy::random_spec_gen<BlackjackStateSpec>(rd);
+    auto observable = ::policy::random_spec_gen<BlackjackStateSpec>(this->gen);
 
     // Enforce the dealer strategy of Required to hit on 16 or less
 
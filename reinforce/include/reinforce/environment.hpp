@@ -13,6 +13,8 @@
 #include "reinforce/action.hpp"
 #include "reinforce/returns.hpp"
 #include "reinforce/reward.hpp"
+#include "reinforce/rng/alias_table.hpp"
+#include "reinforce/rng/engine.hpp"
 #include "reinforce/spec.hpp"
 #include "reinforce/step.hpp"
 #include "reinforce/transition.hpp"
@@ -132,13 +134,20 @@ struct FiniteEnvironment : Environment<STEP_T, REWARD_T, RETURN_T> {
   using EnvironmentType = FiniteEnvironment;
   using BaseType::BaseType;
 
-  std::random_device rd;
-  mutable std::mt19937 gen{rd()};
+  // Each environment owns its own stream so that environments can be stepped
+  // from different threads without sharing generator state.
+  mutable rng::Engine gen = rng::makeEngine();
+
+  void seed(std::uint64_t seed) { gen.seed(seed); }
 
   constexpr static std::size_t nStates = StateType::nStates;
   constexpr static std::size_t nActions = ActionSpecType::nPossibleValues();
   constexpr static std::size_t mStateAction = nStates * nActions;
 
+  // Set when every value of the observable spec is a state of the environment.
+  // Sweeps can then walk spec::values lazily instead of getAllPossibleStates.
+  constexpr static bool isSpecEnumerable = false;
+
   virtual StateType stateFromIndex(std::size_t) const = 0;
   virtual ActionSpace actionFromIndex(std::size_t) const = 0;
 
@@ -152,25 +161,18 @@ struct FiniteEnvironment : Environment<STEP_T, REWARD_T, RETURN_T> {
     return getAllPossibleActions();
   }
   virtual bool isReachableAction(const StateType &s, const ActionSpace &a) const {
-    return getReachableActions(s).find(a) != getReachableActions(s).end();
+    const auto actions = getReachableActions(s);
+    return actions.find(a) != actions.end();
   };
 
-  StateType randomState() const {
-    const auto probabilities = std::vector<double>(nStates, 1.0 / nStates);
-    std::discrete_distribution<size_t> distribution(probabilities.begin(), probabilities.end());
-    return stateFromIndex(distribution(gen));
-  }
+  StateType randomState() const { return stateFromIndex(rng::uniformIndex(nStates, gen)); }
 
-  ActionSpace randomAction() const {
-    const auto probabilities = std::vector<double>(nActions, 1.0 / nActions);
-    std::discrete_distribution<size_t> distribution(probabilities.begin(), probabilities.end());
-    return actionFromIndex(distribution(gen));
-  }
+  ActionSpace randomAction() const { return actionFromIndex(rng::uniformIndex(nActions, gen)); }
+
+  // Environments that know their model up front override this with a lookup
   virtual ActionSpace randomAction(const StateType &s) const {
     const auto admissibleActions = getReachableActions(s);
-    const auto probabilities = std::vector<double>(admissibleActions.size(), 1.0 / admissibleActions.size());
-    std::discrete_distribution<size_t> distribution(probabilities.begin(), probabilities.end());
-    return *std::next(admissibleActions.begin(), distribution(gen));
+    return *std::next(admissibleActions.begin(), rng::uniformIndex(admissibleActions.size(), gen));
   }
 };
 
@@ -179,6 +181,10 @@ concept FiniteEnvironmentType = std::is_base_of_v<
     FiniteEnvironment<typename ENVIRON_T::StepType, typename ENVIRON_T::RewardType, typename ENVIRON_T::ReturnType>,
     ENVIRON_T>;
 
+template <typename T>
+concept SpecEnumerableEnvironment =
+    FiniteEnvironmentType<T> && spec::FiniteSpecType<typename T::StateType::ObservableSpecType> && T::isSpecEnumerable;
+
 template <typename T>
 concept FullyKnownFiniteActionStateEnvironment = FiniteEnvironmentType<T> && requires(T t) {
   { t.getAllPossibleStates() } -> std::same_as<std::unordered_set<typename T::StateType, typename T::StateType::Hash>>;
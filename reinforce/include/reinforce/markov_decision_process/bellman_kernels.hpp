@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Inner loops of the dense dynamic programming solvers. A Bellman backup of a
+// row of the indexed transition model is
+//
+// \begin{equation} \sum_{s'} p(s'|s,a) (r(s,a,s') + \gamma v(s')) = \bar{r}(s,a) +
+// \gamma \sum_{s'} p(s'|s,a) v(s') \end{equation}
+//
+// where the expected reward is precomputed by the model, leaving a gathered
+// dot product of the row probabilities with the values of its successors.
+// With AVX-512 or AVX2 enabled at compile time (-mavx512f, -mavx2 -mfma or
+// -march=native) the dot product gathers 16/8 floats or 8/4 doubles at a time,
+// finishing AVX-512 rows with 8/4 wide AVX2 gathers, otherwise it is a scalar
+// loop. Successor indices are read as signed 32 bit gather offsets which limits
+// the vector paths to fewer than 2^31 states.
+namespace markov_decision_process::kernels {
+
+namespace detail {
+
+template <typename PRECISION_T>
+PRECISION_T dot_gather_scalar(
+    const PRECISION_T *probabilities, const std::uint32_t *successors, std::size_t n, const PRECISION_T *values) {
+  PRECISION_T sum = 0;
+  for (std::size_t k = 0; k < n; ++k)
+    sum += probabilities[k] * values[successors[k]];
+  return sum;
+}
+
+#if defined(__AVX2__)
+
+inline __m256 fmadd(__m256 a, __m256 b, __m256 c) {
+#if defined(__FMA__)
+  return _mm256_fmadd_ps(a, b, c);
+#else
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+inline __m256d fmadd(__m256d a, __m256d b, __m256d c) {
+#if defined(__FMA__)
+  return _mm256_fmadd_pd(a, b, c);
+#else
+  return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+
+inline float horizontal_sum(__m256 x) {
+  auto sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+inline double horizontal_sum(__m256d x) {
+  auto sum = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+  sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+  return _mm_cvtsd_f64(sum);
+}
+
+inline float
+dot_gather_avx2(const float *probabilities, const std::uint32_t *successors, std::size_t n, const float *values) {
+  auto acc = _mm256_setzero_ps();
+  std::size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    const auto idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(successors + k));
+    const auto v = _mm256_i32gather_ps(values, idx, 4);
+    acc = fmadd(_mm256_loadu_ps(probabilities + k), v, acc);
+  }
+  return horizontal_sum(acc) + dot_gather_scalar(probabilities + k, successors + k, n - k, values);
+}
+
+inline double
+dot_gather_avx2(const double *probabilities, const std::uint32_t *successors, std::size_t n, const double *values) {
+  auto acc = _mm256_setzero_pd();
+  std::size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    const auto idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(successors + k));
+    const auto v = _mm256_i32gather_pd(values, idx, 8);
+    acc = fmadd(_mm256_loadu_pd(probabilities + k), v, acc);
+  }
+  return horizontal_sum(acc) + dot_gather_scalar(probabilities + k, successors + k, n - k, values);
+}
+
+#endif
+
+#if defined(__AVX512F__)
+
+inline float
+dot_gather_simd(const float *probabilities, const std::uint32_t *successors, std::size_t n, const float *values) {
+  auto acc = _mm512_setzero_ps();
+  std::size_t k = 0;
+  for (; k + 16 <= n; k += 16) {
+    const auto idx = _mm512_loadu_si512(successors + k);
+    const auto v = _mm512_i32gather_ps(idx, values, 4);
+    acc = _mm512_fmadd_ps(_mm512_loadu_ps(probabilities + k), v, acc);
+  }
+  return _mm512_reduce_add_ps(acc) + dot_gather_avx2(probabilities + k, successors + k, n - k, values);
+}
+
+inline double
+dot_gather_simd(const double *probabilities, const std::uint32_t *successors, std::size_t n, const double *values) {
+  auto acc = _mm512_setzero_pd();
+  std::size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    const auto idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(successors + k));
+    const auto v = _mm512_i32gather_pd(idx, values, 8);
+    acc = _mm512_fmadd_pd(_mm512_loadu_pd(probabilities + k), v, acc);
+  }
+  return _mm512_reduce_add_pd(acc) + dot_gather_avx2(probabilities + k, successors + k, n - k, values);
+}
+
+#elif defined(__AVX2__)
+
+inline float
+dot_gather_simd(const float *probabilities, const std::uint32_t *successors, std::size_t n, const float *values) {
+  return dot_gather_avx2(probabilities, successors, n, values);
+}
+
+inline double
+dot_gather_simd(const double *probabilities, const std::uint32_t *successors, std::size_t n, const double *values) {
+  return dot_gather_avx2(probabilities, successors, n, values);
+}
+
+#endif
+
+} // namespace detail
+
+/// @brief True when dot_gather uses vector instructions for PRECISION_T.
+template <typename PRECISION_T>
+constexpr bool isVectorized =
+#if defined(__AVX2__) || defined(__AVX512F__)
+    std::is_same_v<PRECISION_T, float> || std::is_same_v<PRECISION_T, double>;
+#else
+    false;
+#endif
+
+/// @brief \sum_k probabilities[k] * values[successors[k]]
+template <typename PRECISION_T>
+PRECISION_T dot_gather(
+    const PRECISION_T *probabilities, const std::uint32_t *successors, std::size_t n, const PRECISION_T *values) {
+#if defined(__AVX2__) || defined(__AVX512F__)
+  if constexpr (isVectorized<PRECISION_T>)
+    return detail::dot_gather_simd(probabilities, successors, n, values);
+  else
+#endif
+    return detail::dot_gather_scalar(probabilities, successors, n, values);
+}
+
+/// @brief The Bellman backup of row r of an indexed transition model.
+template <typename MODEL_T, typename PRECISION_T>
+PRECISION_T backup(const MODEL_T &model, const PRECISION_T *values, PRECISION_T discountRate, std::size_t r) {
+  const auto begin = model.rowOffsets[r];
+  const auto n = model.rowOffsets[r + 1] - begin;
+  return model.expectedRewards[r] +
+         discountRate * dot_gather(model.probabilities.data() + begin, model.successors.data() + begin, n, values);
+}
+
+template <typename PRECISION_T>
+struct MaxBackup {
+  PRECISION_T value;
+  /// @brief The first action attaining value. nActions when the state has no
+  /// transitions, in which case value is the lowest representable value.
+  std::size_t action;
+};
+
+/**
+ * @brief The max and argmax of the Bellman backups over the actions of a
+ * state. The rows of a state are adjacent in the model so this is a single
+ * forward pass over its transitions.
+ */
+template <typename MODEL_T, typename PRECISION_T>
+MaxBackup<PRECISION_T>
+max_backup(const MODEL_T &model, const PRECISION_T *values, PRECISION_T discountRate, std::size_t stateIdx) {
+  auto best = MaxBackup<PRECISION_T>{std::numeric_limits<PRECISION_T>::lowest(), model.nActions()};
+  for (std::size_t a = 0; a < model.nActions(); ++a) {
+    const auto r = model.row(stateIdx, a);
+    if (model.rowOffsets[r] == model.rowOffsets[r + 1])
+      continue;
+    const auto value = backup(model, values, discountRate, r);
+    if (best.action == model.nActions() or value > best.value)
+      best = {value, a};
+  }
+  return best;
+}
+
+} // namespace markov_decision_process::kernels
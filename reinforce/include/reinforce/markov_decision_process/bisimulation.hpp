@@ -0,0 +1,405 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "reinforce/markov_decision_process/bellman_kernels.hpp"
+#include "reinforce/markov_decision_process/model_builder.hpp"
+#include "reinforce/markov_decision_process/policy_iteration.hpp"
+
+// Model minimisation by stochastic bisimulation (Givan, Dean and Greig). Two
+// states are bisimilar when, for every action, they have the same expected
+// reward and move with the same probability into every block of bisimilar
+// states. Bisimilar states have the same optimal value and the same optimal
+// actions, so the MDP can be solved over one representative per block, the
+// quotient, and the solution copied back to every state of the block. Models
+// built from symmetric or repeated pieces often lump into a fraction of their
+// states with no loss.
+//
+// The coarsest bisimulation is found by signature refinement. States start
+// partitioned by their terminal flag and the expected reward of every action,
+// then blocks are split by the probability of moving into every current block
+// until none splits. Only the blocks holding a predecessor of a state that
+// moved to a new block can split again, so only those are refined. Rewards and
+// probabilities are compared after rounding to a multiple of a tolerance, so
+// sums taken in a different order still agree.
+//
+// Terminal states are never backed up so the solvers keep whatever value they
+// hold. Lumping them together assumes those values are equal, as they are for
+// a value function that starts every state from the same initial value.
+namespace markov_decision_process::bisimulation {
+
+/// @brief A partition of the states of an indexed transition model.
+struct Partition {
+  /// @brief The block of every state.
+  std::vector<std::uint32_t> blocks;
+  /// @brief The lowest state index of every block. Blocks are numbered in
+  /// order of their representatives.
+  std::vector<std::uint32_t> representatives;
+
+  std::size_t size() const { return representatives.size(); }
+};
+
+/// @brief A partition and the model over its blocks. The states of the
+/// quotient model are the representatives of the blocks.
+template <typename MODEL_T>
+struct Quotient {
+  Partition partition;
+  MODEL_T model;
+};
+
+namespace detail {
+
+using Signature = std::vector<std::int64_t>;
+
+struct SignatureHash {
+  std::size_t operator()(const Signature &signature) const {
+    std::size_t seed = signature.size();
+    for (const auto x : signature)
+      seed ^= std::hash<std::int64_t>{}(x) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+  }
+};
+
+inline std::int64_t quantise(double x, double tolerance) { return std::llround(x / tolerance); }
+
+/// @brief Number the states by signature, in order of first appearance.
+template <typename SIGNATURE_F>
+std::vector<std::uint32_t> number_blocks(std::size_t nStates, SIGNATURE_F &&signature) {
+  auto numbers = std::unordered_map<Signature, std::uint32_t, SignatureHash>();
+  auto blocks = std::vector<std::uint32_t>(nStates);
+  for (std::size_t i = 0; i < nStates; ++i)
+    blocks[i] = numbers.try_emplace(signature(i), static_cast<std::uint32_t>(numbers.size())).first->second;
+  return blocks;
+}
+
+} // namespace detail
+
+/**
+ * @brief The coarsest stochastic bisimulation of an indexed transition model.
+ *
+ * @details Refining a block costs a sort of the entries of each of its states.
+ * When a block splits, the blocks of the predecessors of the states that moved
+ * out of it are queued to be refined again. In the worst case every split
+ * queues every block, so there are up to as many rounds over the whole model
+ * as there are blocks, O(|blocks| * |entries| log |entries|). Splits usually
+ * touch a few blocks each, and each round only covers the queued ones.
+ *
+ * @param tolerance Expected rewards and block probabilities are equal when
+ * they round to the same multiple of tolerance.
+ */
+template <typename MODEL_T>
+Partition coarsest_partition(const MODEL_T &model, double tolerance = 1e-6) {
+  const auto nStates = model.nStates();
+  const auto nActions = model.nActions();
+
+  // Terminal flag and, for every action, whether it has transitions and its
+  // expected reward
+  auto blocks = detail::number_blocks(nStates, [&](std::size_t i) {
+    auto signature = detail::Signature{model.terminal[i]};
+    for (std::size_t a = 0; a < nActions; ++a) {
+      const auto r = model.row(i, a);
+      signature.push_back(model[r].empty() ? 0 : 1);
+      signature.push_back(detail::quantise(model.expectedRewards[r], tolerance));
+    }
+    return signature;
+  });
+
+  // For every action the probability of moving into each block it reaches, in
+  // block order. Signatures are only compared within a block.
+  auto entries = std::vector<std::pair<std::uint32_t, double>>();
+  auto refine = [&](std::size_t i) {
+    auto signature = detail::Signature{};
+    for (std::size_t a = 0; a < nActions; ++a) {
+      const auto row = model(i, a);
+      entries.clear();
+      for (std::size_t k = 0; k < row.size(); ++k)
+        entries.emplace_back(blocks[row.successors[k]], row.probabilities[k]);
+      std::sort(entries.begin(), entries.end());
+      signature.push_back(-1);
+      for (std::size_t k = 0; k < entries.size();) {
+        const auto block = entries[k].first;
+        double probability = 0.0;
+        for (; k < entries.size() and entries[k].first == block; ++k)
+          probability += entries[k].second;
+        signature.push_back(block);
+        signature.push_back(detail::quantise(probability, tolerance));
+      }
+    }
+    return signature;
+  };
+
+  auto members = std::vector<std::vector<std::uint32_t>>();
+  for (std::size_t i = 0; i < nStates; ++i) {
+    if (blocks[i] >= members.size())
+      members.resize(blocks[i] + 1);
+    members[blocks[i]].push_back(static_cast<std::uint32_t>(i));
+  }
+
+  const auto predecessors = model.predecessors();
+  auto queued = std::vector<std::uint8_t>(members.size(), 1);
+  auto queue = std::vector<std::uint32_t>(members.size());
+  std::iota(queue.begin(), queue.end(), 0);
+  auto groups = std::unordered_map<detail::Signature, std::uint32_t, detail::SignatureHash>();
+  auto group = std::vector<std::uint32_t>();
+  while (not queue.empty()) {
+    const auto b = queue.back();
+    queue.pop_back();
+    queued[b] = 0;
+    if (members[b].size() < 2)
+      continue;
+
+    // Group the whole block before moving any state, its signatures read the
+    // blocks of its own states
+    groups.clear();
+    group.clear();
+    for (const auto i : members[b])
+      group.push_back(groups.try_emplace(refine(i), static_cast<std::uint32_t>(groups.size())).first->second);
+    if (groups.size() == 1)
+      continue;
+
+    // The first group keeps the block and every other becomes a new one
+    const auto first = static_cast<std::uint32_t>(members.size()) - 1;
+    members.resize(members.size() + groups.size() - 1);
+    queued.resize(members.size(), 0);
+    auto block = std::move(members[b]);
+    members[b].clear();
+    for (std::size_t k = 0; k < block.size(); ++k) {
+      const auto i = block[k];
+      if (group[k] == 0) {
+        members[b].push_back(i);
+        continue;
+      }
+      blocks[i] = first + group[k];
+      members[blocks[i]].push_back(i);
+    }
+    for (std::size_t k = 0; k < block.size(); ++k) {
+      if (group[k] == 0)
+        continue;
+      for (const auto p : predecessors[block[k]]) {
+        if (not std::exchange(queued[blocks[p]], 1))
+          queue.push_back(blocks[p]);
+      }
+    }
+  }
+
+  // Number the blocks in order of their representatives
+  constexpr auto npos = std::numeric_limits<std::uint32_t>::max();
+  auto numbers = std::vector<std::uint32_t>(members.size(), npos);
+  auto partition = Partition{};
+  partition.blocks.resize(nStates);
+  for (std::size_t i = 0; i < nStates; ++i) {
+    auto &number = numbers[blocks[i]];
+    if (number == npos) {
+      number = static_cast<std::uint32_t>(partition.representatives.size());
+      partition.representatives.push_back(static_cast<std::uint32_t>(i));
+    }
+    partition.blocks[i] = number;
+  }
+  return partition;
+}
+
+/**
+ * @brief Lump the model by its coarsest bisimulation.
+ *
+ * @details A row of the quotient is the row of the representative with its
+ * successors replaced by their blocks. Entries into the same block are
+ * combined by the model builder, which keeps the expected reward of the row.
+ */
+template <reward::RewardType REWARD_T>
+Quotient<environment::IndexedTransitionModel<REWARD_T>>
+quotient(const environment::IndexedTransitionModel<REWARD_T> &model, double tolerance = 1e-6) {
+  auto partition = coarsest_partition(model, tolerance);
+
+  auto states = std::vector<typename REWARD_T::StateType>();
+  states.reserve(partition.size());
+  for (const auto i : partition.representatives)
+    states.push_back(model.states[i]);
+
+  auto builder = environment::IndexedTransitionModelBuilder<REWARD_T>(std::move(states), model.actions);
+  for (std::size_t b = 0; b < partition.size(); ++b) {
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      const auto row = model(partition.representatives[b], a);
+      for (std::size_t k = 0; k < row.size(); ++k)
+        builder.add(b, a, partition.blocks[row.successors[k]], row.probabilities[k], row.rewards[k]);
+    }
+  }
+  return {std::move(partition), builder.build()};
+}
+
+namespace detail {
+
+/// @brief The values of the blocks, read from the first relevant state of
+/// each or zero for a block of absorbing states, and which blocks have a
+/// relevant state.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, typename QUOTIENT_T>
+std::pair<std::vector<typename VALUE_FUNCTION_T::PrecisionType>, std::vector<std::uint8_t>> gather_values(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const QUOTIENT_T &quotient,
+    const std::vector<std::uint8_t> &relevant) {
+  const auto &model = environment.indexedTransitionModel;
+  auto values = std::vector<typename VALUE_FUNCTION_T::PrecisionType>(quotient.partition.size());
+  auto blockRelevant = std::vector<std::uint8_t>(quotient.partition.size(), 0);
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    const auto b = quotient.partition.blocks[i];
+    if (relevant[i] and not std::exchange(blockRelevant[b], 1))
+      values[b] = model.isAbsorbing(i) ? 0.0F : valueFunction.valueAt(model.states[i]);
+  }
+  return {std::move(values), std::move(blockRelevant)};
+}
+
+} // namespace detail
+
+/**
+ * @brief Estimate the optimal state values by value iteration over the
+ * quotient, then copy the value of every block to its relevant states.
+ *
+ * @details The sweeps are those of
+ * value_iteration::value_iteration_policy_estimation, over blocks instead of
+ * states. Terminal states keep their values.
+ *
+ * @param quotient The quotient of the environments indexed transition model
+ * @param relevant The states to estimate, see relevant_states.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, typename QUOTIENT_T>
+void value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const QUOTIENT_T &quotient,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const std::vector<std::uint8_t> &relevant) {
+
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+
+  const auto &model = environment.indexedTransitionModel;
+  const auto &lumped = quotient.model;
+  auto [values, blockRelevant] = detail::gather_values(valueFunction, environment, quotient, relevant);
+
+  PrecisionType delta = 0.0F;
+  do {
+    delta = 0.0F;
+    for (std::size_t b = 0; b < lumped.nStates(); ++b) {
+      if (lumped.terminal[b] or not blockRelevant[b])
+        continue;
+      const auto best = kernels::max_backup(lumped, values.data(), valueFunction.discount_rate, b);
+      const auto value = std::max(PrecisionType(0.0F), best.value);
+      delta = std::max(delta, std::abs(value - values[b]));
+      values[b] = value;
+    }
+  } while (delta > epsilon);
+
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    if (not model.hasTransitions(i) or not relevant[i])
+      continue;
+    valueFunction.valueAt(model.states[i]);
+    valueFunction.at(model.states[i]).value = values[quotient.partition.blocks[i]];
+  }
+}
+
+/// @brief As above, lumping the environments model first, over its relevant
+/// states.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+void value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+  value_iteration_policy_estimation(
+      valueFunction, environment, quotient(environment.indexedTransitionModel), epsilon, relevant_states(environment));
+}
+
+/**
+ * @brief Greedy policy improvement over the quotient. Every relevant state
+ * with transitions takes the greedy action of its block, unless its current
+ * action ties with it, as in markov_decision_process::policy_improvement.
+ *
+ * @param relevant The states to improve, see relevant_states.
+ * @return Whether the policy was left unchanged.
+ */
+template <
+    policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T,
+    policy::isDistributionPolicy POLICY_T,
+    typename QUOTIENT_T>
+bool policy_improvement(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const QUOTIENT_T &quotient,
+    POLICY_T &policy,
+    const std::vector<std::uint8_t> &relevant) {
+
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+
+  const auto &model = environment.indexedTransitionModel;
+  const auto &lumped = quotient.model;
+  const auto [values, blockRelevant] = detail::gather_values(valueFunction, environment, quotient, relevant);
+  const PrecisionType discountRate = valueFunction.discount_rate;
+
+  auto greedy = std::vector<kernels::MaxBackup<PrecisionType>>(lumped.nStates());
+  for (std::size_t b = 0; b < lumped.nStates(); ++b) {
+    if (blockRelevant[b])
+      greedy[b] = kernels::max_backup(lumped, values.data(), discountRate, b);
+  }
+
+  bool policyStable = true;
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    const auto b = quotient.partition.blocks[i];
+    if (not relevant[i] or not model.hasTransitions(i))
+      continue;
+    // States without a current action always take the greedy one
+    const auto oldAction = current_action(policy, environment, i);
+    if (oldAction != model.nActions()) {
+      const auto r = lumped.row(b, oldAction);
+      const auto stable = lumped.rowOffsets[r] != lumped.rowOffsets[r + 1] and
+                          kernels::backup(lumped, values.data(), discountRate, r) >= greedy[b].value;
+      if (stable)
+        continue;
+    }
+    policyStable = false;
+    if constexpr (policy::isDeterministicPolicy<POLICY_T>)
+      policy.setActionIndex(i, greedy[b].action);
+    else
+      policy.setDeterministicPolicy(environment, model.states[i], model.actions[greedy[b].action]);
+  }
+  return policyStable;
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <
+    policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T,
+    policy::isDistributionPolicy POLICY_T,
+    typename QUOTIENT_T>
+bool policy_improvement(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const QUOTIENT_T &quotient,
+    POLICY_T &policy) {
+  return policy_improvement(valueFunction, environment, quotient, policy, relevant_states(environment));
+}
+
+/**
+ * @brief Value iteration over the quotient of the environments model, followed
+ * by greedy policy improvement over it. The model is lumped and its relevant
+ * states found once for both.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void value_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+
+  const auto lumped = quotient(environment.indexedTransitionModel);
+  const auto relevant = relevant_states(environment);
+  value_iteration_policy_estimation(valueFunction, environment, lumped, epsilon, relevant);
+  policy_improvement(valueFunction, environment, lumped, policy, relevant);
+}
+
+} // namespace markov_decision_process::bisimulation
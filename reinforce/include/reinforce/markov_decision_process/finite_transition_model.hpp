@@ -1,11 +1,16 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <random>
+#include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <reinforce/environment.hpp>
+#include <reinforce/markov_decision_process/indexed_transition_model.hpp>
+#include <reinforce/rng/alias_table.hpp>
 
 namespace environment {
 
@@ -30,20 +35,27 @@ struct MarkovDecisionEnvironment : FiniteEnvironment<STEP_T, REWARD_T, RETURN_T>
     std::array<ActionSpace, nActions> actions;
   };
 
-  /// @brief  The mapping from (state, action, nextState) to probabiliies
-  TransitionModel transitionModel;
+  using IndexedTransitionModelType = IndexedTransitionModel<RewardType>;
 
-  // TODO : CONVERT TRANSITION MODEL INTO TRANSITION MATRIX - to enable INDEXING VIA NUMBER
-  // BY NECESSITY the transition model already has to know everything about state-action pairs. Because it
-  // uses the transitionType hash.
+  /// @brief  The mapping from (state, action, nextState) to probabiliies. Only
+  /// read while constructing the environment, so it is const: the compiled
+  /// model below and the samplers built from it would not see later changes.
+  const TransitionModel transitionModel;
 
-  // For sampling
-  std::random_device rd;
-  std::mt19937 gen{rd()};
+  /// @brief The transition model compiled to a sparse matrix over (state index,
+  /// action index) rows. Every query below is answered from it rather than by
+  /// scanning the transition map.
+  const IndexedTransitionModelType indexedTransitionModel;
 
   MarkovDecisionEnvironment() = delete;
-  MarkovDecisionEnvironment(const TransitionModel &t) : transitionModel(t){};
-  MarkovDecisionEnvironment(const TransitionModel &t, const StateType &s) : BaseType(s), transitionModel(t){};
+  MarkovDecisionEnvironment(const TransitionModel &t) : transitionModel(t), indexedTransitionModel(compile(t)){};
+  MarkovDecisionEnvironment(const TransitionModel &t, const StateType &s)
+      : BaseType(s), transitionModel(t), indexedTransitionModel(compile(t)){};
+
+  /// @brief Adopt an already compiled model, for example one read by
+  /// model_file::read. The transition map of transitionModel is left empty.
+  MarkovDecisionEnvironment(IndexedTransitionModelType model, const StateType &s)
+      : BaseType(s), transitionModel(spaces(model)), indexedTransitionModel(std::move(model)){};
 
   StateType stateFromIndex(std::size_t idx) const override { return transitionModel.states[idx]; };
   ActionSpace actionFromIndex(std::size_t idx) const override { return transitionModel.actions[idx]; };
@@ -51,9 +63,10 @@ struct MarkovDecisionEnvironment : FiniteEnvironment<STEP_T, REWARD_T, RETURN_T>
   TransitionType step(const ActionSpace &action) override {
 
     // sample next state according to the transition model
-    auto nextStates = getReachableStates(this->state, action);
-    auto nextStatesProbabilities = getTransitionProbabilities(this->state, action);
-    auto nextState = sample(nextStates, nextStatesProbabilities);
+    const auto &model = indexedTransitionModel;
+    const auto r = model.row(model.stateIndex(this->state), model.actionIndex(action));
+    const auto k = sampleRow(r, this->gen);
+    const auto &nextState = model.states[model[r].successors[k]];
 
     return TransitionType{this->state, action, nextState};
   }
@@ -61,67 +74,145 @@ struct MarkovDecisionEnvironment : FiniteEnvironment<STEP_T, REWARD_T, RETURN_T>
   std::unordered_set<TransitionType, typename TransitionType::Hash>
   getTransitions(const StateType &s, const ActionSpace &a) const {
     std::unordered_set<TransitionType, typename TransitionType::Hash> transitions;
-    for (const auto &t : transitionModel.transitions) {
-      if (t.first.state == s and t.first.action == a) {
-        transitions.emplace(t.first);
-      }
+    for (const auto &nextState : getReachableStates(s, a)) {
+      transitions.emplace(TransitionType{s, a, nextState});
     }
     return transitions;
   }
 
+  /// @brief A uniform draw from the actions with transitions out of s, read
+  /// from the per state lists built with the environment.
+  ActionSpace randomAction(const StateType &s) const override {
+    const auto i = indexedTransitionModel.findState(s);
+    if (i == IndexedTransitionModelType::npos or reachableActionOffsets[i] == reachableActionOffsets[i + 1])
+      throw std::out_of_range("No actions are reachable from the given state in the transition model");
+    const auto n = reachableActionOffsets[i + 1] - reachableActionOffsets[i];
+    const auto a = reachableActionIndices[reachableActionOffsets[i] + rng::uniformIndex(n, this->gen)];
+    return indexedTransitionModel.actions[a];
+  }
+
   std::unordered_set<ActionSpace, typename ActionSpace::Hash> getReachableActions(const StateType &s) const override {
     std::unordered_set<ActionSpace, typename ActionSpace::Hash> actions;
-    for (const auto &t : transitionModel.transitions) {
-      if (t.first.state == s)
-        actions.emplace(t.first.action);
+    const auto &model = indexedTransitionModel;
+    const auto i = model.findState(s);
+    if (i == model.npos)
+      return actions;
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      if (not model(i, a).empty())
+        actions.emplace(model.actions[a]);
     }
     return actions;
   }
 
+  /// @brief Whether a has transitions out of s, without listing the others.
+  bool isReachableAction(const StateType &s, const ActionSpace &a) const override {
+    const auto &model = indexedTransitionModel;
+    const auto i = model.findState(s);
+    const auto j = model.findAction(a);
+    return i != model.npos and j != model.npos and not model(i, j).empty();
+  }
+
   std::unordered_set<StateType, typename StateType::Hash>
   getReachableStates(const StateType &s, const ActionSpace &a) const override {
     std::unordered_set<StateType, typename StateType::Hash> states;
-    for (const auto &t : transitionModel.transitions) {
-      if (t.first.state == s and t.first.action == a) {
-        states.emplace(t.first.nextState);
-      }
+    const auto &model = indexedTransitionModel;
+    const auto i = model.findState(s);
+    const auto j = model.findAction(a);
+    if (i == model.npos or j == model.npos)
+      return states;
+    for (const auto k : model(i, j).successors) {
+      states.emplace(model.states[k]);
     }
     return states;
   }
 
-  std::vector<PrecisionType> getTransitionProbabilities(const StateType &s, const ActionSpace &a) {
-    std::vector<PrecisionType> probabilities;
-    for (const auto &t : transitionModel.transitions) {
-      if (t.first.state == s and t.first.action == a) {
-        probabilities.push_back(t.second);
-      }
-    }
-    return probabilities;
+  /// @brief The transition probabilities from (s, a) in the same order as the
+  /// successors of its row in the indexed model.
+  std::vector<PrecisionType> getTransitionProbabilities(const StateType &s, const ActionSpace &a) const {
+    const auto &model = indexedTransitionModel;
+    const auto i = model.findState(s);
+    const auto j = model.findAction(a);
+    if (i == model.npos or j == model.npos)
+      return {};
+    const auto row = model(i, j);
+    return std::vector<PrecisionType>(row.probabilities.begin(), row.probabilities.end());
   }
 
-  StateType sample(
-      const std::unordered_set<StateType, typename StateType::Hash> &states,
-      const std::vector<PrecisionType> &probabilities) {
-    std::discrete_distribution<size_t> distribution(probabilities.begin(), probabilities.end());
-    return *std::next(states.begin(), distribution(gen));
+  /// @brief The position within row r of the indexed model of a successor
+  /// drawn in proportion to its probability, from the alias tables built with
+  /// the environment. Safe to call from several threads with their own engines.
+  template <class E>
+  std::size_t sampleRow(std::size_t r, E &engine) const {
+    if (indexedTransitionModel[r].empty())
+      throw std::out_of_range("No transitions from the given state and action in the transition model");
+    return rowSamplers(r, engine);
   }
 
   /// @brief Get all possible states under the finite transation model
   std::unordered_set<StateType, typename StateType::Hash> getAllPossibleStates() const override {
     std::unordered_set<StateType, typename StateType::Hash> states;
-    for (const auto &t : transitionModel.transitions) {
-      states.emplace(t.first.state);
+    const auto &model = indexedTransitionModel;
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      if (model.hasTransitions(i))
+        states.emplace(model.states[i]);
     }
     return states;
   }
 
   std::unordered_set<ActionSpace, typename ActionSpace::Hash> getAllPossibleActions() const override {
     std::unordered_set<ActionSpace, typename ActionSpace::Hash> actions;
-    for (const auto &t : transitionModel.transitions) {
-      actions.emplace(t.first.action);
+    const auto &model = indexedTransitionModel;
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      for (std::size_t a = 0; a < model.nActions(); ++a) {
+        if (not model(i, a).empty())
+          actions.emplace(model.actions[a]);
+      }
     }
     return actions;
   }
+
+private:
+  /// @brief The alias tables over the successors of every row, aligned with
+  /// the entries of the indexed model.
+  rng::RowAliasTables<PrecisionType> rowSamplers =
+      rng::RowAliasTables<PrecisionType>(indexedTransitionModel.rowOffsets, indexedTransitionModel.probabilities);
+
+  /// @brief The indices of the actions with transitions out of state i are
+  /// reachableActionIndices[reachableActionOffsets[i], reachableActionOffsets[i + 1]).
+  std::vector<std::size_t> reachableActionOffsets = actionOffsets(indexedTransitionModel);
+  std::vector<std::size_t> reachableActionIndices = actionIndices(indexedTransitionModel);
+
+  static std::vector<std::size_t> actionOffsets(const IndexedTransitionModelType &model) {
+    auto offsets = std::vector<std::size_t>(model.nStates() + 1, 0);
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      offsets[i + 1] = offsets[i];
+      for (std::size_t a = 0; a < model.nActions(); ++a)
+        offsets[i + 1] += not model(i, a).empty();
+    }
+    return offsets;
+  }
+
+  static std::vector<std::size_t> actionIndices(const IndexedTransitionModelType &model) {
+    auto indices = std::vector<std::size_t>{};
+    for (std::size_t r = 0; r < model.nRows(); ++r) {
+      if (not model[r].empty())
+        indices.push_back(r % model.nActions());
+    }
+    return indices;
+  }
+
+  static IndexedTransitionModelType compile(const TransitionModel &t) {
+    return IndexedTransitionModelType(t.transitions, t.states, t.actions);
+  }
+
+  static TransitionModel spaces(const IndexedTransitionModelType &model) {
+    if (model.nStates() != nStates or model.nActions() != nActions)
+      throw std::invalid_argument("The model does not cover the state and action spaces of the environment");
+    auto t = TransitionModel{};
+    std::copy(model.states.begin(), model.states.end(), t.states.begin());
+    std::copy(model.actions.begin(), model.actions.end(), t.actions.begin());
+    return t;
+  }
 };
 
 template <typename ENVIRON_T>
@@ -0,0 +1,387 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "reinforce/reward.hpp"
+
+namespace environment {
+
+// A compressed sparse row (CSR) view of a finite transition model. Rows are
+// (state, action) pairs numbered stateIndex * nActions + actionIndex, and the
+// entries of a row are its successors. States and actions are numbered by
+// their position in the model's states and actions arrays. Successor indices,
+// probabilities and rewards are each stored contiguously so a Bellman backup
+// over a row is a linear scan with no hashing.
+//
+// The model is immutable once built. The arrays are spans over storage shared
+// by every copy of the model, either vectors filled by the compiling
+// constructor or a read only file mapping (see model_file.hpp), so copies are
+// cheap and a mapped model is never copied into memory.
+
+template <reward::RewardType REWARD_T>
+struct IndexedTransitionModel {
+
+  using RewardType = REWARD_T;
+  using StateType = typename RewardType::StateType;
+  using ActionSpace = typename RewardType::ActionSpace;
+  using TransitionType = typename RewardType::TransitionType;
+  using PrecisionType = typename RewardType::PrecisionType;
+  using IndexType = std::uint32_t;
+
+  constexpr static std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  /// @brief The successors of a single (state, action) pair.
+  struct Row {
+    std::span<const IndexType> successors;
+    std::span<const PrecisionType> probabilities;
+    std::span<const PrecisionType> rewards;
+
+    std::size_t size() const { return successors.size(); }
+    bool empty() const { return successors.empty(); }
+  };
+
+  std::vector<StateType> states;
+  std::vector<ActionSpace> actions;
+
+  /// @brief rowOffsets[r] is the first entry of row r. Has nRows() + 1 entries.
+  std::span<const std::size_t> rowOffsets;
+  std::span<const IndexType> successors;
+  std::span<const PrecisionType> probabilities;
+  /// @brief r(s, a, s') for every entry
+  std::span<const PrecisionType> rewards;
+  /// @brief sum_{s'} p(s'|s,a) r(s,a,s') for every row
+  std::span<const PrecisionType> expectedRewards;
+  /// @brief Non zero for every state whose transitions, if it has any, all
+  /// return to it with no reward. The solvers never back it up: a state
+  /// without transitions keeps its value, an absorbing one is set to zero.
+  std::span<const std::uint8_t> terminal;
+
+  /// @brief The CSR arrays of a model, as stored by an owner outside it.
+  struct Arrays {
+    std::span<const std::size_t> rowOffsets;
+    std::span<const IndexType> successors;
+    std::span<const PrecisionType> probabilities;
+    std::span<const PrecisionType> rewards;
+    std::span<const PrecisionType> expectedRewards;
+    std::span<const std::uint8_t> terminal;
+  };
+
+  IndexedTransitionModel() = default;
+
+  /**
+   * @brief Compile a transition model.
+   *
+   * @param transitions Map from (state, action, nextState) to probability
+   * @param stateSpace Every state, in index order
+   * @param actionSpace Every action, in index order
+   */
+  template <typename TRANSITIONS_T, typename STATES_T, typename ACTIONS_T>
+  IndexedTransitionModel(const TRANSITIONS_T &transitions, const STATES_T &stateSpace, const ACTIONS_T &actionSpace)
+      : states(stateSpace.begin(), stateSpace.end()), actions(actionSpace.begin(), actionSpace.end()) {
+
+    indexStatesAndActions();
+
+    auto owned = std::make_shared<OwnedArrays>();
+
+    // Counting sort the transitions into rows
+    owned->rowOffsets.assign(nRows() + 1, 0);
+    auto rowOfEntry = std::vector<std::size_t>{};
+    rowOfEntry.reserve(transitions.size());
+    for (const auto &[t, p] : transitions) {
+      const auto r = row(stateIndex(t.state), actionIndex(t.action));
+      rowOfEntry.push_back(r);
+      ++owned->rowOffsets[r + 1];
+    }
+    for (std::size_t r = 0; r < nRows(); ++r)
+      owned->rowOffsets[r + 1] += owned->rowOffsets[r];
+
+    owned->successors.resize(transitions.size());
+    owned->probabilities.resize(transitions.size());
+    owned->rewards.resize(transitions.size());
+    owned->expectedRewards.assign(nRows(), 0);
+
+    auto next = std::vector<std::size_t>(owned->rowOffsets.begin(), owned->rowOffsets.end() - 1);
+    std::size_t i = 0;
+    for (const auto &[t, p] : transitions) {
+      const auto r = rowOfEntry[i++];
+      const auto k = next[r]++;
+      owned->successors[k] = static_cast<IndexType>(stateIndex(t.nextState));
+      owned->probabilities[k] = p;
+      owned->rewards[k] = RewardType::reward(t);
+      owned->expectedRewards[r] += p * owned->rewards[k];
+    }
+    owned->terminal = terminalStates(owned->rowOffsets, owned->successors, owned->rewards, nActions());
+
+    const auto arrays = Arrays{
+        owned->rowOffsets,
+        owned->successors,
+        owned->probabilities,
+        owned->rewards,
+        owned->expectedRewards,
+        owned->terminal};
+    setArrays(arrays, std::move(owned));
+  }
+
+  /**
+   * @brief Adopt CSR arrays held by storage, which is kept alive for as long as
+   * any copy of the model exists.
+   *
+   * @throws std::invalid_argument When the array sizes do not describe a model
+   * over the given states and actions.
+   */
+  IndexedTransitionModel(
+      std::vector<StateType> stateSpace,
+      std::vector<ActionSpace> actionSpace,
+      const Arrays &arrays,
+      std::shared_ptr<const void> storage)
+      : states(std::move(stateSpace)), actions(std::move(actionSpace)) {
+    indexStatesAndActions();
+    const auto nEntries = arrays.successors.size();
+    if (arrays.rowOffsets.size() != nRows() + 1 or arrays.rowOffsets.front() != 0 or
+        arrays.rowOffsets.back() != nEntries or arrays.probabilities.size() != nEntries or
+        arrays.rewards.size() != nEntries or arrays.expectedRewards.size() != nRows() or
+        arrays.terminal.size() != nStates())
+      throw std::invalid_argument("Inconsistent arrays for an IndexedTransitionModel");
+    setArrays(arrays, std::move(storage));
+  }
+
+  std::size_t nStates() const { return states.size(); }
+  std::size_t nActions() const { return actions.size(); }
+  std::size_t nRows() const { return nStates() * nActions(); }
+  std::size_t nEntries() const { return successors.size(); }
+
+  /// @brief The index of a state or npos when it is not part of the model
+  std::size_t findState(const StateType &s) const {
+    const auto it = stateIndices.find(s);
+    return it == stateIndices.end() ? npos : it->second;
+  }
+  std::size_t findAction(const ActionSpace &a) const {
+    const auto it = actionIndices.find(a);
+    return it == actionIndices.end() ? npos : it->second;
+  }
+
+  std::size_t stateIndex(const StateType &s) const {
+    const auto i = findState(s);
+    if (i == npos)
+      throw std::out_of_range("State is not part of the transition model");
+    return i;
+  }
+  std::size_t actionIndex(const ActionSpace &a) const {
+    const auto i = findAction(a);
+    if (i == npos)
+      throw std::out_of_range("Action is not part of the transition model");
+    return i;
+  }
+
+  std::size_t row(std::size_t stateIdx, std::size_t actionIdx) const { return stateIdx * nActions() + actionIdx; }
+
+  Row operator[](std::size_t r) const {
+    const auto begin = rowOffsets[r];
+    const auto n = rowOffsets[r + 1] - begin;
+    return Row{successors.subspan(begin, n), probabilities.subspan(begin, n), rewards.subspan(begin, n)};
+  }
+  Row operator()(std::size_t stateIdx, std::size_t actionIdx) const { return (*this)[row(stateIdx, actionIdx)]; }
+
+  bool hasTransitions(std::size_t stateIdx) const {
+    return rowOffsets[row(stateIdx, 0)] != rowOffsets[row(stateIdx, 0) + nActions()];
+  }
+
+  /// @brief A terminal state with transitions, which only ever returns to
+  /// itself with no reward. Zero is its one value for a discount below one,
+  /// and the value that ends the episode there without discount.
+  bool isAbsorbing(std::size_t stateIdx) const { return terminal[stateIdx] and hasTransitions(stateIdx); }
+
+  /// @brief The terminal flag of every state of the given CSR arrays, for
+  /// whoever builds them.
+  static std::vector<std::uint8_t> terminalStates(
+      std::span<const std::size_t> rowOffsets,
+      std::span<const IndexType> successors,
+      std::span<const PrecisionType> rewards,
+      std::size_t nActions) {
+    const auto nStates = nActions == 0 ? 0 : (rowOffsets.size() - 1) / nActions;
+    auto result = std::vector<std::uint8_t>(nStates, 1);
+    for (std::size_t i = 0; i < nStates; ++i) {
+      for (auto k = rowOffsets[i * nActions]; k < rowOffsets[(i + 1) * nActions]; ++k) {
+        if (successors[k] != i or rewards[k] != 0) {
+          result[i] = 0;
+          break;
+        }
+      }
+    }
+    return result;
+  }
+
+  /// @brief The reverse adjacency of the model. For every state the distinct
+  /// states that have a transition into it, in ascending index order.
+  struct Predecessors {
+    std::vector<std::size_t> offsets;
+    std::vector<IndexType> states;
+
+    std::span<const IndexType> operator[](std::size_t stateIdx) const {
+      return std::span<const IndexType>(states).subspan(offsets[stateIdx], offsets[stateIdx + 1] - offsets[stateIdx]);
+    }
+  };
+
+  Predecessors predecessors() const {
+    // Visit sources in ascending order and drop repeats of the last source
+    // appended to each target so the lists come out sorted and distinct.
+    auto last = std::vector<std::size_t>(nStates(), npos);
+    auto count = std::vector<std::size_t>(nStates() + 1, 0);
+    for (std::size_t i = 0; i < nStates(); ++i) {
+      for (auto k = rowOffsets[row(i, 0)]; k < rowOffsets[row(i, 0) + nActions()]; ++k) {
+        if (std::exchange(last[successors[k]], i) != i)
+          ++count[successors[k] + 1];
+      }
+    }
+    for (std::size_t j = 0; j < nStates(); ++j)
+      count[j + 1] += count[j];
+
+    auto result = Predecessors{count, std::vector<IndexType>(count.back())};
+    std::fill(last.begin(), last.end(), npos);
+    for (std::size_t i = 0; i < nStates(); ++i) {
+      for (auto k = rowOffsets[row(i, 0)]; k < rowOffsets[row(i, 0) + nActions()]; ++k) {
+        if (std::exchange(last[successors[k]], i) != i)
+          result.states[count[successors[k]]++] = static_cast<IndexType>(i);
+      }
+    }
+    return result;
+  }
+
+  /// @brief Flags the states reachable from any of the start states, the
+  /// start states included, by a breadth first search over the entries with
+  /// non zero probability.
+  std::vector<std::uint8_t> reachable(std::span<const IndexType> starts) const {
+    auto result = std::vector<std::uint8_t>(nStates(), 0);
+    auto queue = std::vector<IndexType>{};
+    queue.reserve(nStates());
+    for (const auto i : starts) {
+      if (not std::exchange(result[i], 1))
+        queue.push_back(i);
+    }
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+      const auto i = queue[head];
+      for (auto k = rowOffsets[row(i, 0)]; k < rowOffsets[row(i, 0) + nActions()]; ++k) {
+        if (probabilities[k] > 0 and not std::exchange(result[successors[k]], 1))
+          queue.push_back(successors[k]);
+      }
+    }
+    return result;
+  }
+
+  /// @brief A partition of the states into strongly connected components of
+  /// the transition graph, listed in reverse topological order. Every
+  /// transition out of a component leads to a component listed before it.
+  struct Components {
+    std::vector<std::size_t> offsets;
+    std::vector<IndexType> states;
+
+    std::size_t size() const { return offsets.size() - 1; }
+    std::span<const IndexType> operator[](std::size_t c) const {
+      return std::span<const IndexType>(states).subspan(offsets[c], offsets[c + 1] - offsets[c]);
+    }
+  };
+
+  /**
+   * @brief The strongly connected components of the transition graph by
+   * Tarjan's algorithm.
+   *
+   * @details Tarjan's algorithm completes a component only after every
+   * component reachable from it, so they come out in reverse topological order
+   * as is. The depth first search keeps an explicit stack of (state, next
+   * entry) frames so long chains cannot overflow the call stack.
+   */
+  Components stronglyConnectedComponents() const {
+    auto result = Components{{0}, {}};
+    result.states.reserve(nStates());
+
+    auto index = std::vector<std::size_t>(nStates(), npos);
+    auto lowLink = std::vector<std::size_t>(nStates(), 0);
+    auto onStack = std::vector<bool>(nStates(), false);
+    auto stack = std::vector<IndexType>{};
+    auto frames = std::vector<std::pair<std::size_t, std::size_t>>{};
+    std::size_t nextIndex = 0;
+
+    auto visit = [&](std::size_t i) {
+      index[i] = lowLink[i] = nextIndex++;
+      stack.push_back(static_cast<IndexType>(i));
+      onStack[i] = true;
+      frames.emplace_back(i, rowOffsets[row(i, 0)]);
+    };
+
+    for (std::size_t root = 0; root < nStates(); ++root) {
+      if (index[root] != npos)
+        continue;
+      visit(root);
+      while (not frames.empty()) {
+        auto &[i, k] = frames.back();
+        const auto end = rowOffsets[row(i, 0) + nActions()];
+        if (k < end) {
+          const std::size_t j = successors[k++];
+          if (index[j] == npos)
+            visit(j);
+          else if (onStack[j])
+            lowLink[i] = std::min(lowLink[i], index[j]);
+          continue;
+        }
+
+        const auto done = i;
+        frames.pop_back();
+        if (not frames.empty())
+          lowLink[frames.back().first] = std::min(lowLink[frames.back().first], lowLink[done]);
+        if (lowLink[done] != index[done])
+          continue;
+        IndexType j;
+        do {
+          j = stack.back();
+          stack.pop_back();
+          onStack[j] = false;
+          result.states.push_back(j);
+        } while (j != done);
+        result.offsets.push_back(result.states.size());
+      }
+    }
+    return result;
+  }
+
+private:
+  struct OwnedArrays {
+    std::vector<std::size_t> rowOffsets;
+    std::vector<IndexType> successors;
+    std::vector<PrecisionType> probabilities;
+    std::vector<PrecisionType> rewards;
+    std::vector<PrecisionType> expectedRewards;
+    std::vector<std::uint8_t> terminal;
+  };
+
+  std::shared_ptr<const void> storage;
+  std::unordered_map<StateType, std::size_t, typename StateType::Hash> stateIndices;
+  std::unordered_map<ActionSpace, std::size_t, typename ActionSpace::Hash> actionIndices;
+
+  void indexStatesAndActions() {
+    if (states.size() > std::numeric_limits<IndexType>::max())
+      throw std::length_error("Too many states for an IndexedTransitionModel");
+    for (std::size_t i = 0; i < states.size(); ++i)
+      stateIndices.emplace(states[i], i);
+    for (std::size_t i = 0; i < actions.size(); ++i)
+      actionIndices.emplace(actions[i], i);
+  }
+
+  void setArrays(const Arrays &arrays, std::shared_ptr<const void> owner) {
+    rowOffsets = arrays.rowOffsets;
+    successors = arrays.successors;
+    probabilities = arrays.probabilities;
+    rewards = arrays.rewards;
+    expectedRewards = arrays.expectedRewards;
+    terminal = arrays.terminal;
+    storage = std::move(owner);
+  }
+};
+
+} // namespace environment
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "reinforce/markov_decision_process/policy_iteration.hpp"
+#include "reinforce/markov_decision_process/synchronous.hpp"
+#include "reinforce/utils/sparse_linear_solver.hpp"
+
+// Policy evaluation as a linear system. The value of a fixed policy satisfies
+//
+// \begin{equation} v_{\pi} = r_{\pi} + \gamma P_{\pi} v_{\pi} \iff (I - \gamma
+// P_{\pi}) v_{\pi} = r_{\pi} \end{equation}
+//
+// where P_{\pi}(s, s') = \sum_{a} \pi(a|s) p(s'|s,a) and r_{\pi}(s) is the
+// expected immediate reward under the policy. Iterative evaluation is a fixed
+// point iteration on this system whose error shrinks by a factor of gamma per
+// sweep, so with gamma close to 1 it takes thousands of sweeps. Solving the
+// system directly with a Krylov method costs a few dozen matrix products
+// independent of gamma, so policy iteration becomes a handful of solves.
+//
+// Modified policy iteration sits between the two. The policy is evaluated by
+// only k in place (Gauss-Seidel) sweeps over the assembled system before it is
+// improved again. k = 1 is value iteration under the current policy and large k
+// approaches exact policy iteration.
+//
+// Terminal states get the row v(s) = c. Terminal states without transitions
+// keep their current value as c, as in the sweeps of policy_iteration.hpp, and
+// absorbing states, which only return to themselves without reward, are worth
+// c = 0. Either way the system stays regular for gamma = 1 on them. Otherwise
+// for gamma = 1 the system is singular whenever the policy can loop forever, in
+// which case the solver throws.
+namespace markov_decision_process::linear_solve {
+
+/// @brief The system (I - gamma P_pi) v = r_pi over the states of the
+/// environments indexed transition model, in index order.
+struct PolicySystem {
+  utils::CsrMatrix<double> matrix;
+  std::vector<double> rewards;
+};
+
+/**
+ * @brief Assemble (I - gamma P_pi) and r_pi from the indexed transition model
+ * and the policy probabilities of every row.
+ *
+ * @details Successors reached through several actions are merged into a
+ * single entry of the row so the matrix has at most one entry per (s, s')
+ * pair, with the diagonal stored first.
+ *
+ * @param relevant The states whose rows are assembled, see relevant_states.
+ * The rows of the others are left as v = 0.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+PolicySystem assemble(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    const POLICY_T &policy,
+    const std::vector<std::uint8_t> &relevant) {
+
+  const auto &model = environment.indexedTransitionModel;
+  const double discountRate = valueFunction.discount_rate;
+  constexpr auto npos = std::numeric_limits<std::size_t>::max();
+
+  auto system = PolicySystem{};
+  auto &matrix = system.matrix;
+  system.rewards.assign(model.nStates(), 0.0);
+  matrix.rowOffsets.reserve(model.nStates() + 1);
+  matrix.columns.reserve(model.nStates() + model.nEntries());
+  matrix.values.reserve(model.nStates() + model.nEntries());
+
+  // The entry of each column in the row being assembled
+  auto slot = std::vector<std::size_t>(model.nStates(), npos);
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    const auto rowBegin = matrix.nEntries();
+    slot[i] = rowBegin;
+    matrix.addEntry(i, 1.0);
+
+    if (not relevant[i]) {
+      system.rewards[i] = 0.0;
+    } else if (model.terminal[i]) {
+      system.rewards[i] = model.isAbsorbing(i) ? 0.0 : valueFunction.valueAt(model.states[i]);
+    } else {
+      for (std::size_t a = 0; a < model.nActions(); ++a) {
+        const auto r = model.row(i, a);
+        const auto row = model[r];
+        if (row.empty())
+          continue;
+        const double probability = row_probability(policy, environment, i, a);
+        if (probability == 0.0)
+          continue;
+        system.rewards[i] += probability * model.expectedRewards[r];
+        for (std::size_t k = 0; k < row.size(); ++k) {
+          const auto j = row.successors[k];
+          const auto coefficient = -discountRate * probability * row.probabilities[k];
+          if (slot[j] == npos) {
+            slot[j] = matrix.nEntries();
+            matrix.addEntry(j, coefficient);
+          } else {
+            matrix.values[slot[j]] += coefficient;
+          }
+        }
+      }
+    }
+
+    for (auto k = rowBegin; k < matrix.nEntries(); ++k)
+      slot[matrix.columns[k]] = npos;
+    matrix.endRow();
+  }
+  return system;
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+PolicySystem assemble(
+    VALUE_FUNCTION_T &valueFunction, const typename POLICY_T::EnvironmentType &environment, const POLICY_T &policy) {
+  return assemble(valueFunction, environment, policy, relevant_states(environment));
+}
+
+namespace detail {
+
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+std::vector<double> gather_values(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const std::vector<std::uint8_t> &relevant) {
+  const auto values = synchronous::gather_values(valueFunction, environment, relevant);
+  return std::vector<double>(values.begin(), values.end());
+}
+
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+void scatter_values(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const std::vector<double> &values,
+    const std::vector<std::uint8_t> &relevant) {
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+  synchronous::scatter_values(
+      valueFunction, environment, std::vector<PrecisionType>(values.begin(), values.end()), relevant);
+}
+
+} // namespace detail
+
+/**
+ * @brief Evaluate the policy exactly by solving (I - gamma P_pi) v = r_pi.
+ *
+ * @details The current value function is the initial guess, so within policy
+ * iteration each solve starts from the values of the previous policy.
+ *
+ * @param epsilon The largest Bellman residual |r_pi + gamma P_pi v - v|
+ * accepted at any state. The error in v is then at most epsilon / (1 - gamma).
+ * @param relevant The states to evaluate, see relevant_states.
+ * @return The iterations and final residual of the solve.
+ * @throws std::runtime_error When the solve does not converge.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+utils::LinearSolveResult policy_evaluation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const std::vector<std::uint8_t> &relevant,
+    std::size_t maxIterations = 1000) {
+
+  assert(epsilon > 0.0F);
+
+  const auto system = assemble(valueFunction, environment, policy, relevant);
+  auto values = detail::gather_values(valueFunction, environment, relevant);
+  const auto result =
+      utils::bicgstab(system.matrix, system.rewards, values, static_cast<double>(epsilon), maxIterations);
+  detail::scatter_values(valueFunction, environment, values, relevant);
+  return result;
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+utils::LinearSolveResult policy_evaluation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    std::size_t maxIterations = 1000) {
+  return policy_evaluation(valueFunction, environment, policy, epsilon, relevant_states(environment), maxIterations);
+}
+
+/**
+ * @brief Approximately evaluate the policy by a fixed number of in place
+ * sweeps over the assembled system.
+ *
+ * @param relevant The states to evaluate, see relevant_states.
+ * @return The largest change of any state value in the last sweep.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+typename VALUE_FUNCTION_T::PrecisionType modified_policy_evaluation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    std::size_t nSweeps,
+    const std::vector<std::uint8_t> &relevant) {
+
+  const auto system = assemble(valueFunction, environment, policy, relevant);
+  const auto &matrix = system.matrix;
+  auto values = detail::gather_values(valueFunction, environment, relevant);
+
+  // Each row stores its diagonal first
+  double delta = 0.0;
+  for (std::size_t sweep = 0; sweep < nSweeps; ++sweep) {
+    delta = 0.0;
+    for (std::size_t i = 0; i < matrix.size(); ++i) {
+      const auto begin = matrix.rowOffsets[i];
+      const auto diagonal = matrix.values[begin];
+      if (diagonal == 0.0)
+        continue;
+      auto value = system.rewards[i];
+      for (auto k = begin + 1; k < matrix.rowOffsets[i + 1]; ++k)
+        value -= matrix.values[k] * values[matrix.columns[k]];
+      value /= diagonal;
+      delta = std::max(delta, std::abs(value - values[i]));
+      values[i] = value;
+    }
+  }
+  detail::scatter_values(valueFunction, environment, values, relevant);
+  return static_cast<typename VALUE_FUNCTION_T::PrecisionType>(delta);
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+typename VALUE_FUNCTION_T::PrecisionType modified_policy_evaluation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    std::size_t nSweeps) {
+  return modified_policy_evaluation(valueFunction, environment, policy, nSweeps, relevant_states(environment));
+}
+
+/**
+ * @brief Policy iteration where every evaluation is an exact linear solve.
+ *
+ * @return The number of policy evaluations (linear solves) performed.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+std::size_t policy_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+
+  std::size_t evaluations = 0;
+  bool policyStable = true;
+  const auto relevant = relevant_states(environment);
+  do {
+    policy_evaluation(valueFunction, environment, policy, epsilon, relevant);
+    ++evaluations;
+    policyStable = markov_decision_process::policy_improvement(valueFunction, environment, policy, relevant);
+  } while (not policyStable);
+  return evaluations;
+}
+
+/**
+ * @brief Modified policy iteration. Alternate nSweeps sweeps of evaluation
+ * with policy improvement.
+ *
+ * @details Stops once the policy is stable and the last sweep changed no value
+ * by more than epsilon. A stable policy alone is not enough since with few
+ * sweeps the values may still be far from those of the policy.
+ *
+ * @return The number of improvement steps performed.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+std::size_t modified_policy_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    std::size_t nSweeps,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+
+  assert(nSweeps > 0);
+  assert(epsilon > 0.0F);
+
+  std::size_t improvements = 0;
+  bool converged = true;
+  const auto relevant = relevant_states(environment);
+  do {
+    const auto delta = modified_policy_evaluation(valueFunction, environment, policy, nSweeps, relevant);
+    const auto policyStable =
+        markov_decision_process::policy_improvement(valueFunction, environment, policy, relevant);
+    ++improvements;
+    converged = policyStable and delta <= epsilon;
+  } while (not converged);
+  return improvements;
+}
+
+} // namespace markov_decision_process::linear_solve
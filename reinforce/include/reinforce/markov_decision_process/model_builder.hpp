@@ -0,0 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "reinforce/markov_decision_process/indexed_transition_model.hpp"
+
+namespace environment {
+
+struct ModelBuilderOptions {
+  /// @brief The number of transitions held in memory before a sorted run is
+  /// spilled to disk. Also bounds the read buffers of the final merge.
+  std::size_t chunkSize = std::size_t(1) << 22;
+  /// @brief Where the sorted runs are spilled.
+  std::filesystem::path directory = std::filesystem::temp_directory_path();
+  /// @brief How far the probabilities of a (state, action) pair may sum from 1.
+  double tolerance = 1e-4;
+};
+
+/**
+ * @brief Build an IndexedTransitionModel from a stream of indexed transitions
+ * in bounded memory.
+ *
+ * @details Transitions are given as (state index, action index, next state
+ * index, probability, reward) in any order, with indices into the states and
+ * actions passed to the constructor. No transition or state objects are
+ * created. They are buffered chunkSize at a time, and each full buffer is
+ * sorted by (row, successor) and written to a temporary file as a run. build()
+ * merges the runs, combines repeated (s, a, s') entries by adding their
+ * probabilities (their reward becomes the probability weighted mean, which
+ * keeps r(s, a) unchanged), checks that the probabilities of every (s, a) sum
+ * to one and writes the CSR arrays and terminal flags. Peak memory is the
+ * chunk plus the output model, however many transitions are added.
+ *
+ * Runs are removed by build() and by the destructor.
+ */
+template <reward::RewardType REWARD_T>
+class IndexedTransitionModelBuilder {
+public:
+  using ModelType = IndexedTransitionModel<REWARD_T>;
+  using StateType = typename ModelType::StateType;
+  using ActionSpace = typename ModelType::ActionSpace;
+  using PrecisionType = typename ModelType::PrecisionType;
+  using IndexType = typename ModelType::IndexType;
+
+  IndexedTransitionModelBuilder(
+      std::vector<StateType> stateSpace,
+      std::vector<ActionSpace> actionSpace,
+      ModelBuilderOptions options = {})
+      : states(std::move(stateSpace)), actions(std::move(actionSpace)), options(std::move(options)) {
+    if (states.size() > std::numeric_limits<IndexType>::max())
+      throw std::length_error("Too many states for an IndexedTransitionModel");
+    if (this->options.chunkSize == 0)
+      throw std::invalid_argument("The chunk size of a model builder must be positive");
+    buffer.reserve(this->options.chunkSize);
+  }
+
+  IndexedTransitionModelBuilder(const IndexedTransitionModelBuilder &) = delete;
+  IndexedTransitionModelBuilder &operator=(const IndexedTransitionModelBuilder &) = delete;
+
+  ~IndexedTransitionModelBuilder() { removeRuns(); }
+
+  /**
+   * @brief Add p(nextState | state, action) with reward r(state, action,
+   * nextState).
+   *
+   * @throws std::out_of_range When an index is outside the state or action
+   * space.
+   * @throws std::invalid_argument When the probability is not in [0, 1].
+   */
+  void add(
+      std::size_t state,
+      std::size_t action,
+      std::size_t nextState,
+      PrecisionType probability,
+      PrecisionType reward) {
+    if (state >= states.size() or nextState >= states.size() or action >= actions.size())
+      throw std::out_of_range("Transition index outside the state or action space");
+    if (not(probability >= 0 and probability <= 1))
+      throw std::invalid_argument("Transition probability must be in [0, 1]");
+
+    buffer.push_back(Entry{state * actions.size() + action, static_cast<IndexType>(nextState), probability, reward});
+    ++nAdded;
+    if (buffer.size() == options.chunkSize)
+      spill();
+  }
+
+  std::size_t size() const { return nAdded; }
+  /// @brief The number of sorted runs spilled to disk so far.
+  std::size_t nRuns() const { return runs.size(); }
+
+  /**
+   * @brief Merge everything added into a model. The builder is empty
+   * afterwards.
+   *
+   * @throws std::invalid_argument When the probabilities of some (state,
+   * action) pair do not sum to one.
+   */
+  ModelType build() {
+    auto owned = std::make_shared<OwnedArrays>();
+    owned->rowOffsets.assign(nRows() + 1, 0);
+    owned->expectedRewards.assign(nRows(), 0);
+
+    auto output = Output{*owned, options.tolerance};
+    if (runs.empty()) {
+      sortBuffer();
+      for (const auto &e : buffer)
+        output.push(e);
+    } else {
+      if (not buffer.empty())
+        spill();
+      merge(output);
+    }
+    output.finish();
+    owned->terminal = ModelType::terminalStates(owned->rowOffsets, owned->successors, owned->rewards, actions.size());
+
+    buffer.clear();
+    removeRuns();
+    nAdded = 0;
+
+    const auto arrays = typename ModelType::Arrays{
+        owned->rowOffsets,
+        owned->successors,
+        owned->probabilities,
+        owned->rewards,
+        owned->expectedRewards,
+        owned->terminal};
+    return ModelType(states, actions, arrays, std::move(owned));
+  }
+
+private:
+  struct Entry {
+    std::uint64_t row;
+    IndexType successor;
+    PrecisionType probability;
+    PrecisionType reward;
+
+    friend bool operator<(const Entry &lhs, const Entry &rhs) {
+      return std::tie(lhs.row, lhs.successor) < std::tie(rhs.row, rhs.successor);
+    }
+  };
+
+  struct OwnedArrays {
+    std::vector<std::size_t> rowOffsets;
+    std::vector<IndexType> successors;
+    std::vector<PrecisionType> probabilities;
+    std::vector<PrecisionType> rewards;
+    std::vector<PrecisionType> expectedRewards;
+    std::vector<std::uint8_t> terminal;
+  };
+
+  /// @brief Appends sorted entries to the CSR arrays, combining repeats and
+  /// checking each row once it is complete.
+  struct Output {
+    OwnedArrays &arrays;
+    double tolerance;
+    std::uint64_t row = 0;
+    bool open = false;
+    // Offsets from this index on are not written yet
+    std::size_t nextOffset = 1;
+
+    void push(const Entry &e) {
+      if (open and e.row == row and e.successor == arrays.successors.back()) {
+        auto &p = arrays.probabilities.back();
+        auto &r = arrays.rewards.back();
+        const auto total = p + e.probability;
+        r = total > 0 ? (p * r + e.probability * e.reward) / total : r;
+        p = total;
+      } else {
+        if (open and e.row != row)
+          closeRow();
+        row = e.row;
+        open = true;
+        // The empty rows since the last one closed start and end here
+        fillOffsets(row + 1);
+        arrays.successors.push_back(e.successor);
+        arrays.probabilities.push_back(e.probability);
+        arrays.rewards.push_back(e.reward);
+      }
+    }
+
+    void closeRow() {
+      // The row runs from its offset, set when it was opened, to the end
+      const auto begin = arrays.rowOffsets[row];
+      double rowTotal = 0;
+      PrecisionType expected = 0;
+      for (auto k = begin; k < arrays.successors.size(); ++k) {
+        rowTotal += arrays.probabilities[k];
+        expected += arrays.probabilities[k] * arrays.rewards[k];
+      }
+      if (std::abs(rowTotal - 1.0) > tolerance)
+        throw std::invalid_argument(
+            "Transition probabilities of row " + std::to_string(row) + " sum to " + std::to_string(rowTotal));
+      arrays.expectedRewards[row] = expected;
+      open = false;
+    }
+
+    void finish() {
+      if (open)
+        closeRow();
+      fillOffsets(arrays.rowOffsets.size());
+    }
+
+    /// @brief Set the offsets before index end that are not written yet to
+    /// the current end of the entries.
+    void fillOffsets(std::size_t end) {
+      std::fill(arrays.rowOffsets.begin() + nextOffset, arrays.rowOffsets.begin() + end, arrays.successors.size());
+      nextOffset = end;
+    }
+  };
+
+  std::vector<StateType> states;
+  std::vector<ActionSpace> actions;
+  ModelBuilderOptions options;
+  std::vector<Entry> buffer;
+  std::vector<std::filesystem::path> runs;
+  std::string runPrefix;
+  std::size_t nAdded = 0;
+
+  std::size_t nRows() const { return states.size() * actions.size(); }
+
+  void sortBuffer() { std::sort(buffer.begin(), buffer.end()); }
+
+  void spill() {
+    sortBuffer();
+    auto path = options.directory / runName(runs.size());
+    auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    out.write(
+        reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(Entry)));
+    if (not out.flush())
+      throw std::runtime_error("Failed writing model builder run " + path.string());
+    runs.push_back(std::move(path));
+    buffer.clear();
+  }
+
+  std::string runName(std::size_t run) {
+    if (runPrefix.empty()) {
+      auto device = std::random_device();
+      runPrefix = "reinforce_model_builder_" + std::to_string(device()) + std::to_string(device());
+    }
+    return runPrefix + "_" + std::to_string(run) + ".run";
+  }
+
+  /// @brief A sorted run read back through a fixed size buffer.
+  struct RunReader {
+    std::ifstream in;
+    std::vector<Entry> block;
+    std::size_t next = 0;
+
+    RunReader(const std::filesystem::path &path, std::size_t blockSize) : in(path, std::ios::binary) {
+      block.reserve(blockSize);
+      if (not in)
+        throw std::runtime_error("Cannot read model builder run " + path.string());
+    }
+
+    bool refill() {
+      block.resize(block.capacity());
+      in.read(reinterpret_cast<char *>(block.data()), static_cast<std::streamsize>(block.size() * sizeof(Entry)));
+      block.resize(static_cast<std::size_t>(in.gcount()) / sizeof(Entry));
+      next = 0;
+      return not block.empty();
+    }
+
+    bool empty() { return next == block.size() and not refill(); }
+    const Entry &peek() const { return block[next]; }
+    void pop() { ++next; }
+  };
+
+  void merge(Output &output) {
+    // The chunk is no longer needed, its memory goes to the read buffers
+    buffer = std::vector<Entry>();
+    const auto blockSize = std::max<std::size_t>(1, options.chunkSize / runs.size());
+    auto readers = std::vector<RunReader>();
+    readers.reserve(runs.size());
+    for (const auto &path : runs)
+      readers.emplace_back(path, blockSize);
+
+    using Head = std::pair<Entry, std::size_t>;
+    auto later = [](const Head &lhs, const Head &rhs) { return rhs.first < lhs.first; };
+    auto heads = std::priority_queue<Head, std::vector<Head>, decltype(later)>(later);
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+      if (not readers[i].empty())
+        heads.emplace(readers[i].peek(), i);
+    }
+    while (not heads.empty()) {
+      const auto [entry, i] = heads.top();
+      heads.pop();
+      output.push(entry);
+      readers[i].pop();
+      if (not readers[i].empty())
+        heads.emplace(readers[i].peek(), i);
+    }
+  }
+
+  void removeRuns() {
+    auto error = std::error_code();
+    for (const auto &path : runs)
+      std::filesystem::remove(path, error);
+    runs.clear();
+  }
+};
+
+} // namespace environment
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "reinforce/markov_decision_process/finite_transition_model.hpp"
+#include "reinforce/markov_decision_process/indexed_transition_model.hpp"
+#include "reinforce/spec.hpp"
+#include "reinforce/utils/mapped_file.hpp"
+
+// A binary file format for compiled finite MDPs that is read by mapping it
+// into memory. The file is a fixed header followed by one section per array of
+// the IndexedTransitionModel:
+//
+//   states           uint64 spec index of the observable of every state
+//   actions          uint64 spec index of every action
+//   rowOffsets       uint64 CSR row offsets, nStates * nActions + 1
+//   successors       uint32 successor state index of every entry
+//   probabilities    P      probability of every entry
+//   rewards          P      r(s, a, s') of every entry
+//   expectedRewards  P      sum_{s'} p(s'|s,a) r(s,a,s') of every row
+//   terminal         uint8  terminal flag of every state
+//
+// where P is the precision of the reward type. Every section starts on a 64
+// byte boundary so the arrays can be used in place, and everything is in the
+// byte order of the machine that wrote it, which the header records.
+//
+// Reading maps the file and points the model straight at the sections, so no
+// transition data is copied and the pages are shared through the page cache
+// by every process that opens the same file. Only the state and action objects
+// are decoded from their spec indices, since they are not plain data.
+namespace environment::model_file {
+
+constexpr std::array<char, 8> magic = {'R', 'E', 'I', 'N', 'F', 'M', 'D', 'P'};
+constexpr std::uint32_t version = 2;
+constexpr std::uint64_t byteOrderMark = 0x0102030405060708ULL;
+constexpr std::size_t alignment = 64;
+
+/// @brief How much of a model file read checks.
+enum class Validation {
+  /// The header, the section bounds and the row offsets at either end, for
+  /// files from a trusted writer. The cost does not grow with the model.
+  sections,
+  /// As well, that the row offsets never decrease and that every successor is
+  /// a state of the model. One pass over the rows and entries.
+  entries,
+};
+
+struct Section {
+  std::uint64_t offset;
+  /// @brief The number of elements, not bytes
+  std::uint64_t count;
+};
+
+struct Header {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t precisionBytes;
+  std::uint64_t byteOrder;
+  std::uint64_t nStates;
+  std::uint64_t nActions;
+  std::uint64_t nEntries;
+  Section states;
+  Section actions;
+  Section rowOffsets;
+  Section successors;
+  Section probabilities;
+  Section rewards;
+  Section expectedRewards;
+  Section terminal;
+};
+
+static_assert(std::is_trivially_copyable_v<Header>);
+static_assert(sizeof(std::size_t) == sizeof(std::uint64_t), "Row offsets are stored as 64 bit");
+
+namespace detail {
+
+inline std::uint64_t align(std::uint64_t offset) { return (offset + alignment - 1) / alignment * alignment; }
+
+template <typename T>
+void writeSection(std::ofstream &out, Section &section, std::span<const T> data) {
+  const auto at = static_cast<std::uint64_t>(out.tellp());
+  const auto padding = std::vector<char>(align(at) - at, 0);
+  out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+  section = Section{align(at), data.size()};
+  out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size_bytes()));
+}
+
+template <typename T>
+std::span<const T> readSection(const utils::MappedFile &file, const Section &section, std::uint64_t expectedCount) {
+  if (section.count != expectedCount or section.offset % alignment != 0 or section.offset > file.size() or
+      section.count > (file.size() - section.offset) / sizeof(T))
+    throw std::runtime_error("Malformed MDP model file section");
+  return std::span<const T>(reinterpret_cast<const T *>(file.data() + section.offset), section.count);
+}
+
+/// @brief True when the row offsets never decrease and every successor is
+/// below nStates. The ends of the offsets are checked by the model.
+template <typename ARRAYS_T>
+bool validEntries(const ARRAYS_T &arrays, std::uint64_t nStates) {
+  const auto &offsets = arrays.rowOffsets;
+  if (std::adjacent_find(offsets.begin(), offsets.end(), std::greater<>()) != offsets.end())
+    return false;
+  return std::all_of(arrays.successors.begin(), arrays.successors.end(), [&](auto k) { return k < nStates; });
+}
+
+} // namespace detail
+
+/**
+ * @brief Write a compiled model to path, replacing any existing file.
+ *
+ * @throws std::runtime_error When the file cannot be written.
+ */
+template <reward::RewardType REWARD_T>
+void write(const std::filesystem::path &path, const IndexedTransitionModel<REWARD_T> &model) {
+  using ModelType = IndexedTransitionModel<REWARD_T>;
+  using StateType = typename ModelType::StateType;
+  using ActionSpace = typename ModelType::ActionSpace;
+
+  auto stateIndices = std::vector<std::uint64_t>(model.nStates());
+  for (std::size_t i = 0; i < model.nStates(); ++i)
+    stateIndices[i] = spec::toIndex<typename StateType::ObservableSpecType>(model.states[i].observable);
+  auto actionIndices = std::vector<std::uint64_t>(model.nActions());
+  for (std::size_t a = 0; a < model.nActions(); ++a)
+    actionIndices[a] = spec::toIndex<typename ActionSpace::SpecType>(model.actions[a]);
+
+  auto header = Header{};
+  header.magic = magic;
+  header.version = version;
+  header.precisionBytes = sizeof(typename ModelType::PrecisionType);
+  header.byteOrder = byteOrderMark;
+  header.nStates = model.nStates();
+  header.nActions = model.nActions();
+  header.nEntries = model.nEntries();
+
+  auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+  if (not out)
+    throw std::runtime_error("Cannot open " + path.string() + " for writing");
+
+  // The header is written twice, the second time with the section offsets
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  detail::writeSection(out, header.states, std::span<const std::uint64_t>(stateIndices));
+  detail::writeSection(out, header.actions, std::span<const std::uint64_t>(actionIndices));
+  detail::writeSection(out, header.rowOffsets, model.rowOffsets);
+  detail::writeSection(out, header.successors, model.successors);
+  detail::writeSection(out, header.probabilities, model.probabilities);
+  detail::writeSection(out, header.rewards, model.rewards);
+  detail::writeSection(out, header.expectedRewards, model.expectedRewards);
+  detail::writeSection(out, header.terminal, model.terminal);
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  if (not out.flush())
+    throw std::runtime_error("Failed writing " + path.string());
+}
+
+/**
+ * @brief Map a model file and build a model that reads its arrays in place.
+ *
+ * @details The header, the section bounds and the row offsets at either end
+ * are always checked. By default so are the row offsets in between and the
+ * successor indices, which is linear in the size of the model; with
+ * Validation::sections they are trusted, and a successor index out of range
+ * is undefined behaviour just as for a corrupt in memory model. The
+ * probabilities and rewards are never checked.
+ *
+ * @throws std::system_error When the file cannot be mapped.
+ * @throws std::runtime_error When it is not a model file of this version and
+ * precision, or its states and actions do not fit the specs of REWARD_T.
+ */
+template <reward::RewardType REWARD_T>
+IndexedTransitionModel<REWARD_T>
+read(const std::filesystem::path &path, Validation validation = Validation::entries) {
+  using ModelType = IndexedTransitionModel<REWARD_T>;
+  using StateType = typename ModelType::StateType;
+  using ActionSpace = typename ModelType::ActionSpace;
+  using PrecisionType = typename ModelType::PrecisionType;
+  using ObservableSpecType = typename StateType::ObservableSpecType;
+  using ActionSpecType = typename ActionSpace::SpecType;
+
+  auto file = std::make_shared<const utils::MappedFile>(path);
+
+  auto header = Header{};
+  if (file->size() < sizeof(Header))
+    throw std::runtime_error(path.string() + " is too small to be an MDP model file");
+  std::memcpy(&header, file->data(), sizeof(Header));
+  if (header.magic != magic)
+    throw std::runtime_error(path.string() + " is not an MDP model file");
+  if (header.byteOrder != byteOrderMark)
+    throw std::runtime_error(path.string() + " was written with a different byte order");
+  if (header.version != version)
+    throw std::runtime_error(path.string() + " has an unsupported MDP model file version");
+  if (header.precisionBytes != sizeof(PrecisionType))
+    throw std::runtime_error(path.string() + " was written with a different precision");
+
+  const auto nRows = header.nStates * header.nActions;
+  const auto stateIndices = detail::readSection<std::uint64_t>(*file, header.states, header.nStates);
+  const auto actionIndices = detail::readSection<std::uint64_t>(*file, header.actions, header.nActions);
+  const auto arrays = typename ModelType::Arrays{
+      detail::readSection<std::size_t>(*file, header.rowOffsets, nRows + 1),
+      detail::readSection<typename ModelType::IndexType>(*file, header.successors, header.nEntries),
+      detail::readSection<PrecisionType>(*file, header.probabilities, header.nEntries),
+      detail::readSection<PrecisionType>(*file, header.rewards, header.nEntries),
+      detail::readSection<PrecisionType>(*file, header.expectedRewards, nRows),
+      detail::readSection<std::uint8_t>(*file, header.terminal, header.nStates)};
+  if (validation == Validation::entries and not detail::validEntries(arrays, header.nStates))
+    throw std::runtime_error(path.string() + " has a row offset or successor out of range");
+
+  auto states = std::vector<StateType>();
+  states.reserve(header.nStates);
+  for (const auto i : stateIndices) {
+    if (i >= spec::nSpecValues<ObservableSpecType>())
+      throw std::runtime_error(path.string() + " has a state outside the state spec");
+    states.push_back(StateType{spec::fromIndex<ObservableSpecType>(i), {}});
+  }
+  auto actions = std::vector<ActionSpace>();
+  actions.reserve(header.nActions);
+  for (const auto a : actionIndices) {
+    if (a >= spec::nSpecValues<ActionSpecType>())
+      throw std::runtime_error(path.string() + " has an action outside the action spec");
+    actions.push_back(ActionSpace{spec::fromIndex<ActionSpecType>(a)});
+  }
+
+  try {
+    return ModelType(std::move(states), std::move(actions), arrays, std::move(file));
+  } catch (const std::invalid_argument &e) {
+    throw std::runtime_error(path.string() + ": " + e.what());
+  }
+}
+
+} // namespace environment::model_file
+
+namespace environment {
+
+/**
+ * @brief A Markov decision environment served from a model file.
+ *
+ * @details Every query and every step is answered from the mapped arrays, see
+ * model_file::read. The transition map of the base class is left empty. Any
+ * environment that inherits the constructors of MarkovDecisionEnvironment can
+ * be built from model_file::read in the same way; this one is for when there
+ * is no concrete environment type to hand.
+ */
+template <StepType STEP_T, RewardType REWARD_T, ReturnType RETURN_T>
+struct MappedMarkovDecisionEnvironment : MarkovDecisionEnvironment<STEP_T, REWARD_T, RETURN_T> {
+
+  SETUP_TYPES(SINGLE_ARG(MarkovDecisionEnvironment<STEP_T, REWARD_T, RETURN_T>));
+
+  explicit MappedMarkovDecisionEnvironment(const std::filesystem::path &path)
+      : MappedMarkovDecisionEnvironment(path, StateType{}) {}
+  MappedMarkovDecisionEnvironment(const std::filesystem::path &path, const StateType &initialState)
+      : BaseType(model_file::read<REWARD_T>(path), initialState), initialState(initialState) {}
+
+  StateType reset() override {
+    this->state = initialState;
+    return this->state;
+  }
+  StateType getNullState() const override { return initialState; }
+
+private:
+  StateType initialState;
+};
+
+} // namespace environment
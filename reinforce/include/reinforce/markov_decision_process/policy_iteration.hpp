@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <unordered_map>
+#include <vector>
 
 #include "reinforce/environment.hpp"
 #include "reinforce/markov_decision_process/finite_transition_model.hpp"
 #include "reinforce/policy/distribution_policy.hpp"
+#include "reinforce/policy/finite/deterministic_policy.hpp"
 #include "reinforce/policy/objectives/finite_value_function.hpp"
 #include "reinforce/policy/value.hpp"
+#include "reinforce/reachability.hpp"
 
 // The key concept for MDPs is that the best policy can always be determined
 // by looking at the value for each state. This is because whenever we find
@@ -18,6 +22,71 @@
 // in state s) is KNOWN.
 namespace markov_decision_process {
 
+/**
+ * @brief Flags the states of the indexed model that matter to the solvers.
+ *
+ * @details When the environment declares its initial states (see
+ * reachability.hpp) these are the states reachable from them. Otherwise every
+ * state. The sweeps back up only these, less the terminal ones, and only read
+ * or write their values, so no value entries are made for the others.
+ *
+ * Finding them is a search over the model, so a solve computes them once and
+ * passes them to every pass it makes. Each solver also has an overload taking
+ * them, for callers that solve the same environment repeatedly.
+ */
+template <typename ENVIRONMENT_T>
+std::vector<std::uint8_t> relevant_states(const ENVIRONMENT_T &environment) {
+  const auto &model = environment.indexedTransitionModel;
+  if constexpr (environment::InitialStateEnvironment<ENVIRONMENT_T>) {
+    auto starts = std::vector<typename ENVIRONMENT_T::IndexedTransitionModelType::IndexType>();
+    for (const auto &state : environment.getInitialStates())
+      starts.push_back(model.stateIndex(state));
+    return model.reachable(starts);
+  } else {
+    return std::vector<std::uint8_t>(model.nStates(), 1);
+  }
+}
+
+/// @brief Write zero into every relevant absorbing state (see
+/// IndexedTransitionModel::isAbsorbing). The sweeps skip terminal states.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+void zero_absorbing_states(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const std::vector<std::uint8_t> &relevant) {
+  const auto &model = environment.indexedTransitionModel;
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    if (relevant[i] and model.isAbsorbing(i)) {
+      valueFunction.valueAt(model.states[i]);
+      valueFunction.at(model.states[i]).value = 0.0F;
+    }
+  }
+}
+
+/**
+ * @brief The expected future value of a single row (state, action pair) of
+ * the environments indexed transition model.
+ *
+ * @details The expected immediate reward of the row is precomputed so this is
+ * \begin{equation} \sum_{s'} p(s'|s,a) r(s,a,s') + gamma * \sum_{s'} p(s'|s,a)
+ * V(s') \end{equation} as a single scan over the successors of the row.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+typename VALUE_FUNCTION_T::PrecisionType value_from_row(
+    const VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    std::size_t r) {
+
+  const auto &model = environment.indexedTransitionModel;
+  const auto row = model[r];
+  typename VALUE_FUNCTION_T::PrecisionType nextValue = 0.0F;
+  for (std::size_t k = 0; k < row.size(); ++k) {
+    const auto &nextState = model.states[row.successors[k]];
+    nextValue += row.probabilities[k] * valueFunction.valueAtOrInitial(nextState);
+  }
+  return model.expectedRewards[r] + valueFunction.discount_rate * nextValue;
+}
+
 /**
  * @brief The exected future Value funciton for a given state under a
  * determined action.
@@ -40,28 +109,66 @@ namespace markov_decision_process {
  */
 template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
 typename VALUE_FUNCTION_T::PrecisionType value_from_state_action(
-    VALUE_FUNCTION_T &valueFunction,
+    const VALUE_FUNCTION_T &valueFunction,
     const typename VALUE_FUNCTION_T::EnvironmentType &environment,
     const typename VALUE_FUNCTION_T::EnvironmentType::StateType &state,
     const typename VALUE_FUNCTION_T::EnvironmentType::ActionSpace &action) {
 
-  SETUP_TYPES_W_VALUE_FUNCTION(VALUE_FUNCTION_T);
-
-  const auto &transitionModel = environment.transitionModel;
-
-  auto reachableStates = environment.getReachableStates(state, action);
-  return std::accumulate(
-      reachableStates.begin(), reachableStates.end(), 0.0F, [&](const auto &value, const auto &nextState) {
-        auto transition = TransitionType{state, action, nextState};
+  const auto &model = environment.indexedTransitionModel;
+  const auto i = model.findState(state);
+  const auto j = model.findAction(action);
+  if (i == model.npos or j == model.npos)
+    return 0.0F;
+  return value_from_row(valueFunction, environment, model.row(i, j));
+}
 
-        if (transitionModel.transitions.find(transition) == transitionModel.transitions.end())
-          return value;
+/**
+ * @brief The probability pi(a|s) the policy takes action index a in state
+ * index i of the environments indexed transition model.
+ *
+ * @details A deterministic policy is answered from its action array, any other
+ * policy is asked for the probability of the corresponding state and action.
+ */
+template <policy::isDistributionPolicy POLICY_T>
+typename POLICY_T::PrecisionType row_probability(
+    const POLICY_T &policy, const typename POLICY_T::EnvironmentType &environment, std::size_t i, std::size_t a) {
+  if constexpr (policy::isDeterministicPolicy<POLICY_T>) {
+    return policy.actionIndex(i) == a ? 1.0F : 0.0F;
+  } else {
+    const auto &model = environment.indexedTransitionModel;
+    return policy.getProbability(environment, model.states[i], model.actions[a]);
+  }
+}
 
-        return value + transitionModel.transitions.at(transition) *
-                           (RewardType::reward(transition) +
-                            valueFunction.discount_rate *
-                                valueFunction.emplace(nextState, valueFunction.initial_value).first->second.value);
-      });
+/**
+ * @brief The action the policy currently favours in the state with index i of
+ * the environments indexed transition model: the most probable action with
+ * transitions out of the state, the lowest index on ties, or nActions when
+ * the policy gives them all probability zero.
+ *
+ * @details Only the rows of the state are read, so this is safe to call for
+ * different states concurrently.
+ */
+template <policy::isDistributionPolicy POLICY_T>
+std::size_t
+current_action(const POLICY_T &policy, const typename POLICY_T::EnvironmentType &environment, std::size_t i) {
+  const auto &model = environment.indexedTransitionModel;
+  if constexpr (policy::isDeterministicPolicy<POLICY_T>) {
+    return policy.actionIndex(i);
+  } else {
+    auto best = model.nActions();
+    typename POLICY_T::PrecisionType bestProbability = 0.0F;
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      if (model(i, a).empty())
+        continue;
+      const auto probability = row_probability(policy, environment, i, a);
+      if (probability > bestProbability) {
+        best = a;
+        bestProbability = probability;
+      }
+    }
+    return best;
+  }
 }
 
 // This mechanism requires the transition model for the finite state
@@ -102,18 +209,23 @@ typename VALUE_FUNCTION_T::PrecisionType policy_evaluation_step(
     const POLICY_T &policy,
     const typename VALUE_FUNCTION_T::StateType &state) {
 
-  const auto &transitionModel = environment.transitionModel;
-  auto currentValueEstimate = valueFunction.valueAt(state);
+  const auto &model = environment.indexedTransitionModel;
+  const auto i = model.findState(state);
+  if (i == model.npos)
+    return 0.0F;
 
   // For each state action pair reachable from this state evaluate the
   // expected value of the next state given the policy.
-  const auto reachableActions = environment.getReachableActions(state);
-  auto nextValueEstimate = std::accumulate(
-      reachableActions.begin(), reachableActions.end(), 0.0F, [&](const auto &value, const auto &action) {
-        const auto reachableStates = environment.getReachableStates(state, action);
-        return value + policy.getProbability(environment, state, action) *
-                           value_from_state_action(valueFunction, environment, state, action);
-      });
+  typename VALUE_FUNCTION_T::PrecisionType nextValueEstimate = 0.0F;
+  for (std::size_t a = 0; a < model.nActions(); ++a) {
+    const auto r = model.row(i, a);
+    if (model[r].empty())
+      continue;
+    const auto probability = row_probability(policy, environment, i, a);
+    if (probability == 0.0F)
+      continue;
+    nextValueEstimate += probability * value_from_row(valueFunction, environment, r);
+  }
 
   return nextValueEstimate;
 }
@@ -135,22 +247,29 @@ typename VALUE_FUNCTION_T::PrecisionType policy_evaluation_step(
  * @param policy The policy to use for the action selection
  * @param epsilon The convergence threshold. When the value function at any
  * state changes by less than epsilon we have converged.
+ * @param relevant The states to sweep, see relevant_states.
  */
 template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
 void policy_evaluation(
     VALUE_FUNCTION_T &valueFunction,
     const typename POLICY_T::EnvironmentType &environment,
     POLICY_T &policy,
-    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const std::vector<std::uint8_t> &relevant) {
 
   assert(epsilon > 0.0F);
 
+  zero_absorbing_states(valueFunction, environment, relevant);
   typename VALUE_FUNCTION_T::PrecisionType delta = 0.0F;
   // sweep over all states and update the value function. When finally no
   // states change significantly we have converged and can exit
   do {
     delta = 0.0F;
-    for (const auto &state : environment.getAllPossibleStates()) {
+    const auto &model = environment.indexedTransitionModel;
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      if (model.terminal[i] or not relevant[i])
+        continue;
+      const auto &state = model.states[i];
       auto oldValue = valueFunction.valueAt(state);
       auto newValue = policy_evaluation_step(valueFunction, environment, policy, state);
       delta = std::max(delta, std::abs(oldValue - newValue));
@@ -159,6 +278,16 @@ void policy_evaluation(
   } while (delta > epsilon and delta > 0.0F);
 }
 
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void policy_evaluation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+  policy_evaluation(valueFunction, environment, policy, epsilon, relevant_states(environment));
+}
+
 /**
  * @brief Perform a single step of policy improvement. Improve the choice of
  * action taken under the policy from this given state.
@@ -202,7 +331,33 @@ bool policy_improvement_step(
 
   using PolicyKeyMaker = typename POLICY_T::KeyMaker;
 
-  // using KeyMaker = typename POLICY_T::KeyMaker;
+  if constexpr (policy::isDeterministicPolicy<POLICY_T>) {
+    // Compare the rows of the state by index, the first action wins ties
+    // unless the current one is among them
+    const auto &model = environment.indexedTransitionModel;
+    const auto i = model.findState(state);
+    if (i == model.npos or not model.hasTransitions(i))
+      return true;
+    const auto oldAction = policy.actionIndex(i);
+    auto nextAction = model.nActions();
+    typename VALUE_FUNCTION_T::PrecisionType bestValue = 0.0F, oldValue = 0.0F;
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      const auto r = model.row(i, a);
+      if (model[r].empty())
+        continue;
+      const auto value = value_from_row(valueFunction, environment, r);
+      if (a == oldAction)
+        oldValue = value;
+      if (nextAction == model.nActions() or value > bestValue) {
+        bestValue = value;
+        nextAction = a;
+      }
+    }
+    const auto policyStable = not model[model.row(i, oldAction)].empty() and oldValue >= bestValue;
+    if (not policyStable)
+      policy.setActionIndex(i, nextAction);
+    return policyStable;
+  }
 
   const auto oldActions = policy.getProbabilities(environment, state);
   const auto oldActionIdx = std::max_element(
@@ -221,8 +376,12 @@ bool policy_improvement_step(
         return value_from_state_action(valueFunction, environment, state, lhs) <
                value_from_state_action(valueFunction, environment, state, rhs);
       });
-  const auto nextAction = *nextActionIdx;
-  const auto policyStable = oldAction == nextAction;
+  // When the old action ties with the argmax keep it. Otherwise equally good
+  // actions can be swapped back and forth forever depending on iteration order.
+  const auto policyStable =
+      oldAction == *nextActionIdx or value_from_state_action(valueFunction, environment, state, oldAction) >=
+                                         value_from_state_action(valueFunction, environment, state, *nextActionIdx);
+  const auto nextAction = policyStable ? oldAction : *nextActionIdx;
 
   // update the policy - by setting the policy to be deterministic on the
   // new argmax
@@ -245,24 +404,36 @@ bool policy_improvement_step(
  * @param valueFunction The value function to use for the value estimates
  * @param environment The environment to use for the transition model
  * @param policy The policy to use for the action selection
+ * @param relevant The states to improve, see relevant_states.
  * @return true If the policy is stable (no action updates were made)
  * @return false If the policy is not stable (at least one action update was
  * made)
  */
 template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
 bool policy_improvement(
-    VALUE_FUNCTION_T &valueFunction, const typename VALUE_FUNCTION_T::EnvironmentType &environment, POLICY_T &policy) {
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const std::vector<std::uint8_t> &relevant) {
 
   bool policyStable = true;
 
-  const auto allStates = environment.getAllPossibleStates();
-  for (const auto &state : allStates) {
-    policyStable &= policy_improvement_step(valueFunction, environment, policy, state);
+  const auto &model = environment.indexedTransitionModel;
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    if (model.hasTransitions(i) and relevant[i])
+      policyStable &= policy_improvement_step(valueFunction, environment, policy, model.states[i]);
   }
 
   return policyStable;
 }
 
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+bool policy_improvement(
+    VALUE_FUNCTION_T &valueFunction, const typename VALUE_FUNCTION_T::EnvironmentType &environment, POLICY_T &policy) {
+  return policy_improvement(valueFunction, environment, policy, relevant_states(environment));
+}
+
 /**
  * @brief Perform policy iteration on the given value function and policy.
  *
@@ -284,11 +455,12 @@ void policy_iteration(
     const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
 
   bool policyStable = true;
+  const auto relevant = relevant_states(environment);
 
   // While any of the policies are not stable keep improving them
   do {
-    policy_evaluation(valueFunction, environment, policy, epsilon);
-    policyStable &= policy_improvement(valueFunction, environment, policy);
+    policy_evaluation(valueFunction, environment, policy, epsilon, relevant);
+    policyStable = policy_improvement(valueFunction, environment, policy, relevant);
 
   } while (not policyStable);
 }
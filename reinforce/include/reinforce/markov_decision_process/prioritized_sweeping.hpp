@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "reinforce/markov_decision_process/policy_iteration.hpp"
+#include "reinforce/markov_decision_process/synchronous.hpp"
+
+// Prioritized sweeping (asynchronous value iteration). Rather than sweeping
+// every state until the largest change is below epsilon, keep every state whose
+// Bellman residual
+//
+// \begin{equation} |\max_{a} \sum_{s'} p(s'|s,a) (r(s,a,s') + \gamma v(s')) -
+// v(s)| \end{equation}
+//
+// exceeds epsilon in a priority queue and always back up the state with the
+// largest residual. Backing up s only changes the residuals of the states that
+// can transition into s, so only those predecessors are re-examined. States that
+// have converged are never touched again, which on sparse MDPs removes most of
+// the backups of a full sweep.
+//
+// The solver stops when no residual exceeds epsilon, the same condition under
+// which value_iteration_policy_estimation stops sweeping.
+namespace markov_decision_process::prioritized_sweeping {
+
+/**
+ * @brief Estimate the optimal state values by prioritized sweeping.
+ *
+ * @details Values are held in a dense vector indexed like the environments
+ * indexed transition model and written back to the value function at the end.
+ * The queue uses lazy deletion. A state is pushed again whenever its residual
+ * changes and stale entries are skipped when popped.
+ *
+ * @param relevant The states to estimate, see relevant_states.
+ * @return The number of Bellman backups computed, including those only used
+ * to measure a residual.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+std::size_t value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const std::vector<std::uint8_t> &relevant) {
+
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+
+  const auto &model = environment.indexedTransitionModel;
+  const auto predecessors = model.predecessors();
+  const auto active = synchronous::active_states(environment, relevant);
+  auto values = synchronous::gather_values(valueFunction, environment, relevant);
+
+  std::size_t backups = 0;
+  auto bellman = [&](std::size_t i) {
+    ++backups;
+    // Starts from zero like value_iteration_policy_estimation_step
+    const auto best = kernels::max_backup(model, values.data(), valueFunction.discount_rate, i);
+    return std::max(PrecisionType(0.0F), best.value);
+  };
+
+  // The residual each state was last queued with. Zero when not queued.
+  auto priority = std::vector<PrecisionType>(model.nStates(), 0.0F);
+  auto queue = std::priority_queue<std::pair<PrecisionType, std::size_t>>();
+  auto prioritize = [&](std::size_t i) {
+    const auto residual = std::abs(bellman(i) - values[i]);
+    if (residual > epsilon and residual != priority[i]) {
+      priority[i] = residual;
+      queue.emplace(residual, i);
+    }
+  };
+
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    if (active[i])
+      prioritize(i);
+  }
+
+  while (not queue.empty()) {
+    const auto [residual, i] = queue.top();
+    queue.pop();
+    if (residual != priority[i])
+      continue;
+
+    priority[i] = 0.0F;
+    values[i] = bellman(i);
+
+    for (const auto p : predecessors[i]) {
+      if (active[p])
+        prioritize(p);
+    }
+  }
+
+  synchronous::scatter_values(valueFunction, environment, values, relevant);
+  return backups;
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+std::size_t value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+  return value_iteration_policy_estimation(valueFunction, environment, epsilon, relevant_states(environment));
+}
+
+/**
+ * @brief Value iteration where the value estimate is found by prioritized
+ * sweeping, followed by greedy policy improvement.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void value_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+
+  const auto relevant = relevant_states(environment);
+  value_iteration_policy_estimation(valueFunction, environment, epsilon, relevant);
+  policy_improvement(valueFunction, environment, policy, relevant);
+}
+
+} // namespace markov_decision_process::prioritized_sweeping
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "reinforce/markov_decision_process/bellman_kernels.hpp"
+#include "reinforce/markov_decision_process/policy_iteration.hpp"
+#include "reinforce/policy/finite/deterministic_policy.hpp"
+#include "reinforce/rng/engine.hpp"
+#include "reinforce/utils/flat_hash_map.hpp"
+
+// Real time dynamic programming (Barto, Bradtke and Singh) and its labelled
+// variant LRTDP (Bonet and Geffner). Rather than sweeping every state, values
+// are backed up along simulated trajectories that start from reset() and
+// follow the greedy action, so only states reachable from the start states
+// under greedy play are ever touched. The values of states that are never
+// visited do not matter to a policy that starts where reset() does.
+//
+// LRTDP labels a state solved once its residual, and that of every state
+// reachable from it under the greedy policy, is below epsilon. Trials stop at
+// solved states and planning stops once the start states are solved, which
+// gives the same convergence test as value iteration restricted to the
+// relevant states.
+//
+// The Bellman backup is the one of value_iteration_policy_estimation_step
+// (the max over actions starts from zero) so the values agree with the
+// sweeping solvers on every state that is visited. The planner keeps the value
+// and labels of every visited state in arrays that grow with the states
+// visited, so a call costs memory in the states it reaches rather than in the
+// size of the model. Values are only read from and written back to the value
+// function for the states visited.
+namespace markov_decision_process::rtdp {
+
+struct Options {
+  /// @brief Give up after this many trials.
+  std::size_t maxTrials = 1000000;
+  /// @brief Cut a trial that has not reached a solved or terminal state after
+  /// this many steps.
+  std::size_t maxDepth = 10000;
+  /// @brief LRTDP stops once this many consecutive trials start from a solved
+  /// state. 1 is enough when reset() always gives the same state.
+  std::size_t solvedStarts = 32;
+  /// @brief Hold the planner state in arrays over every state of the model
+  /// instead. Saves a hash lookup per successor and vectorises the backups,
+  /// for when most of the model is visited anyway.
+  bool denseStorage = false;
+};
+
+struct Result {
+  std::size_t trials = 0;
+  std::size_t backups = 0;
+  /// @brief Whether the labelling converged before maxTrials.
+  bool converged = false;
+  /// @brief The index of every state visited, in the order first visited.
+  std::vector<std::uint32_t> states;
+};
+
+namespace detail {
+
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+struct Planner {
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+  using EnvironmentType = typename VALUE_FUNCTION_T::EnvironmentType;
+
+  VALUE_FUNCTION_T &valueFunction;
+  EnvironmentType &environment;
+  const typename EnvironmentType::IndexedTransitionModelType &model = environment.indexedTransitionModel;
+  PrecisionType discountRate = valueFunction.discount_rate;
+  bool dense;
+
+  /// @brief The slot of every visited state in the arrays below, its position
+  /// in result.states. Unused with dense storage, where a state is its own slot.
+  utils::FlatHashMap<std::uint32_t, std::uint32_t> slots;
+  std::vector<PrecisionType> values;
+  std::vector<std::uint8_t> visited;
+  std::vector<std::uint8_t> solved;
+  /// @brief Scratch marks for checkSolved, cleared after every call.
+  std::vector<std::uint8_t> marked;
+  Result result{};
+
+  Planner(VALUE_FUNCTION_T &valueFunction, EnvironmentType &environment, const Options &options)
+      : valueFunction(valueFunction), environment(environment), dense(options.denseStorage) {
+    if (dense) {
+      values.assign(model.nStates(), 0.0F);
+      visited.assign(model.nStates(), 0);
+      solved.assign(model.nStates(), 0);
+      marked.assign(model.nStates(), 0);
+    }
+  }
+
+  /// @brief The slot of a visited state.
+  std::size_t slot(std::size_t i) const { return dense ? i : slots.find(static_cast<std::uint32_t>(i))->second; }
+
+  /// @brief Read the value of a state from the value function on first visit.
+  void visit(std::size_t i) {
+    if (dense) {
+      if (visited[i])
+        return;
+      visited[i] = 1;
+    } else {
+      const auto next = static_cast<std::uint32_t>(result.states.size());
+      if (not slots.try_emplace(static_cast<std::uint32_t>(i), next).second)
+        return;
+      values.push_back(0.0F);
+      solved.push_back(0);
+      marked.push_back(0);
+    }
+    const auto s = slot(i);
+    const auto value = valueFunction.valueAt(model.states[i]);
+    values[s] = model.isAbsorbing(i) ? PrecisionType(0.0F) : value;
+    result.states.push_back(static_cast<std::uint32_t>(i));
+    // Nothing ever changes the value of a terminal state
+    solved[s] = model.terminal[i];
+  }
+
+  PrecisionType &valueOf(std::size_t i) { return values[slot(i)]; }
+  bool isSolved(std::size_t i) const { return solved[slot(i)]; }
+
+  /// @brief The backed up value and greedy action of a state. Successors are
+  /// visited first so that their values have been read.
+  kernels::MaxBackup<PrecisionType> backup(std::size_t i) {
+    ++result.backups;
+    for (auto k = model.rowOffsets[model.row(i, 0)]; k < model.rowOffsets[model.row(i, 0) + model.nActions()]; ++k)
+      visit(model.successors[k]);
+    auto best = dense ? kernels::max_backup(model, values.data(), discountRate, i) : sparseMaxBackup(i);
+    best.value = std::max(PrecisionType(0.0F), best.value);
+    return best;
+  }
+
+  /// @brief kernels::max_backup reading the successor values through their
+  /// slots.
+  kernels::MaxBackup<PrecisionType> sparseMaxBackup(std::size_t i) const {
+    auto best = kernels::MaxBackup<PrecisionType>{std::numeric_limits<PrecisionType>::lowest(), model.nActions()};
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      const auto r = model.row(i, a);
+      const auto row = model[r];
+      if (row.empty())
+        continue;
+      PrecisionType sum = 0;
+      for (std::size_t k = 0; k < row.size(); ++k)
+        sum += row.probabilities[k] * values[slot(row.successors[k])];
+      const auto value = model.expectedRewards[r] + discountRate * sum;
+      if (best.action == model.nActions() or value > best.value)
+        best = {value, a};
+    }
+    return best;
+  }
+
+  /// @brief One simulated greedy trajectory from the start state, backing up
+  /// every state on the way. Returns the states visited in order.
+  template <class E>
+  std::vector<std::size_t> trial(std::size_t start, const Options &options, E &engine) {
+    auto path = std::vector<std::size_t>();
+    auto i = start;
+    visit(i);
+    while (not isSolved(i) and path.size() < options.maxDepth) {
+      path.push_back(i);
+      const auto best = backup(i);
+      valueOf(i) = best.value;
+      const auto r = model.row(i, best.action);
+      i = model[r].successors[environment.sampleRow(r, engine)];
+    }
+    return path;
+  }
+
+  /**
+   * @brief Label i and everything reachable from it under the greedy policy
+   * solved when none of them has a residual above epsilon. Otherwise back up
+   * the states found, deepest first.
+   */
+  bool checkSolved(std::size_t i, PrecisionType epsilon) {
+    auto converged = true;
+    auto open = std::vector<std::size_t>();
+    auto closed = std::vector<std::size_t>();
+    if (not isSolved(i)) {
+      open.push_back(i);
+      marked[slot(i)] = 1;
+    }
+
+    while (not open.empty()) {
+      const auto j = open.back();
+      open.pop_back();
+      closed.push_back(j);
+
+      const auto best = backup(j);
+      if (std::abs(best.value - valueOf(j)) > epsilon) {
+        converged = false;
+        continue;
+      }
+      const auto row = model(j, best.action);
+      for (std::size_t k = 0; k < row.size(); ++k) {
+        const auto next = row.successors[k];
+        if (row.probabilities[k] > 0 and not isSolved(next) and not marked[slot(next)]) {
+          marked[slot(next)] = 1;
+          open.push_back(next);
+        }
+      }
+    }
+
+    if (converged) {
+      for (const auto j : closed)
+        solved[slot(j)] = 1;
+    } else {
+      for (auto it = closed.rbegin(); it != closed.rend(); ++it)
+        valueOf(*it) = backup(*it).value;
+    }
+    for (const auto j : closed)
+      marked[slot(j)] = 0;
+    return converged;
+  }
+
+  std::size_t start() { return model.stateIndex(environment.reset()); }
+
+  /// @brief Run trials until options.solvedStarts consecutive starts are
+  /// solved or options.maxTrials is reached.
+  template <class E>
+  void label(PrecisionType epsilon, const Options &options, E &engine) {
+    std::size_t solvedStarts = 0;
+    while (result.trials < options.maxTrials) {
+      const auto i = start();
+      visit(i);
+      if (isSolved(i)) {
+        if (++solvedStarts >= options.solvedStarts) {
+          result.converged = true;
+          return;
+        }
+        continue;
+      }
+      solvedStarts = 0;
+
+      ++result.trials;
+      auto path = trial(i, options, engine);
+      while (not path.empty() and checkSolved(path.back(), epsilon))
+        path.pop_back();
+    }
+  }
+
+  void scatter() {
+    for (const auto i : result.states)
+      valueFunction.at(model.states[i]).value = valueOf(i);
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief Estimate the optimal values of the states reachable from reset() by
+ * labelled real time dynamic programming.
+ *
+ * @details Each trial starts from environment.reset(), follows the greedy
+ * action sampling successors from the transition model and backs up every
+ * state on the way until it reaches a solved state. The states of the trial
+ * are then checked for convergence, deepest first. Only visited states are read
+ * from or written to the value function.
+ *
+ * @param environment Reset at the start of every trial
+ * @param epsilon The largest residual of a solved state
+ * @return The number of trials and backups and the states visited
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, class E = rng::Engine>
+Result value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const Options &options = {},
+    E &engine = rng::threadEngine()) {
+
+  auto planner = detail::Planner<VALUE_FUNCTION_T>(valueFunction, environment, options);
+  planner.label(epsilon, options, engine);
+  planner.scatter();
+  return planner.result;
+}
+
+/**
+ * @brief Plain real time dynamic programming. Runs nTrials greedy trials from
+ * reset() without labelling, so trials only end at terminal states or after
+ * options.maxDepth steps.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, class E = rng::Engine>
+Result trial_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    std::size_t nTrials,
+    const Options &options = {},
+    E &engine = rng::threadEngine()) {
+
+  auto planner = detail::Planner<VALUE_FUNCTION_T>(valueFunction, environment, options);
+  for (; planner.result.trials < nTrials; ++planner.result.trials)
+    planner.trial(planner.start(), options, engine);
+
+  planner.scatter();
+  return planner.result;
+}
+
+/**
+ * @brief LRTDP followed by greedy policy improvement over the states visited.
+ * The policy of every other state is left as it is.
+ */
+template <
+    policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T,
+    policy::isDistributionPolicy POLICY_T,
+    class E = rng::Engine>
+Result value_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const Options &options = {},
+    E &engine = rng::threadEngine()) {
+
+  auto planner = detail::Planner<VALUE_FUNCTION_T>(valueFunction, environment, options);
+  planner.label(epsilon, options, engine);
+
+  // Improvement visits the successors of states only reached as successors,
+  // which are not reported as visited by the estimate
+  const auto &model = planner.model;
+  auto result = planner.result;
+  for (const auto i : result.states) {
+    if (not model.hasTransitions(i))
+      continue;
+    const auto best = planner.backup(i);
+    if constexpr (policy::isDeterministicPolicy<POLICY_T>)
+      policy.setActionIndex(i, best.action);
+    else
+      policy.setDeterministicPolicy(environment, model.states[i], model.actions[best.action]);
+  }
+  planner.scatter();
+  return result;
+}
+
+} // namespace markov_decision_process::rtdp
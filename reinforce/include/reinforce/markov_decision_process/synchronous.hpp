@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "reinforce/markov_decision_process/bellman_kernels.hpp"
+#include "reinforce/markov_decision_process/policy_iteration.hpp"
+#include "reinforce/markov_decision_process/value_iteration.hpp"
+#include "reinforce/utils/thread_pool.hpp"
+
+// Synchronous (Jacobi) dynamic programming. The in place sweeps of
+// policy_iteration.hpp and value_iteration.hpp update one state at a time and
+// each update sees the ones before it, which forces a single thread. Here every
+// sweep reads only the values of the previous sweep and writes a second buffer:
+//
+// \begin{equation} v_{k+1}(s) = \sum_{a} \pi(a|s) \sum_{s'} p(s'|s,a) [r +
+// \gamma v_k(s')] \end{equation}
+//
+// so the states of a sweep are independent and are partitioned across a thread
+// pool. Both updates are contractions with the same fixed point, so they
+// converge to the same values, the synchronous one in somewhat more sweeps.
+//
+// Values are held in dense vectors indexed like the environments indexed
+// transition model and written back to the value function once converged.
+// Anything that touches the value function or the policy (which are hash maps
+// and not safe to write concurrently) happens on the calling thread.
+namespace markov_decision_process::synchronous {
+
+/// @brief The value of every relevant state of the indexed model, in index
+/// order, zero for absorbing states. The others are left at zero, no relevant
+/// state can reach them.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+std::vector<typename VALUE_FUNCTION_T::PrecisionType> gather_values(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const std::vector<std::uint8_t> &relevant) {
+  const auto &model = environment.indexedTransitionModel;
+  auto values = std::vector<typename VALUE_FUNCTION_T::PrecisionType>(model.nStates());
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    if (relevant[i] and not model.isAbsorbing(i))
+      values[i] = valueFunction.valueAt(model.states[i]);
+  }
+  return values;
+}
+
+/// @brief Write back the values of the relevant states that have transitions.
+/// The others are never updated by the in place sweeps either.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+void scatter_values(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const std::vector<typename VALUE_FUNCTION_T::PrecisionType> &values,
+    const std::vector<std::uint8_t> &relevant) {
+  const auto &model = environment.indexedTransitionModel;
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    if (not model.hasTransitions(i) or not relevant[i])
+      continue;
+    valueFunction.valueAt(model.states[i]);
+    valueFunction.at(model.states[i]).value = values[i];
+  }
+}
+
+/// @brief The expected return of row r of the indexed model under the values
+/// of the previous sweep. The dense counterpart of value_from_row.
+template <typename MODEL_T, typename PRECISION_T>
+PRECISION_T
+backup_row(const MODEL_T &model, const std::vector<PRECISION_T> &values, PRECISION_T discountRate, std::size_t r) {
+  return kernels::backup(model, values.data(), discountRate, r);
+}
+
+/**
+ * @brief Run synchronous sweeps until the largest change in a sweep is at most
+ * epsilon.
+ *
+ * @param update Computes the new value of a state index from the previous
+ * sweep. Called concurrently so it must only read shared data.
+ */
+template <typename PRECISION_T, typename UPDATE_T>
+void sweep_until_converged(
+    std::vector<PRECISION_T> &values,
+    const std::vector<bool> &active,
+    const PRECISION_T &epsilon,
+    utils::ThreadPool &pool,
+    const UPDATE_T &update) {
+
+  auto next = values;
+  auto deltas = std::vector<PRECISION_T>(pool.size());
+  PRECISION_T delta = 0.0F;
+  do {
+    pool.run(values.size(), [&](std::size_t worker, std::size_t begin, std::size_t end) {
+      PRECISION_T workerDelta = 0.0F;
+      for (std::size_t i = begin; i < end; ++i) {
+        if (not active[i])
+          continue;
+        next[i] = update(values, i);
+        workerDelta = std::max(workerDelta, std::abs(next[i] - values[i]));
+      }
+      deltas[worker] = workerDelta;
+    });
+    delta = *std::max_element(deltas.begin(), deltas.end());
+    std::fill(deltas.begin(), deltas.end(), PRECISION_T(0.0F));
+    std::swap(values, next);
+  } while (delta > epsilon and delta > 0.0F);
+}
+
+/// @brief The states the sweeps back up, every relevant state that is not
+/// terminal.
+template <typename ENVIRONMENT_T>
+std::vector<bool> active_states(const ENVIRONMENT_T &environment, const std::vector<std::uint8_t> &relevant) {
+  const auto &model = environment.indexedTransitionModel;
+  auto active = std::vector<bool>(model.nStates());
+  for (std::size_t i = 0; i < model.nStates(); ++i)
+    active[i] = relevant[i] and not model.terminal[i];
+  return active;
+}
+
+/**
+ * @brief Synchronous policy evaluation. Converges to the same values as
+ * markov_decision_process::policy_evaluation.
+ *
+ * @details The policy probabilities of every row are read once up front so the
+ * sweeps themselves never call into the policy.
+ *
+ * @param relevant The states to sweep, see relevant_states.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void policy_evaluation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    utils::ThreadPool &pool,
+    const std::vector<std::uint8_t> &relevant) {
+
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+  assert(epsilon > 0.0F);
+
+  const auto &model = environment.indexedTransitionModel;
+  auto policyProbabilities = std::vector<PrecisionType>(model.nRows());
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      if (not model(i, a).empty())
+        policyProbabilities[model.row(i, a)] = row_probability(policy, environment, i, a);
+    }
+  }
+
+  auto values = gather_values(valueFunction, environment, relevant);
+  sweep_until_converged(
+      values,
+      active_states(environment, relevant),
+      epsilon,
+      pool,
+      [&](const std::vector<PrecisionType> &v, std::size_t i) {
+        PrecisionType value = 0.0F;
+        for (std::size_t a = 0; a < model.nActions(); ++a) {
+          const auto r = model.row(i, a);
+          if (model[r].empty())
+            continue;
+          value += policyProbabilities[r] * backup_row(model, v, valueFunction.discount_rate, r);
+        }
+        return value;
+      });
+  scatter_values(valueFunction, environment, values, relevant);
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void policy_evaluation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename POLICY_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    utils::ThreadPool &pool) {
+  policy_evaluation(valueFunction, environment, policy, epsilon, pool, relevant_states(environment));
+}
+
+/**
+ * @brief Synchronous value iteration. Converges to the same values as
+ * markov_decision_process::value_iteration::value_iteration_policy_estimation.
+ *
+ * @param relevant The states to sweep, see relevant_states.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+void value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    utils::ThreadPool &pool,
+    const std::vector<std::uint8_t> &relevant) {
+
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+
+  const auto &model = environment.indexedTransitionModel;
+  auto values = gather_values(valueFunction, environment, relevant);
+  sweep_until_converged(
+      values,
+      active_states(environment, relevant),
+      epsilon,
+      pool,
+      [&](const std::vector<PrecisionType> &v, std::size_t i) {
+        // Starts from zero like value_iteration_policy_estimation_step
+        const auto best = kernels::max_backup(model, v.data(), valueFunction.discount_rate, i);
+        return std::max(PrecisionType(0.0F), best.value);
+      });
+  scatter_values(valueFunction, environment, values, relevant);
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+void value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    utils::ThreadPool &pool) {
+  value_iteration_policy_estimation(valueFunction, environment, epsilon, pool, relevant_states(environment));
+}
+
+/**
+ * @brief Synchronous policy improvement. The greedy action of every state is
+ * found in parallel and then written to the policy on the calling thread.
+ *
+ * @details As in markov_decision_process::policy_improvement_step the current
+ * action is kept when it ties with the argmax, and the earliest action index
+ * wins other ties.
+ *
+ * @param relevant The states to improve, see relevant_states.
+ * @return true If the policy is stable (no action updates were made)
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+bool policy_improvement(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    utils::ThreadPool &pool,
+    const std::vector<std::uint8_t> &relevant) {
+
+  const auto &model = environment.indexedTransitionModel;
+  // Terminal states still get an action when they have one
+  auto active = std::vector<bool>(model.nStates());
+  for (std::size_t i = 0; i < model.nStates(); ++i)
+    active[i] = relevant[i] and model.hasTransitions(i);
+  const auto values = gather_values(valueFunction, environment, relevant);
+
+  // The action the policy currently favours in each state, and the greedy one
+  auto oldActions = std::vector<std::size_t>(model.nStates());
+  auto nextActions = std::vector<std::size_t>(model.nStates());
+  pool.run(model.nStates(), [&](std::size_t, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      if (not active[i])
+        continue;
+      oldActions[i] = current_action(policy, environment, i);
+      nextActions[i] = oldActions[i];
+      const auto [bestValue, bestAction] = kernels::max_backup(model, values.data(), valueFunction.discount_rate, i);
+      // The current action, when there is one, is kept if it ties with the argmax
+      if (oldActions[i] == model.nActions() or model(i, oldActions[i]).empty() or
+          backup_row(model, values, valueFunction.discount_rate, model.row(i, oldActions[i])) < bestValue)
+        nextActions[i] = bestAction;
+    }
+  });
+
+  bool policyStable = true;
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    if (not active[i])
+      continue;
+    policyStable &= nextActions[i] == oldActions[i];
+    if constexpr (policy::isDeterministicPolicy<POLICY_T>)
+      policy.setActionIndex(i, nextActions[i]);
+    else
+      policy.setDeterministicPolicy(environment, model.states[i], model.actions[nextActions[i]]);
+  }
+  return policyStable;
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+bool policy_improvement(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    utils::ThreadPool &pool) {
+  return policy_improvement(valueFunction, environment, policy, pool, relevant_states(environment));
+}
+
+/// @brief Policy iteration with synchronous evaluation and improvement.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void policy_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    utils::ThreadPool &pool) {
+
+  bool policyStable = true;
+  const auto relevant = relevant_states(environment);
+  do {
+    policy_evaluation(valueFunction, environment, policy, epsilon, pool, relevant);
+    policyStable = policy_improvement(valueFunction, environment, policy, pool, relevant);
+  } while (not policyStable);
+}
+
+/// @brief Value iteration with synchronous sweeps and improvement.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void value_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    utils::ThreadPool &pool) {
+
+  const auto relevant = relevant_states(environment);
+  value_iteration_policy_estimation(valueFunction, environment, epsilon, pool, relevant);
+  policy_improvement(valueFunction, environment, policy, pool, relevant);
+}
+
+} // namespace markov_decision_process::synchronous
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "reinforce/markov_decision_process/bellman_kernels.hpp"
+#include "reinforce/markov_decision_process/policy_iteration.hpp"
+#include "reinforce/markov_decision_process/synchronous.hpp"
+
+// Topological value iteration. The value of a state only depends on the values
+// of the states it can reach, so once the transition graph is condensed into
+// its strongly connected components the components can be solved one at a
+// time, each after every component it can reach. In this order a component is
+// solved against final values and never needs revisiting.
+//
+// A component of a single state with no self transition has no cycle to
+// iterate, so it takes exactly one backup. On episodic MDPs whose states lead
+// monotonically to terminals (card and board games) nearly every component is
+// such a singleton and the solve is a single pass. Components with cycles are
+// swept in place until the largest change in a sweep is at most epsilon, the
+// same stopping rule as value_iteration_policy_estimation, but each sweep only
+// covers the component.
+namespace markov_decision_process::topological {
+
+/**
+ * @brief Estimate the optimal state values component by component.
+ *
+ * @param relevant The states to estimate, see relevant_states.
+ * @return The number of Bellman backups computed.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+std::size_t value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const std::vector<std::uint8_t> &relevant) {
+
+  using PrecisionType = typename VALUE_FUNCTION_T::PrecisionType;
+
+  const auto &model = environment.indexedTransitionModel;
+  const auto components = model.stronglyConnectedComponents();
+  const auto active = synchronous::active_states(environment, relevant);
+  auto values = synchronous::gather_values(valueFunction, environment, relevant);
+
+  std::size_t backups = 0;
+  auto bellman = [&](std::size_t i) {
+    ++backups;
+    // Starts from zero like value_iteration_policy_estimation_step
+    const auto best = kernels::max_backup(model, values.data(), valueFunction.discount_rate, i);
+    return std::max(PrecisionType(0.0F), best.value);
+  };
+  auto hasSelfTransition = [&](std::size_t i) {
+    const auto begin = model.successors.begin() + model.rowOffsets[model.row(i, 0)];
+    const auto end = model.successors.begin() + model.rowOffsets[model.row(i, 0) + model.nActions()];
+    return std::find(begin, end, i) != end;
+  };
+
+  for (std::size_t c = 0; c < components.size(); ++c) {
+    const auto component = components[c];
+    if (component.size() == 1 and not hasSelfTransition(component[0])) {
+      if (active[component[0]])
+        values[component[0]] = bellman(component[0]);
+      continue;
+    }
+
+    PrecisionType delta = 0.0F;
+    do {
+      delta = 0.0F;
+      for (const auto i : component) {
+        if (not active[i])
+          continue;
+        const auto value = bellman(i);
+        delta = std::max(delta, std::abs(value - values[i]));
+        values[i] = value;
+      }
+    } while (delta > epsilon and delta > 0.0F);
+  }
+
+  synchronous::scatter_values(valueFunction, environment, values, relevant);
+  return backups;
+}
+
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+std::size_t value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+  return value_iteration_policy_estimation(valueFunction, environment, epsilon, relevant_states(environment));
+}
+
+/**
+ * @brief Value iteration where the value estimate is found component by
+ * component, followed by greedy policy improvement.
+ */
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T, policy::isDistributionPolicy POLICY_T>
+void value_iteration(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    POLICY_T &policy,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+
+  const auto relevant = relevant_states(environment);
+  value_iteration_policy_estimation(valueFunction, environment, epsilon, relevant);
+  policy_improvement(valueFunction, environment, policy, relevant);
+}
+
+} // namespace markov_decision_process::topological
@@ -43,19 +43,22 @@ typename VALUE_FUNCTION_T::PrecisionType value_iteration_policy_estimation_step(
     const typename VALUE_FUNCTION_T::EnvironmentType &environment,
     const typename VALUE_FUNCTION_T::StateType &state) {
 
-  const auto &transitionModel = environment.transitionModel;
-  auto currentValueEstimate = valueFunction.valueAt(state);
+  const auto &model = environment.indexedTransitionModel;
+  const auto i = model.findState(state);
+  if (i == model.npos)
+    return 0.0F;
 
-  const auto reachableActions = environment.getReachableActions(state);
   // The difference between this and value evaluation is that we only keep the
   // max value and discard the other actions. We also have no need for the
   // probabilities of taking an action under the policy - as it is assumed to be
   // deterministicly defined by this argmax.
-  auto nextValueEstimate = std::accumulate(
-      reachableActions.begin(), reachableActions.end(), 0.0f, [&](const auto &value, const auto &action) {
-        const auto reachableStates = environment.getReachableStates(state, action);
-        return std::max(value, value_from_state_action(valueFunction, environment, state, action));
-      });
+  typename VALUE_FUNCTION_T::PrecisionType nextValueEstimate = 0.0F;
+  for (std::size_t a = 0; a < model.nActions(); ++a) {
+    const auto r = model.row(i, a);
+    if (model[r].empty())
+      continue;
+    nextValueEstimate = std::max(nextValueEstimate, value_from_row(valueFunction, environment, r));
+  }
 
   return nextValueEstimate;
 }
@@ -64,19 +67,27 @@ typename VALUE_FUNCTION_T::PrecisionType value_iteration_policy_estimation_step(
  * @brief Perform value iteration to estimate the value function for all states
  * in a valueFunction. Stop when the maximum change in value is less than
  * epsilon.
+ *
+ * @param relevant The states to sweep, see relevant_states.
  */
 template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
 void value_iteration_policy_estimation(
     VALUE_FUNCTION_T &valueFunction,
     const typename VALUE_FUNCTION_T::EnvironmentType &environment,
-    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon,
+    const std::vector<std::uint8_t> &relevant) {
 
+  zero_absorbing_states(valueFunction, environment, relevant);
   typename VALUE_FUNCTION_T::PrecisionType delta = 0.0F;
   // sweep over all states and update the value function. When finally no
   // states change significantly we have converged and can exit
   do {
     delta = 0.0F;
-    for (const auto &state : environment.getAllPossibleStates()) {
+    const auto &model = environment.indexedTransitionModel;
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      if (model.terminal[i] or not relevant[i])
+        continue;
+      const auto &state = model.states[i];
       auto oldValue = valueFunction.valueAt(state);
       auto newValue = value_iteration_policy_estimation_step(valueFunction, environment, state);
       delta = std::max(delta, std::abs(oldValue - newValue));
@@ -85,6 +96,15 @@ void value_iteration_policy_estimation(
   } while (delta > epsilon);
 }
 
+/// @brief As above, over the relevant states of the environment.
+template <policy::objectives::isFiniteStateValueFunction VALUE_FUNCTION_T>
+void value_iteration_policy_estimation(
+    VALUE_FUNCTION_T &valueFunction,
+    const typename VALUE_FUNCTION_T::EnvironmentType &environment,
+    const typename VALUE_FUNCTION_T::PrecisionType &epsilon) {
+  value_iteration_policy_estimation(valueFunction, environment, epsilon, relevant_states(environment));
+}
+
 /** @brief Over all states, on a given state output a deterministic policy (an
  * estimate of the optimal) such that the policy simply takes the action with
  * the max value.
@@ -103,8 +123,9 @@ void value_iteration(
 
   // No loop for policy stability required here as is the case with policy
   // iteration.
-  value_iteration_policy_estimation(valueFunction, environment, epsilon);
-  policy_improvement(valueFunction, environment, policy);
+  const auto relevant = relevant_states(environment);
+  value_iteration_policy_estimation(valueFunction, environment, epsilon, relevant);
+  policy_improvement(valueFunction, environment, policy, relevant);
 }
 
 } // namespace markov_decision_process::value_iteration
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
 
 #include "reinforce/monte_carlo/episode.hpp"
@@ -17,8 +16,8 @@ struct NiaveAverageReturnsUpdate : ValueUpdaterBase<NiaveAverageReturnsUpdate<VA
 
   SETUP_TYPES_W_VALUE_FUNCTION(VALUE_FUNCTION_T);
   using ReturnsContainer = std::vector<typename VALUE_FUNCTION_T::PrecisionType>;
-  using ReturnsMap = std::
-      unordered_map<typename VALUE_FUNCTION_T::KeyType, ReturnsContainer, typename VALUE_FUNCTION_T::KeyMaker::Hash>;
+  // The same kind of table as the value function, see FiniteValueFunction::KeyMapType
+  using ReturnsMap = typename VALUE_FUNCTION_T::template KeyMapType<ReturnsContainer>;
 
   ReturnsMap returns;
 
@@ -67,8 +66,7 @@ struct NiaveAverageReturnsIncrementalUpdate
     size_t n = 0;
   };
 
-  using ReturnsMap = std::
-      unordered_map<typename VALUE_FUNCTION_T::KeyType, ReturnsContainer, typename VALUE_FUNCTION_T::KeyMaker::Hash>;
+  using ReturnsMap = typename VALUE_FUNCTION_T::template KeyMapType<ReturnsContainer>;
 
   ReturnsMap returns;
 
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
 
 #include "reinforce/monte_carlo/episode.hpp"
@@ -24,8 +23,7 @@ struct OrdinaryImportanceSamplingUpdate
   };
 
   using ReturnsContainer = std::vector<ImportanceWeightedReturn>;
-  using ReturnsMap = std::
-      unordered_map<typename VALUE_FUNCTION_T::KeyType, ReturnsContainer, typename VALUE_FUNCTION_T::KeyMaker::Hash>;
+  using ReturnsMap = typename VALUE_FUNCTION_T::template KeyMapType<ReturnsContainer>;
 
   ReturnsMap returns;
 
@@ -86,8 +84,7 @@ struct OrdinaryImportanceSamplingIncrementalUpdate
     size_t n = 0;
   };
 
-  using ReturnsMap = std::
-      unordered_map<typename VALUE_FUNCTION_T::KeyType, ReturnsContainer, typename VALUE_FUNCTION_T::KeyMaker::Hash>;
+  using ReturnsMap = typename VALUE_FUNCTION_T::template KeyMapType<ReturnsContainer>;
 
   ReturnsMap returns;
 
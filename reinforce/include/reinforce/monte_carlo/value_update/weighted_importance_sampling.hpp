@@ -1,6 +1,5 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
 
 #include "reinforce/monte_carlo/episode.hpp"
@@ -58,8 +57,7 @@ struct WeightedImportanceSamplingIncrementalUpdate
     size_t n = 0;
   };
 
-  using ReturnsMap = std::
-      unordered_map<typename VALUE_FUNCTION_T::KeyType, ReturnsContainer, typename VALUE_FUNCTION_T::KeyMaker::Hash>;
+  using ReturnsMap = typename VALUE_FUNCTION_T::template KeyMapType<ReturnsContainer>;
 
   ReturnsMap returns;
 
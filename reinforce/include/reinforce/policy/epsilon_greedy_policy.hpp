@@ -1,10 +1,12 @@
 #pragma once
 #include <random>
+#include <utility>
 #include <xtensor/xfixed.hpp>
 #include <xtensor/xrandom.hpp>
 
 #include "reinforce/environment.hpp"
 #include "reinforce/policy/policy.hpp"
+#include "reinforce/rng/engine.hpp"
 
 #define EGP EpsilonSoftPolicy<EXPLORE_POLICY, EXPLOIT_POLICY, E>
 
@@ -18,7 +20,7 @@ namespace policy {
 // We say that the charicteristics of the distribution for the epsilon soft policy is the joint distribution
 // implicit in the epsilon selection criteria.
 
-template <implementsPolicy EXPLORE_POLICY, implementsPolicy EXPLOIT_POLICY, class E = xt::random::default_engine_type>
+template <implementsPolicy EXPLORE_POLICY, implementsPolicy EXPLOIT_POLICY, class E = rng::Engine>
 requires(std::is_same_v<typename EXPLORE_POLICY::EnvironmentType, typename EXPLOIT_POLICY::EnvironmentType>)
 struct EpsilonSoftPolicy : EXPLOIT_POLICY, virtual PolicyDistributionMixin<typename EXPLORE_POLICY::EnvironmentType> {
 
@@ -29,14 +31,15 @@ struct EpsilonSoftPolicy : EXPLOIT_POLICY, virtual PolicyDistributionMixin<typen
 
   ExploreType explorePolicy;
   PrecisionType epsilon = 0.1;
-  EngineType &engine;
+  // Owned so copies of the policy and other threads never share a stream
+  mutable EngineType engine;
 
   EpsilonSoftPolicy(
       const ExploreType &explorePolicy,
       const ExploitType &exploitPolicy,
       PrecisionType epsilon = 0.1,
-      E &engine = xt::random::get_default_random_engine())
-      : EXPLOIT_POLICY(exploitPolicy), explorePolicy(explorePolicy), epsilon(epsilon), engine(engine) {}
+      E engine = rng::makeEngine())
+      : EXPLOIT_POLICY(exploitPolicy), explorePolicy(explorePolicy), epsilon(epsilon), engine(std::move(engine)) {}
 
   ActionSpace explore(const EnvironmentType &e, const StateType &s) const;
   ActionSpace exploit(const EnvironmentType &e, const StateType &s) const;
@@ -124,7 +127,7 @@ typename EGP::PrecisionType EGP::getNormalisationConstant(const EnvironmentType
 template <implementsPolicy EXPLORE_POLICY, implementsPolicy EXPLOIT_POLICY, class E>
 requires(std::is_same_v<typename EXPLORE_POLICY::EnvironmentType, typename EXPLOIT_POLICY::EnvironmentType>)
 typename EGP::ActionSpace EGP::sampleAction(const EnvironmentType &e, const typename EGP::StateType &s) const {
-  if (xt::random::rand<double>(xt::xshape<1>{}, 0, 1, engine)[0] < epsilon) {
+  if (rng::uniform(engine) < epsilon) {
     return this->explore(e, s);
   }
   return this->exploit(e, s);
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "reinforce/markov_decision_process/finite_transition_model.hpp"
+#include "reinforce/policy/distribution_policy.hpp"
+#include "reinforce/policy/objectives/value_function_keymaker.hpp"
+
+#define FDetP FiniteDeterministicPolicy<E>
+
+namespace policy {
+
+// A deterministic policy over the states of a Markov decision environment,
+// stored as one action index per state of its indexed transition model. This
+// is the policy policy iteration actually produces. Where a
+// FiniteDistributionPolicy keeps a logit per (state, action) in a hash table
+// and finds the actions of a state by scanning the table, here every query is
+// an array lookup. The solvers in markov_decision_process recognise it by
+// isDeterministicPolicy and work on the indices directly, without building
+// states or keys.
+
+template <environment::MarkovDecisionEnvironmentType E>
+struct FiniteDeterministicPolicy : DistributionPolicy<E> {
+
+  SETUP_TYPES_FROM_ENVIRON(SINGLE_ARG(E));
+  using KeyMaker = objectives::StateActionKeymaker<E>;
+  using KeyType = typename KeyMaker::KeyType;
+  using IndexType = std::uint32_t;
+
+  /// @brief Take the first action with transitions in every state. States
+  /// without any take action 0.
+  explicit FiniteDeterministicPolicy(const EnvironmentType &e);
+
+  void update(const EnvironmentType & /*e*/, const TransitionType & /*s*/) override {}
+
+  PrecisionType getProbability(const EnvironmentType &e, const StateType &s, const ActionSpace &a) const override;
+  PrecisionType getLogProbability(const EnvironmentType &e, const StateType &s, const ActionSpace &a) const override;
+  PrecisionType getKernel(const EnvironmentType &e, const StateType &s, const ActionSpace &a) const override;
+  PrecisionType getNormalisationConstant(const EnvironmentType &e, const StateType &s) const override;
+  ActionSpace sampleAction(const EnvironmentType &e, const StateType &s) const override;
+  ActionSpace getArgmaxAction(const EnvironmentType &e, const StateType &s) const override;
+
+  /// @brief The single (key, 1) pair of the action taken in s, in the form of
+  /// FiniteDistributionPolicy::getProbabilities.
+  std::vector<std::pair<KeyType, PrecisionType>> getProbabilities(const EnvironmentType &e, const StateType &s) const;
+
+  void setDeterministicPolicy(const EnvironmentType &e, const StateType &s, const ActionSpace &a);
+
+  /// @brief The action index taken in the state with the given index of the
+  /// environments indexed transition model.
+  std::size_t actionIndex(std::size_t stateIdx) const { return actions[stateIdx]; }
+  void setActionIndex(std::size_t stateIdx, std::size_t actionIdx) { actions[stateIdx] = IndexType(actionIdx); }
+  std::size_t size() const { return actions.size(); }
+
+private:
+  std::vector<IndexType> actions;
+
+  static std::size_t stateIndex(const EnvironmentType &e, const StateType &s) {
+    return e.indexedTransitionModel.stateIndex(s);
+  }
+};
+
+template <environment::MarkovDecisionEnvironmentType E>
+FDetP::FiniteDeterministicPolicy(const EnvironmentType &e) {
+  const auto &model = e.indexedTransitionModel;
+  actions.assign(model.nStates(), 0);
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      if (not model(i, a).empty()) {
+        actions[i] = IndexType(a);
+        break;
+      }
+    }
+  }
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+typename FDetP::PrecisionType
+FDetP::getProbability(const EnvironmentType &e, const StateType &s, const ActionSpace &a) const {
+  const auto &model = e.indexedTransitionModel;
+  const auto i = model.findState(s);
+  if (i == model.npos)
+    return 0.0F;
+  return model.actions[actions[i]] == a ? 1.0F : 0.0F;
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+typename FDetP::PrecisionType
+FDetP::getLogProbability(const EnvironmentType &e, const StateType &s, const ActionSpace &a) const {
+  return getProbability(e, s, a) == 1.0F ? 0.0F : -std::numeric_limits<PrecisionType>::infinity();
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+typename FDetP::PrecisionType
+FDetP::getKernel(const EnvironmentType &e, const StateType &s, const ActionSpace &a) const {
+  return getProbability(e, s, a);
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+typename FDetP::PrecisionType
+FDetP::getNormalisationConstant(const EnvironmentType & /*e*/, const StateType & /*s*/) const {
+  return 1.0F;
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+typename FDetP::ActionSpace FDetP::sampleAction(const EnvironmentType &e, const StateType &s) const {
+  return getArgmaxAction(e, s);
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+typename FDetP::ActionSpace FDetP::getArgmaxAction(const EnvironmentType &e, const StateType &s) const {
+  return e.indexedTransitionModel.actions[actions[stateIndex(e, s)]];
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+std::vector<std::pair<typename FDetP::KeyType, typename FDetP::PrecisionType>>
+FDetP::getProbabilities(const EnvironmentType &e, const StateType &s) const {
+  return {{KeyMaker::make(e, s, getArgmaxAction(e, s)), 1.0F}};
+}
+
+template <environment::MarkovDecisionEnvironmentType E>
+void FDetP::setDeterministicPolicy(const EnvironmentType &e, const StateType &s, const ActionSpace &a) {
+  setActionIndex(stateIndex(e, s), e.indexedTransitionModel.actionIndex(a));
+}
+
+template <typename T>
+concept isDeterministicPolicy = std::is_base_of_v<FiniteDeterministicPolicy<typename T::EnvironmentType>, T>;
+
+} // namespace policy
+
+#undef FDetP
@@ -101,11 +101,11 @@ typename FDP::PrecisionType FDP::getSoftmaxNorm(const EnvironmentType &e, const
   auto reachableActions = e.getReachableActions(s);
   auto norm = std::accumulate(
       reachableActions.begin(), reachableActions.end(), 0.0F, [this, &e, &s](const auto &v, const auto &a) {
-        auto key = KeyMaker::make(e, s, a);
-        if (this->find(key) == this->end()) {
+        const auto it = this->find(KeyMaker::make(e, s, a));
+        if (it == this->end()) {
           return v;
         }
-        return v + std::exp(this->at(key).value);
+        return v + std::exp(it->second.value);
       });
   return norm;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <utility>
 
 #include "reinforce/environment.hpp"
 #include "reinforce/policy/epsilon_greedy_policy.hpp"
@@ -13,7 +14,7 @@ namespace policy {
 template <
     implementsPolicy EXPLORE_POLICY,
     implementsFiniteValuePolicy EXPLOIT_POLICY,
-    class E = xt::random::default_engine_type>
+    class E = rng::Engine>
 struct FiniteEpsilonGreedyPolicy : EpsilonSoftPolicy<EXPLORE_POLICY, EXPLOIT_POLICY, E> {
 
   using BaseType = EXPLOIT_POLICY;
@@ -27,8 +28,8 @@ struct FiniteEpsilonGreedyPolicy : EpsilonSoftPolicy<EXPLORE_POLICY, EXPLOIT_POL
       const ExploreType &explorePolicy,
       const ExploitType &exploitPolicy,
       PrecisionType epsilon = 0.1,
-      E &engine = xt::random::get_default_random_engine())
-      : BaseEpsilonSoftType(explorePolicy, exploitPolicy, epsilon, engine) {}
+      E engine = rng::makeEngine())
+      : BaseEpsilonSoftType(explorePolicy, exploitPolicy, epsilon, std::move(engine)) {}
 };
 
 template <typename T>
@@ -25,7 +25,7 @@ struct FiniteGreedyPolicy : GreedyPolicy<VALUE_FUNCTION_T>, FinitePolicyValueFun
   SETUP_TYPES_W_VALUE_FUNCTION(VALUE_FUNCTION_T);
   using ValueFunctionBaseType = typename ValueFunctionType::ValueFunctionBaseType;
   using StepSizeTaker = typename VALUE_FUNCTION_T::StepSizeTaker;
-  using ValueTableType = typename objectives::FiniteValueFunction<ValueFunctionType>::ValueTableType;
+  using ValueTableType = typename ValueFunctionType::ValueTableType;
 
   FiniteGreedyPolicy(auto &&...args);
   FiniteGreedyPolicy(const FiniteGreedyPolicy &p);
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// The argmax over the actions of a state in a dense value table. The values of
+// a state are adjacent in the table but each sits inside its value object
+// (value, step, ...), so the kernel reads them with a byte stride. Entries are
+// considered only where mask is non zero, and ties go to the lowest position,
+// so the result does not depend on the vector width. With AVX2 enabled at
+// compile time (-mavx2 or -march=native) 8 floats or 4 doubles are gathered and
+// compared at a time, each lane keeping its best value and position with a
+// compare and blend, otherwise it is a scalar loop.
+namespace policy::objectives::kernels {
+
+namespace detail {
+
+template <typename PRECISION_T>
+const PRECISION_T &strided(const PRECISION_T *first, std::size_t strideBytes, std::size_t k) {
+  return *reinterpret_cast<const PRECISION_T *>(reinterpret_cast<const char *>(first) + k * strideBytes);
+}
+
+/// @brief Continue an argmax from (best, bestK) over positions [begin, n).
+template <typename PRECISION_T>
+std::size_t masked_argmax_scalar(
+    const PRECISION_T *first,
+    std::size_t strideBytes,
+    const std::uint8_t *mask,
+    std::size_t begin,
+    std::size_t n,
+    PRECISION_T best,
+    std::size_t bestK) {
+  for (std::size_t k = begin; k < n; ++k) {
+    if (not mask[k])
+      continue;
+    const auto value = strided(first, strideBytes, k);
+    if (bestK == n or value > best) {
+      best = value;
+      bestK = k;
+    }
+  }
+  return bestK;
+}
+
+#if defined(__AVX2__)
+
+inline std::size_t
+masked_argmax_avx2(const float *first, std::size_t strideBytes, const std::uint8_t *mask, std::size_t n) {
+  const auto stride = static_cast<int>(strideBytes);
+  const auto offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+  const auto none = _mm256_set1_epi32(-1);
+  auto positions = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  auto best = _mm256_setzero_ps();
+  auto bestK = none;
+  std::size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    const auto base = reinterpret_cast<const float *>(reinterpret_cast<const char *>(first) + k * strideBytes);
+    const auto v = _mm256_i32gather_ps(base, offsets, 1);
+    const auto m = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(mask + k)));
+    const auto valid = _mm256_xor_si256(_mm256_cmpeq_epi32(m, _mm256_setzero_si256()), none);
+    // A lane takes the new value when it is valid and either beats the lane's
+    // best or the lane has none yet, strictly so the first position is kept
+    const auto empty = _mm256_castsi256_ps(_mm256_cmpeq_epi32(bestK, none));
+    const auto better = _mm256_and_ps(
+        _mm256_castsi256_ps(valid), _mm256_or_ps(_mm256_cmp_ps(v, best, _CMP_GT_OQ), empty));
+    best = _mm256_blendv_ps(best, v, better);
+    bestK = _mm256_castps_si256(
+        _mm256_blendv_ps(_mm256_castsi256_ps(bestK), _mm256_castsi256_ps(positions), better));
+    positions = _mm256_add_epi32(positions, _mm256_set1_epi32(8));
+  }
+
+  alignas(32) float values[8];
+  alignas(32) std::int32_t ks[8];
+  _mm256_store_ps(values, best);
+  _mm256_store_si256(reinterpret_cast<__m256i *>(ks), bestK);
+  auto result = n;
+  float resultValue = 0;
+  for (std::size_t lane = 0; lane < 8; ++lane) {
+    if (ks[lane] < 0)
+      continue;
+    const auto laneK = static_cast<std::size_t>(ks[lane]);
+    if (result == n or values[lane] > resultValue or (values[lane] == resultValue and laneK < result)) {
+      result = laneK;
+      resultValue = values[lane];
+    }
+  }
+  return masked_argmax_scalar(first, strideBytes, mask, k, n, resultValue, result);
+}
+
+inline std::size_t
+masked_argmax_avx2(const double *first, std::size_t strideBytes, const std::uint8_t *mask, std::size_t n) {
+  const auto stride = static_cast<int>(strideBytes);
+  const auto offsets = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(stride));
+  const auto none = _mm256_set1_epi64x(-1);
+  auto positions = _mm256_setr_epi64x(0, 1, 2, 3);
+  auto best = _mm256_setzero_pd();
+  auto bestK = none;
+  std::size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    const auto base = reinterpret_cast<const double *>(reinterpret_cast<const char *>(first) + k * strideBytes);
+    const auto v = _mm256_i32gather_pd(base, offsets, 1);
+    std::int32_t packed;
+    std::memcpy(&packed, mask + k, sizeof(packed));
+    const auto m = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+    const auto valid = _mm256_xor_si256(_mm256_cmpeq_epi64(m, _mm256_setzero_si256()), none);
+    const auto empty = _mm256_castsi256_pd(_mm256_cmpeq_epi64(bestK, none));
+    const auto better = _mm256_and_pd(
+        _mm256_castsi256_pd(valid), _mm256_or_pd(_mm256_cmp_pd(v, best, _CMP_GT_OQ), empty));
+    best = _mm256_blendv_pd(best, v, better);
+    bestK = _mm256_castpd_si256(
+        _mm256_blendv_pd(_mm256_castsi256_pd(bestK), _mm256_castsi256_pd(positions), better));
+    positions = _mm256_add_epi64(positions, _mm256_set1_epi64x(4));
+  }
+
+  alignas(32) double values[4];
+  alignas(32) std::int64_t ks[4];
+  _mm256_store_pd(values, best);
+  _mm256_store_si256(reinterpret_cast<__m256i *>(ks), bestK);
+  auto result = n;
+  double resultValue = 0;
+  for (std::size_t lane = 0; lane < 4; ++lane) {
+    if (ks[lane] < 0)
+      continue;
+    const auto laneK = static_cast<std::size_t>(ks[lane]);
+    if (result == n or values[lane] > resultValue or (values[lane] == resultValue and laneK < result)) {
+      result = laneK;
+      resultValue = values[lane];
+    }
+  }
+  return masked_argmax_scalar(first, strideBytes, mask, k, n, resultValue, result);
+}
+
+#endif
+
+} // namespace detail
+
+/// @brief True when masked_argmax uses vector instructions for PRECISION_T.
+template <typename PRECISION_T>
+constexpr bool isVectorized =
+#if defined(__AVX2__)
+    std::is_same_v<PRECISION_T, float> || std::is_same_v<PRECISION_T, double>;
+#else
+    false;
+#endif
+
+/**
+ * @brief The position of the largest of n values among those with a non zero
+ * mask, the first on ties, or n when the mask is all zero.
+ *
+ * @param first The first value, value k is strideBytes * k bytes after it.
+ */
+template <typename PRECISION_T>
+std::size_t
+masked_argmax(const PRECISION_T *first, std::size_t strideBytes, const std::uint8_t *mask, std::size_t n) {
+#if defined(__AVX2__)
+  if constexpr (isVectorized<PRECISION_T>)
+    return detail::masked_argmax_avx2(first, strideBytes, mask, n);
+  else
+#endif
+    return detail::masked_argmax_scalar(first, strideBytes, mask, 0, n, PRECISION_T(), n);
+}
+
+} // namespace policy::objectives::kernels
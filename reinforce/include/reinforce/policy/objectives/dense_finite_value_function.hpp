@@ -0,0 +1,435 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "reinforce/policy/objectives/argmax_kernels.hpp"
+#include "reinforce/policy/objectives/finite_value_function.hpp"
+#include "reinforce/policy/objectives/value_function_keymaker.hpp"
+#include "reinforce/spec.hpp"
+
+namespace policy::objectives {
+
+// A dense table for the value functions of finite environments. Where the
+// default table is an unordered_map hashing and comparing whole states, every
+// key of a finite spec has a mixed radix index (spec::toIndex), so the values
+// can instead live in an array of nStates x nActions entries, state major, and
+// a lookup is an index computation and a load.
+//
+// The table has the interface of the unordered_map that the updaters, policies
+// and solvers use (operator[], at, find, emplace, iteration over (key, value)
+// pairs) so FiniteValueFunction takes it as a drop in replacement. Values are
+// stored as ValueType objects, value and step side by side, and at and
+// operator[] return references into the array as the map does. A present flag
+// per entry keeps the map semantics of keys that were never inserted.
+//
+// The array is allocated on the first insertion and is as large as the spec,
+// so this is for environments whose whole state action space fits in memory.
+// Larger sparse tables are better served by FlatFiniteValueFunction.
+
+/// @brief The index of the keys of a keymaker into a dense table. State keys
+/// are numbered by their observable part, which is all that State equality
+/// compares.
+template <isValueFunctionKeymaker KEYMAKER_T>
+struct DenseKeyIndex {
+  using KeyMaker = KEYMAKER_T;
+  using KeyType = typename KeyMaker::KeyType;
+  using StateType = typename KeyMaker::StateType;
+  using ActionSpace = typename KeyMaker::ActionSpace;
+  using StateSpecType = typename StateType::ObservableSpecType;
+  using ActionSpecType = typename ActionSpace::SpecType;
+
+  constexpr static bool hasState = not isActionKeymaker<KeyMaker>;
+  constexpr static bool hasAction = not isStateKeymaker<KeyMaker>;
+  constexpr static std::size_t nStates = hasState ? StateSpecType::nPossibleValues() : 1;
+  constexpr static std::size_t nActions = hasAction ? ActionSpecType::nPossibleValues() : 1;
+  constexpr static std::size_t size = nStates * nActions;
+
+  static std::size_t index(const KeyType &key) {
+    if constexpr (hasState and hasAction)
+      return stateIndex(key.first) * nActions + actionIndex(key.second);
+    else if constexpr (hasState)
+      return stateIndex(key);
+    else
+      return actionIndex(key);
+  }
+
+  static KeyType key(std::size_t index) {
+    if constexpr (hasState and hasAction)
+      return KeyType(stateKey<typename KeyType::first_type>(index / nActions),
+                     actionKey<typename KeyType::second_type>(index % nActions));
+    else if constexpr (hasState)
+      return stateKey<KeyType>(index);
+    else
+      return actionKey<KeyType>(index);
+  }
+
+  // Key halves are either the state and action themselves or their bit packed
+  // forms (PackedStateActionKeymaker)
+  template <typename T>
+  static std::size_t stateIndex(const T &state) {
+    if constexpr (std::is_same_v<T, StateType>)
+      return spec::toIndex<StateSpecType>(state.observable);
+    else
+      return spec::toIndex<StateSpecType>(state.unpack());
+  }
+
+  template <typename T>
+  static std::size_t actionIndex(const T &action) {
+    if constexpr (std::is_same_v<T, ActionSpace>)
+      return spec::toIndex<ActionSpecType>(action);
+    else
+      return spec::toIndex<ActionSpecType>(action.unpack());
+  }
+
+private:
+  template <typename T>
+  static T stateKey(std::size_t index) {
+    if constexpr (std::is_same_v<T, StateType>)
+      return StateType(
+          spec::fromIndex<StateSpecType>(index), spec::default_spec_gen<typename StateType::HiddenSpecType>());
+    else
+      return T(spec::fromIndex<StateSpecType>(index));
+  }
+
+  template <typename T>
+  static T actionKey(std::size_t index) {
+    return T(spec::fromIndex<ActionSpecType>(index));
+  }
+};
+
+namespace detail {
+template <typename VALUE_T>
+struct row_value {
+  using type = std::uint8_t;
+};
+template <typename VALUE_T>
+requires requires(VALUE_T v) { v.value; }
+struct row_value<VALUE_T> {
+  using type = std::remove_cvref_t<decltype(std::declval<VALUE_T>().value)>;
+};
+} // namespace detail
+
+/**
+ * @brief A table of every key of a finite spec, see above.
+ *
+ * @details Tables of state action values also keep the argmax of every state
+ * row (rowArgmax(stateIdx)) as greedy policies ask for it far more often than
+ * values change. Values are written through references, so rather than see
+ * each write the table keeps the entry of each row last handed out mutably
+ * (operator[], at, find, try_emplace, erase) pending. An argmax of the row
+ * compares the pending entry against the cached best, which is O(1) unless it
+ * lowered the best, when the row is scanned. Reads never change the cache, so
+ * concurrent readers are safe and a pending entry may be written any number of
+ * times. The pending entry is folded into the cache when another entry of the
+ * row is handed out mutably, so a reference must not be written after a later
+ * mutable access to another action of its state. A mutable begin() leaves every
+ * row to be scanned until its next mutable access.
+ */
+template <isValueFunctionKeymaker KEYMAKER_T, std::default_initializable VALUE_T>
+class DenseValueTable {
+public:
+  using KeyMaker = KEYMAKER_T;
+  using KeyIndex = DenseKeyIndex<KEYMAKER_T>;
+  using KeyType = typename KeyMaker::KeyType;
+  using ValueType = VALUE_T;
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using size_type = std::size_t;
+  using RowValueType = typename detail::row_value<ValueType>::type;
+
+  constexpr static bool cachesRowArgmax =
+      KeyIndex::hasState and KeyIndex::hasAction and requires(ValueType v) { v.value; };
+
+  /// @brief Walks the present entries in index order. Dereferencing gives a
+  /// (key, value reference) pair, the key rebuilt from the index.
+  template <bool CONST>
+  class Iterator {
+  public:
+    using TableType = std::conditional_t<CONST, const DenseValueTable, DenseValueTable>;
+    using MappedType = std::conditional_t<CONST, const ValueType, ValueType>;
+    using value_type = std::pair<KeyType, MappedType &>;
+    using reference = value_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::input_iterator_tag;
+    using iterator_concept = std::forward_iterator_tag;
+
+    struct Arrow {
+      value_type entry;
+      value_type *operator->() { return &entry; }
+    };
+
+    Iterator() = default;
+    Iterator(TableType *table, std::size_t index) : table(table), index(index) { skip(); }
+    operator Iterator<true>() const requires(not CONST) { return Iterator<true>(table, index); }
+
+    reference operator*() const { return {KeyIndex::key(index), table->values[index]}; }
+    Arrow operator->() const { return Arrow{**this}; }
+
+    Iterator &operator++() {
+      ++index;
+      skip();
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const Iterator &other) const { return index == other.index; }
+
+    std::size_t position() const { return index; }
+
+  private:
+    TableType *table = nullptr;
+    std::size_t index = 0;
+
+    void skip() {
+      while (index < table->present.size() and not table->present[index])
+        ++index;
+    }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  std::size_t size() const { return nPresent; }
+  bool empty() const { return nPresent == 0; }
+  /// @brief The number of keys the table can hold, every key of the spec.
+  constexpr static std::size_t capacity() { return KeyIndex::size; }
+
+  iterator begin() {
+    touchAll();
+    return iterator(this, 0);
+  }
+  iterator end() { return iterator(this, present.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, present.size()); }
+
+  iterator find(const KeyType &key) {
+    const auto i = KeyIndex::index(key);
+    if (not isPresent(i))
+      return end();
+    touch(i);
+    return iterator(this, i);
+  }
+  const_iterator find(const KeyType &key) const {
+    const auto i = KeyIndex::index(key);
+    return isPresent(i) ? const_iterator(this, i) : end();
+  }
+
+  bool contains(const KeyType &key) const { return isPresent(KeyIndex::index(key)); }
+  std::size_t count(const KeyType &key) const { return contains(key) ? 1 : 0; }
+
+  ValueType &at(const KeyType &key) {
+    const auto i = checked(key);
+    touch(i);
+    return values[i];
+  }
+  const ValueType &at(const KeyType &key) const { return values[checked(key)]; }
+
+  /// @brief The value of the key, default constructed when it is not present.
+  ValueType &operator[](const KeyType &key) { return try_emplace(key).first->second; }
+
+  template <typename... ARGS>
+  std::pair<iterator, bool> try_emplace(const KeyType &key, ARGS &&...args) {
+    const auto i = KeyIndex::index(key);
+    if (isPresent(i)) {
+      touch(i);
+      return {iterator(this, i), false};
+    }
+    allocate();
+    values[i] = ValueType(std::forward<ARGS>(args)...);
+    present[i] = 1;
+    ++nPresent;
+    countEntry(i, true);
+    touch(i);
+    return {iterator(this, i), true};
+  }
+
+  std::pair<iterator, bool> emplace(const KeyType &key, const ValueType &value) { return try_emplace(key, value); }
+
+  std::size_t erase(const KeyType &key) {
+    const auto i = KeyIndex::index(key);
+    if (not isPresent(i))
+      return 0;
+    present[i] = 0;
+    --nPresent;
+    countEntry(i, false);
+    touch(i);
+    return 1;
+  }
+
+  void clear() {
+    values.clear();
+    present.clear();
+    nPresent = 0;
+    pending.clear();
+    bestAction.clear();
+    bestValue.clear();
+    rowSizes.clear();
+  }
+
+  /// @brief The action index of the largest value present in the row of a
+  /// state, the lowest index on ties, from the cache. nActions when the row is
+  /// empty.
+  std::size_t rowArgmax(std::size_t stateIdx) const
+  requires cachesRowArgmax
+  {
+    constexpr auto nActions = KeyIndex::nActions;
+    if (present.empty())
+      return nActions;
+    const auto row = stateIdx * nActions;
+    const auto a = pending[stateIdx];
+    const auto best = bestAction[stateIdx];
+    if (a == none)
+      return best;
+    if (a == all or (a == best and (not present[row + a] or values[row + a].value < bestValue[stateIdx])))
+      return scan(stateIdx);
+    if (not present[row + a] or a == best)
+      return best;
+    const auto value = values[row + a].value;
+    if (best == nActions or value > bestValue[stateIdx] or (value == bestValue[stateIdx] and a < best))
+      return a;
+    return best;
+  }
+
+  /// @brief The number of entries present in the row of a state.
+  std::size_t rowSize(std::size_t stateIdx) const
+  requires cachesRowArgmax
+  {
+    return present.empty() ? 0 : rowSizes[stateIdx];
+  }
+
+  /**
+   * @brief The action index of the largest value in the row of a state, over
+   * the actions set in allowed and present in the table, the lowest index on
+   * ties. nActions when there is none.
+   *
+   * @param allowed nActions flags, cleared here where the table has no entry.
+   */
+  std::size_t rowArgmax(std::size_t stateIdx, std::uint8_t *allowed) const
+  requires(KeyIndex::hasState and KeyIndex::hasAction)
+  {
+    constexpr auto nActions = KeyIndex::nActions;
+    if (present.empty())
+      return nActions;
+    const auto row = stateIdx * nActions;
+    for (std::size_t a = 0; a < nActions; ++a)
+      allowed[a] &= present[row + a];
+    return kernels::masked_argmax(&values[row].value, sizeof(ValueType), allowed, nActions);
+  }
+
+private:
+  constexpr static std::size_t none = KeyIndex::nActions;
+  constexpr static std::size_t all = KeyIndex::nActions + 1;
+
+  std::vector<ValueType> values;
+  std::vector<std::uint8_t> present;
+  std::size_t nPresent = 0;
+  // Per state row: the pending action index (or none, or all after a mutable
+  // begin()), the argmax of the row apart from it, and the number of entries.
+  std::vector<std::size_t> pending;
+  std::vector<std::size_t> bestAction;
+  std::vector<RowValueType> bestValue;
+  std::vector<std::size_t> rowSizes;
+
+  /// @brief Make entry i the pending entry of its row, folding the previous
+  /// one into the cache first.
+  void touch(std::size_t i) {
+    if constexpr (cachesRowArgmax) {
+      const auto stateIdx = i / KeyIndex::nActions;
+      const auto action = i % KeyIndex::nActions;
+      if (pending[stateIdx] == action)
+        return;
+      bestAction[stateIdx] = rowArgmax(stateIdx);
+      if (bestAction[stateIdx] != KeyIndex::nActions)
+        bestValue[stateIdx] = values[stateIdx * KeyIndex::nActions + bestAction[stateIdx]].value;
+      pending[stateIdx] = action;
+    }
+  }
+
+  void touchAll() {
+    if constexpr (cachesRowArgmax)
+      std::fill(pending.begin(), pending.end(), all);
+  }
+
+  std::size_t scan(std::size_t stateIdx) const {
+    const auto row = stateIdx * KeyIndex::nActions;
+    return kernels::masked_argmax(&values[row].value, sizeof(ValueType), &present[row], KeyIndex::nActions);
+  }
+
+  void countEntry(std::size_t i, bool added) {
+    if constexpr (cachesRowArgmax) {
+      auto &n = rowSizes[i / KeyIndex::nActions];
+      n = added ? n + 1 : n - 1;
+    }
+  }
+
+  bool isPresent(std::size_t i) const { return i < present.size() and present[i]; }
+
+  std::size_t checked(const KeyType &key) const {
+    const auto i = KeyIndex::index(key);
+    if (not isPresent(i))
+      throw std::out_of_range("Key is not present in the dense value table");
+    return i;
+  }
+
+  void allocate() {
+    if (present.empty()) {
+      values.resize(KeyIndex::size);
+      present.assign(KeyIndex::size, 0);
+      if constexpr (cachesRowArgmax) {
+        pending.assign(KeyIndex::nStates, none);
+        bestAction.assign(KeyIndex::nStates, KeyIndex::nActions);
+        bestValue.assign(KeyIndex::nStates, RowValueType());
+        rowSizes.assign(KeyIndex::nStates, 0);
+      }
+    }
+  }
+};
+
+template <isValueFunctionKeymaker KEYMAPPER_T, isValue VALUE_T>
+struct DenseFiniteValueFunctionMapGetter {
+  using KeyMaker = KEYMAPPER_T;
+  using KeyType = typename KeyMaker::KeyType;
+  using ValueType = VALUE_T;
+  template <typename MAPPED_T>
+  using KeyMap = DenseValueTable<KeyMaker, MAPPED_T>;
+  using type = KeyMap<ValueType>;
+};
+
+/// @brief A FiniteValueFunction over a dense table, see DenseValueTable.
+template <
+    isValueFunction VALUE_FUNCTION_T,
+    isStepSizeTaker INCREMENTAL_STEPSIZE_T = weighted_average_step_size_taker<typename VALUE_FUNCTION_T::ValueType>>
+using DenseFiniteValueFunction =
+    FiniteValueFunction<VALUE_FUNCTION_T, INCREMENTAL_STEPSIZE_T, DenseFiniteValueFunctionMapGetter>;
+
+template <
+    environment::FiniteEnvironmentType E,
+    auto INITIAL_VALUE = 0.0F,
+    auto DISCOUNT_RATE = 0.0F,
+    template <typename> typename VALUE_C = FiniteValue>
+requires isFiniteValueTemplate<VALUE_C>
+using DenseFiniteStateActionValueFunction =
+    DenseFiniteValueFunction<StateActionValueFunction<E, INITIAL_VALUE, DISCOUNT_RATE, VALUE_C>>;
+
+template <
+    environment::FiniteEnvironmentType E,
+    auto INITIAL_VALUE = 0.0F,
+    auto DISCOUNT_RATE = 0.0F,
+    template <typename> typename VALUE_C = FiniteValue>
+requires isFiniteValueTemplate<VALUE_C>
+using DenseFiniteStateValueFunction =
+    DenseFiniteValueFunction<StateValueFunction<E, INITIAL_VALUE, DISCOUNT_RATE, VALUE_C>>;
+
+} // namespace policy::objectives
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
@@ -11,6 +16,8 @@
 #include "reinforce/policy/objectives/value.hpp"
 #include "reinforce/policy/objectives/value_function.hpp"
 #include "reinforce/policy/objectives/value_function_keymaker.hpp"
+#include "reinforce/reachability.hpp"
+#include "reinforce/utils/flat_hash_map.hpp"
 
 namespace policy::objectives {
 
@@ -20,18 +27,69 @@ struct FiniteValueFunctionMapGetter {
   using KeyType = typename KeyMaker::KeyType;
   using ValueType = VALUE_T;
   using Hash = typename KeyMaker::Hash;
+  /// @brief The same kind of map from keys to anything else, for the per key
+  /// data kept alongside the value function (e.g. the returns of Monte Carlo).
+  template <typename MAPPED_T>
+  using KeyMap = std::unordered_map<KeyType, MAPPED_T, Hash>;
   // When the key type is state. this is v(s) when the key type is (s,a) this
   // q(s, a) the q_table.
-  using type = std::unordered_map<KeyType, ValueType, Hash>;
+  using type = KeyMap<ValueType>;
 };
 
+/// @brief Open addressing tables, see utils::FlatHashMap. One array of entries
+/// in place of a heap node per key.
+template <isValueFunctionKeymaker KEYMAPPER_T, isValue VALUE_T>
+struct FlatFiniteValueFunctionMapGetter {
+  using KeyMaker = KEYMAPPER_T;
+  using KeyType = typename KeyMaker::KeyType;
+  using ValueType = VALUE_T;
+  using Hash = typename KeyMaker::Hash;
+  template <typename MAPPED_T>
+  using KeyMap = utils::FlatHashMap<KeyType, MAPPED_T, Hash>;
+  using type = KeyMap<ValueType>;
+};
+
+namespace detail {
+/// @brief The order of actions for breaking ties between equal values, the
+/// spec index where the action spec is finite.
+template <typename ACTION_T>
+std::size_t actionOrder(const ACTION_T &action) {
+  if constexpr (requires { spec::toIndex<typename ACTION_T::SpecType>(action); })
+    return spec::toIndex<typename ACTION_T::SpecType>(action);
+  else
+    return 0;
+}
+} // namespace detail
+
+/// @brief Tables holding the action values of a state in a row, which find the
+/// best action of a state themselves (see DenseValueTable::rowArgmax).
+template <typename T>
+concept hasRowArgmax = requires(const T &table, std::size_t stateIdx, std::uint8_t *allowed) {
+  table.rowArgmax(stateIdx, allowed);
+};
+
+/// @brief Row tables that also keep the argmax and the number of entries of
+/// every row.
+template <typename T>
+concept hasCachedRowArgmax = hasRowArgmax<T> and requires(const T &table, std::size_t stateIdx) {
+  table.rowArgmax(stateIdx);
+  table.rowSize(stateIdx);
+};
+
+/**
+ * @brief A value function held in a table from keys to values.
+ *
+ * @tparam MAP_GETTER_T Gives the table type from the keymaker and value type.
+ * An unordered_map by default, see DenseFiniteValueFunctionMapGetter for an
+ * array indexed by the keys of a finite spec.
+ */
 template <
     isValueFunction VALUE_FUNCTION_T,
-    isStepSizeTaker INCREMENTAL_STEPSIZE_T = weighted_average_step_size_taker<typename VALUE_FUNCTION_T::ValueType>>
+    isStepSizeTaker INCREMENTAL_STEPSIZE_T = weighted_average_step_size_taker<typename VALUE_FUNCTION_T::ValueType>,
+    template <typename, typename> typename MAP_GETTER_T = FiniteValueFunctionMapGetter>
 struct FiniteValueFunction
     : virtual VALUE_FUNCTION_T,
-      virtual FiniteValueFunctionMapGetter<typename VALUE_FUNCTION_T::KeyMaker, typename VALUE_FUNCTION_T::ValueType>::
-          type {
+      virtual MAP_GETTER_T<typename VALUE_FUNCTION_T::KeyMaker, typename VALUE_FUNCTION_T::ValueType>::type {
 
 public:
   SETUP_TYPES_FROM_NESTED_ENVIRON(SINGLE_ARG(VALUE_FUNCTION_T::EnvironmentType));
@@ -39,11 +97,11 @@ public:
   using KeyMaker = typename VALUE_FUNCTION_T::KeyMaker;
   using KeyType = typename KeyMaker::KeyType;
   using ValueType = typename VALUE_FUNCTION_T::ValueType;
-  using ValueTableType =
-      typename FiniteValueFunctionMapGetter<typename VALUE_FUNCTION_T::KeyMaker, typename VALUE_FUNCTION_T::ValueType>::
-          type;
+  using ValueTableType = typename MAP_GETTER_T<KeyMaker, ValueType>::type;
+  template <typename MAPPED_T>
+  using KeyMapType = typename MAP_GETTER_T<KeyMaker, ValueType>::template KeyMap<MAPPED_T>;
   using StepSizeTaker = INCREMENTAL_STEPSIZE_T;
-  using ValueFunctionType = FiniteValueFunction<VALUE_FUNCTION_T, INCREMENTAL_STEPSIZE_T>;
+  using ValueFunctionType = FiniteValueFunction<VALUE_FUNCTION_T, INCREMENTAL_STEPSIZE_T, MAP_GETTER_T>;
 
   constexpr static auto iterations = 1000;
   typename ValueType::Factory valueFactory{};
@@ -57,6 +115,12 @@ public:
   /// type being held within the valueEstimates table. value is always a member.
   virtual PrecisionType valueAt(const KeyType &s);
   virtual PrecisionType valueAt(const EnvironmentType &e, const StateType &s, const ActionSpace &a);
+  /// @brief The value of a key, or the initial value when it has no entry,
+  /// without making one. Safe for concurrent readers of every table type as
+  /// long as nothing writes the table meanwhile.
+  virtual PrecisionType valueAtOrInitial(const KeyType &k) const;
+  PrecisionType valueAtOrInitial(const EnvironmentType &e, const StateType &s, const ActionSpace &a) const;
+  PrecisionType maxValueAt(const EnvironmentType &e, const StateType &s) const;
 
   using VALUE_FUNCTION_T::operator();
   ValueType operator()(const KeyType &k) const override;
@@ -69,21 +133,78 @@ public:
 
 /// @brief Extra getter to yield the value no matter the underlying
 /// type being held within the valueEstimates table. value is always a member.
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::valueAt(const KeyType &s) -> PrecisionType {
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::valueAt(const KeyType &s) -> PrecisionType {
+  // Found through the const table so that reading does not count as a write
+  const auto &table = static_cast<const ValueTableType &>(*this);
+  if (const auto it = table.find(s); it != table.end())
+    return it->second.value;
   return this->emplace(s, valueFactory.create(this->initial_value, 1)).first->second.value;
 }
 
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::valueAt(const EnvironmentType &e, const StateType &s, const ActionSpace &a)
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::valueAtOrInitial(const KeyType &k) const -> PrecisionType {
+  const auto &table = static_cast<const ValueTableType &>(*this);
+  if (const auto it = table.find(k); it != table.end())
+    return it->second.value;
+  return this->initial_value;
+}
+
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::valueAtOrInitial(const EnvironmentType &e, const StateType &s, const ActionSpace &a)
+    const -> PrecisionType {
+  return this->valueAtOrInitial(KeyMaker::make(e, s, a));
+}
+
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::valueAt(const EnvironmentType &e, const StateType &s, const ActionSpace &a)
     -> PrecisionType {
   return this->valueAt(KeyMaker::make(e, s, a));
 }
 
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::initialize(EnvironmentType &environment) -> void {
+/**
+ * @brief The largest value over the reachable actions of s, those without an
+ * entry counting at the initial value. Nothing is inserted.
+ *
+ * @details Tables with a cached row argmax read the value of the argmax when
+ * every action of the row has an entry, as it then is the same maximum.
+ */
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::maxValueAt(const EnvironmentType &e, const StateType &s) const -> PrecisionType {
+  if constexpr (hasCachedRowArgmax<ValueTableType>) {
+    using KeyIndex = typename ValueTableType::KeyIndex;
+    if (this->rowSize(KeyIndex::stateIndex(s)) == KeyIndex::nActions)
+      return this->valueAtOrInitial(this->getArgmaxKey(e, s));
+  }
+  auto best = std::numeric_limits<PrecisionType>::lowest();
+  for (const auto &action : e.getReachableActions(s))
+    best = std::max(best, this->valueAtOrInitial(KeyMaker::make(e, s, action)));
+  return best;
+}
+
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::initialize(EnvironmentType &environment) -> void {
+
+  if constexpr (environment::InitialStateEnvironment<EnvironmentType>) {
+    /// Only states reachable from where the environment starts can ever be
+    /// seen, so no entries are made for the rest.
+    for (const auto &state : environment::reachableStates(environment)) {
+      for (const auto &action : environment.getReachableActions(state)) {
+        this->valueAt(KeyMaker::make(environment, state, action));
+      }
+    }
+
+  } else if constexpr (environment::SpecEnumerableEnvironment<EnvironmentType>) {
+    /// Every value of the observable spec is a state so sweep them lazily in
+    /// index order rather than materialising the set of all states.
+    for (const auto &observable : spec::values<typename StateType::ObservableSpecType>()) {
+      const auto state = StateType(observable, spec::default_spec_gen<typename StateType::HiddenSpecType>());
+      for (const auto &action : environment.getReachableActions(state)) {
+        this->valueAt(KeyMaker::make(environment, state, action));
+      }
+    }
 
-  if constexpr (environment::FullyKnownConditionalStateActionEnvironment<EnvironmentType>) {
+  } else if constexpr (environment::FullyKnownConditionalStateActionEnvironment<EnvironmentType>) {
     /// Since we know the model well enough to ask the environment to generate
     /// all possible states we do so.
     for (const auto &state : environment.getAllPossibleStates()) {
@@ -106,19 +227,19 @@ auto FiniteValueFunction<V, S>::initialize(EnvironmentType &environment) -> void
   }
 }
 
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::operator()(const KeyType &k) const -> ValueType {
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::operator()(const KeyType &k) const -> ValueType {
   return this->at(k);
 }
 
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::operator()(const EnvironmentType &e, const StateType &s, const ActionSpace &a)
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::operator()(const EnvironmentType &e, const StateType &s, const ActionSpace &a)
     -> ValueType {
   return operator()(KeyMaker::make(e, s, a));
 }
 
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::incrementalUpdate(const EnvironmentType &e, const TransitionType &s) -> void {
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::incrementalUpdate(const EnvironmentType &e, const TransitionType &s) -> void {
 
   // Reward for this transition
   auto reward = RewardType::reward(s);
@@ -137,36 +258,83 @@ auto FiniteValueFunction<V, S>::incrementalUpdate(const EnvironmentType &e, cons
   this->valueFactory.update();
 }
 
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::prettyPrint() -> void {
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::prettyPrint() -> void {
   for (const auto &[key, value] : *this) {
     std::cout << key << " : " << this->valueAt(key) << std::endl;
   }
 }
 
-template <isValueFunction V, isStepSizeTaker S>
-auto FiniteValueFunction<V, S>::getArgmaxKey(const EnvironmentType &e, const StateType &s) const -> KeyType {
-  auto availableActions = e.getReachableActions(s);
-  auto maxIdx = std::max_element(this->begin(), this->end(), [&e, &availableActions](const auto &p1, const auto &p2) {
-    if (availableActions.find(KeyMaker::get_action_from_key(e, p2.first)) != availableActions.end())
-      return p1.second < p2.second;
-    return false;
-  });
-
-  if (maxIdx == this->end())
+/**
+ * @brief The key of the largest value among the reachable actions of s, the
+ * lowest action index on ties.
+ *
+ * @details Only the keys of s are looked up, so this is O(|A|) rather than a
+ * pass over the table. Tables with a row of action values per state (see
+ * DenseValueTable::rowArgmax) take the argmax over the row directly, or
+ * read the cached argmax of the row when they keep one. That is O(1) when the
+ * environment checks a single action without listing the reachable ones, as
+ * MarkovDecisionEnvironment does. Actions with no entry are skipped and when
+ * none has an entry a reachable action is returned.
+ */
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+auto FiniteValueFunction<V, S, M>::getArgmaxKey(const EnvironmentType &e, const StateType &s) const -> KeyType {
+
+  if constexpr (hasRowArgmax<ValueTableType>) {
+    using KeyIndex = typename ValueTableType::KeyIndex;
+    const auto stateIdx = KeyIndex::stateIndex(s);
+    if constexpr (hasCachedRowArgmax<ValueTableType>) {
+      // The best present entry is the answer whenever its action is reachable
+      if (const auto best = this->rowArgmax(stateIdx); best != KeyIndex::nActions) {
+        const auto key = KeyIndex::key(stateIdx * KeyIndex::nActions + best);
+        if (e.isReachableAction(s, KeyMaker::get_action_from_key(e, key)))
+          return key;
+      }
+    }
+    const auto availableActions = e.getReachableActions(s);
+    auto allowed = std::array<std::uint8_t, KeyIndex::nActions>{};
+    for (const auto &action : availableActions)
+      allowed[KeyIndex::actionIndex(action)] = 1;
+    if (const auto best = this->rowArgmax(stateIdx, allowed.data()); best != KeyIndex::nActions)
+      return KeyIndex::key(stateIdx * KeyIndex::nActions + best);
     return KeyMaker::make(e, s, *availableActions.begin()); // or throw a runtime error here...
 
-  return maxIdx->first;
+  } else {
+    const auto availableActions = e.getReachableActions(s);
+    auto best = this->end();
+    auto bestOrder = std::size_t(0);
+    for (const auto &action : availableActions) {
+      const auto it = this->find(KeyMaker::make(e, s, action));
+      if (it == this->end())
+        continue;
+      const auto itOrder = detail::actionOrder(action);
+      if (best == this->end() or best->second.value < it->second.value or
+          (best->second.value == it->second.value and itOrder < bestOrder)) {
+        best = it;
+        bestOrder = itOrder;
+      }
+    }
+    if (best != this->end())
+      return best->first;
+    return KeyMaker::make(e, s, *availableActions.begin()); // or throw a runtime error here...
+  }
 }
 
 #define SETUP_FINITE_VALUE_FUNCTION_TYPES(VALUE_FN_T, VALUE_T)                                                         \
   SETUP_VALUE_FUNCTION_TYPES(SINGLE_ARG(VALUE_FN_T));                                                                  \
   using ValueType = VALUE_T;
 
+namespace detail {
+template <isValueFunction V, isStepSizeTaker S, template <typename, typename> typename M>
+std::true_type derivesFiniteValueFunction(const FiniteValueFunction<V, S, M> *);
+std::false_type derivesFiniteValueFunction(const void *);
+} // namespace detail
+
+/// @brief Any FiniteValueFunction, whatever its step size taker and table.
 template <typename T>
-concept isFiniteStateValueFunction = std::is_base_of_v<FiniteValueFunction<typename T::ValueFunctionBaseType>, T>;
+concept isFiniteValueFunction = decltype(detail::derivesFiniteValueFunction(std::declval<T *>()))::value;
 template <typename T>
-concept isFiniteValueFunction = std::is_base_of_v<FiniteValueFunction<typename T::ValueFunctionBaseType>, T>;
+concept isFiniteStateValueFunction = isFiniteValueFunction<T>;
 
 template <
     isValueFunctionKeymaker KEYMAPPER_T,
@@ -201,4 +369,29 @@ template <
 requires isFiniteValueTemplate<VALUE_C>
 using FiniteActionValueFunction = FiniteValueFunction<ActionValueFunction<E, INITIAL_VALUE, DISCOUNT_RATE, VALUE_C>>;
 
+/// @brief A FiniteValueFunction over an open addressing table.
+template <
+    isValueFunction VALUE_FUNCTION_T,
+    isStepSizeTaker INCREMENTAL_STEPSIZE_T = weighted_average_step_size_taker<typename VALUE_FUNCTION_T::ValueType>>
+using FlatFiniteValueFunction =
+    FiniteValueFunction<VALUE_FUNCTION_T, INCREMENTAL_STEPSIZE_T, FlatFiniteValueFunctionMapGetter>;
+
+template <
+    environment::FiniteEnvironmentType E,
+    auto INITIAL_VALUE = 0.0F,
+    auto DISCOUNT_RATE = 0.0F,
+    template <typename> typename VALUE_C = FiniteValue>
+requires isFiniteValueTemplate<VALUE_C>
+using FlatFiniteStateActionValueFunction =
+    FlatFiniteValueFunction<StateActionValueFunction<E, INITIAL_VALUE, DISCOUNT_RATE, VALUE_C>>;
+
+template <
+    environment::FiniteEnvironmentType E,
+    auto INITIAL_VALUE = 0.0F,
+    auto DISCOUNT_RATE = 0.0F,
+    template <typename> typename VALUE_C = FiniteValue>
+requires isFiniteValueTemplate<VALUE_C>
+using FlatFiniteStateValueFunction =
+    FlatFiniteValueFunction<StateValueFunction<E, INITIAL_VALUE, DISCOUNT_RATE, VALUE_C>>;
+
 } // namespace policy::objectives
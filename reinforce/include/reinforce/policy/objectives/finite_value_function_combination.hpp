@@ -1,5 +1,6 @@
 #pragma once
-#include <ranges>
+#include <cstddef>
+#include <limits>
 #include <type_traits>
 
 #include "reinforce/policy/objectives/finite_value_function.hpp"
@@ -27,10 +28,8 @@ struct AdditiveFiniteValueFunctionCombination : AdditiveValueFunctionCombination
   using BaseType::initialize;
   ValueType operator()(const KeyType &k) const override;
   PrecisionType valueAt(const KeyType &k) override;
+  PrecisionType valueAtOrInitial(const KeyType &k) const override;
   KeyType getArgmaxKey(const EnvironmentType &e, const StateType &s) const override;
-
-  ValueTableType createTemporaryValueTable() const;
-  KeyType getMaxKeyFromTable(const EnvironmentType &e, const StateType &s, const ValueTableType &v) const;
 };
 
 template <isFiniteValueFunction... T>
@@ -52,48 +51,37 @@ auto AdditiveFiniteValueFunctionCombination<T...>::valueAt(const KeyType &k) ->
 }
 
 template <isFiniteValueFunction... T>
-auto AdditiveFiniteValueFunctionCombination<T...>::getArgmaxKey(const EnvironmentType &e, const StateType &s) const
-    -> KeyType {
-
-  const auto tmpValueFunction = this->createTemporaryValueTable();
-  auto filteredTable = std::views::filter(tmpValueFunction, [&e, &s](const auto &p) {
-    return e.isReachableAction(s, KeyMaker::get_action_from_key(e, p.first));
-  });
-  const auto key = this->getMaxKeyFromTable(e, s, tmpValueFunction);
-  return key;
-}
-
-/** @brief Construct an additive construction of all value functions in this combination
- * @details Construct an in memory additive value function by incrementally adding each value function
- *  to the previous one. Then fill up the possible keys as a combination of the keys of each value function.
- *  This gives us the value of each possible action in the state.
- */
-template <isFiniteValueFunction... T>
-auto AdditiveFiniteValueFunctionCombination<T...>::createTemporaryValueTable() const -> ValueTableType {
-
-  auto tmpValueFunction = ValueTableType();
-  const auto inserter = [&tmpValueFunction](const auto &k) -> void { tmpValueFunction[k.first] += k.second; };
-  std::apply(
-      [&tmpValueFunction, &inserter](const auto &...vFuncts) {
-        (..., (std::for_each(vFuncts.begin(), vFuncts.end(), inserter)));
-      },
+auto AdditiveFiniteValueFunctionCombination<T...>::valueAtOrInitial(const KeyType &k) const -> PrecisionType {
+  return std::apply(
+      [&k](const auto &...valueFunctions) { return (PrecisionType(0) + ... + valueFunctions.valueAtOrInitial(k)); },
       this->valueFunctions);
-  return tmpValueFunction;
 }
 
-/** @brief For the provided valueTable find the maximum key */
+/** @brief The reachable action of s with the largest summed value, the lowest
+ * action index on ties. Each value function is read without inserting, a
+ * missing key counting at its initial value, so no table is built.
+ */
 template <isFiniteValueFunction... T>
-auto AdditiveFiniteValueFunctionCombination<T...>::getMaxKeyFromTable(
-    const EnvironmentType &e, const StateType &s, const ValueTableType &tmpValueFunction) const -> KeyType {
-
-  auto maxIdx = std::max_element(tmpValueFunction.begin(), tmpValueFunction.end(), [](const auto &p1, const auto &p2) {
-    return p1.second < p2.second;
-  });
-
-  if (maxIdx == tmpValueFunction.end())
-    return KeyMaker::make(e, s, *e.getReachableActions(s).begin()); // or throw a runtime error here...
+auto AdditiveFiniteValueFunctionCombination<T...>::getArgmaxKey(const EnvironmentType &e, const StateType &s) const
+    -> KeyType {
 
-  return maxIdx->first;
+  const auto availableActions = e.getReachableActions(s);
+  auto bestKey = KeyMaker::make(e, s, *availableActions.begin());
+  auto bestValue = std::numeric_limits<PrecisionType>::lowest();
+  auto bestOrder = std::size_t(0);
+  auto found = false;
+  for (const auto &action : availableActions) {
+    const auto key = KeyMaker::make(e, s, action);
+    const auto value = this->valueAtOrInitial(key);
+    const auto order = detail::actionOrder(action);
+    if (not found or value > bestValue or (value == bestValue and order < bestOrder)) {
+      found = true;
+      bestKey = key;
+      bestValue = value;
+      bestOrder = order;
+    }
+  }
+  return bestKey;
 }
 
 template <typename... T>
@@ -6,6 +6,7 @@
 #include "reinforce/dummy_environment.hpp"
 #include "reinforce/environment.hpp"
 #include "reinforce/spec.hpp"
+#include "reinforce/spec/packed.hpp"
 
 namespace policy::objectives {
 
@@ -68,13 +69,41 @@ struct StateActionKeymaker
   }
   static StateType get_state_from_key(const EnvironmentType &e, const KeyType &key) { return key.first; }
   static ActionSpace get_action_from_key(const EnvironmentType &e, const KeyType &key) { return key.second; }
-  static std::size_t hash(const KeyType &key) { return key.first.hash() ^ key.second.hash(); }
+  static std::size_t hash(const KeyType &key) { return spec::hashCombine(key.first.hash(), key.second.hash()); }
 
   struct Hash {
     std::size_t operator()(const KeyType &key) const { return StateActionKeymaker::hash(key); }
   };
 };
 
+// A StateActionKeymaker storing both halves of the key bit packed. Only the
+// observable part of the state is kept, matching State equality, so a key is a
+// couple of machine words whose equality and hash are integer operations.
+template <environment::EnvironmentType ENVIRON_T>
+struct PackedStateActionKeymaker : StateActionKeymaker<ENVIRON_T> {
+
+  SETUP_TYPES(SINGLE_ARG(StateActionKeymaker<ENVIRON_T>))
+  using EnvironmentType = ENVIRON_T;
+  using PackedStateType = spec::PackedCompositeArray<typename StateType::ObservableSpecType>;
+  using PackedActionType = spec::PackedCompositeArray<typename ActionSpace::SpecType>;
+  using KeyType = std::pair<PackedStateType, PackedActionType>;
+
+  static KeyType make(const EnvironmentType &e, const StateType &s, const ActionSpace &action) {
+    return std::make_pair(PackedStateType(s.observable), PackedActionType(action));
+  }
+  static StateType get_state_from_key(const EnvironmentType &e, const KeyType &key) {
+    return StateType(key.first.unpack(), spec::default_spec_gen<typename StateType::HiddenSpecType>());
+  }
+  static ActionSpace get_action_from_key(const EnvironmentType &e, const KeyType &key) {
+    return ActionSpace(key.second.unpack());
+  }
+  static std::size_t hash(const KeyType &key) { return spec::hashCombine(key.first.hash(), key.second.hash()); }
+
+  struct Hash {
+    std::size_t operator()(const KeyType &key) const { return PackedStateActionKeymaker::hash(key); }
+  };
+};
+
 template <typename T>
 concept isStateActionKeymaker = std::is_base_of_v<StateActionKeymaker<typename T::EnvironmentType>, T>;
 
@@ -8,7 +8,9 @@
 #include "reinforce/action.hpp"
 #include "reinforce/environment.hpp"
 #include "reinforce/policy/policy.hpp"
+#include "reinforce/rng/engine.hpp"
 #include "reinforce/spec.hpp"
+#include "reinforce/spec/batch.hpp"
 
 namespace policy {
 
@@ -21,9 +23,9 @@ using spec::CompositeArraySpecType;
 using spec::isBoundedArraySpec;
 using spec::isCategoricalArraySpec;
 
-template <isBoundedArraySpec T, class E = xt::random::default_engine_type>
+template <isBoundedArraySpec T, class E = rng::Engine>
 std::enable_if_t<isBoundedArraySpec<T>, typename T::DataType>
-random_spec_gen(E &engine = xt::random::get_default_random_engine()) {
+random_spec_gen(E &engine = rng::threadEngine()) {
 
   if constexpr (std::is_integral_v<typename T::ValueType>)
     return xt::random::randint(T::shape, T::min, T::max, engine);
@@ -35,16 +37,16 @@ random_spec_gen(E &engine = xt::random::get_default_random_engine()) {
     return xt::zeros(T::shape);
 };
 
-template <isCategoricalArraySpec T, class E = xt::random::default_engine_type>
+template <isCategoricalArraySpec T, class E = rng::Engine>
 std::enable_if_t<isCategoricalArraySpec<T>, typename T::DataType>
-random_spec_gen(E &engine = xt::random::get_default_random_engine()) {
+random_spec_gen(E &engine = rng::threadEngine()) {
   return xt::random::randint(T::shape, T::min, T::max, engine);
 };
 
-template <CompositeArraySpecType T, class E = xt::random::default_engine_type>
+template <CompositeArraySpecType T, class E = rng::Engine>
 requires CompositeArraySpecType<T>
 std::enable_if_t<CompositeArraySpecType<T>, typename T::DataType>
-random_spec_gen(E &engine = xt::random::get_default_random_engine()) {
+random_spec_gen(E &engine = rng::threadEngine()) {
 
   // Tuple of the random types
   return [&engine]<std::size_t... N>(std::index_sequence<N...>) {
@@ -52,6 +54,41 @@ random_spec_gen(E &engine = xt::random::get_default_random_engine()) {
   }(std::make_index_sequence<std::tuple_size_v<typename T::tupleType>>());
 }
 
+// Batched generation draws every entry of every sample independently from
+// [min, max) directly into the contiguous element tensors.
+
+template <spec::isBatch B, class E>
+B random_batch_fill(B batch, E &engine) {
+  [&]<std::size_t... K>(std::index_sequence<K...>) {
+    (
+        [&] {
+          using ElementSpec = typename B::template ElementSpecType<K>;
+          using ValueType = typename ElementSpec::DataType::value_type;
+          auto &element = std::get<K>(batch);
+          if constexpr (std::is_integral_v<ValueType>) {
+            auto distribution = std::uniform_int_distribution<long long>(
+                static_cast<long long>(ElementSpec::min), static_cast<long long>(ElementSpec::max) - 1);
+            std::generate(element.begin(), element.end(), [&] { return static_cast<ValueType>(distribution(engine)); });
+          } else {
+            auto distribution = std::uniform_real_distribution<ValueType>(ElementSpec::min, ElementSpec::max);
+            std::generate(element.begin(), element.end(), [&] { return distribution(engine); });
+          }
+        }(),
+        ...);
+  }(std::make_index_sequence<B::nElements>());
+  return batch;
+}
+
+template <spec::isFixedBatch B, class E = rng::Engine>
+B random_spec_gen(E &engine = rng::threadEngine()) {
+  return random_batch_fill(B(), engine);
+}
+
+template <spec::isDynamicBatch B, class E = rng::Engine>
+B random_spec_gen(std::size_t n, E &engine = rng::threadEngine()) {
+  return random_batch_fill(B(n), engine);
+}
+
 template <environment::EnvironmentType E>
 struct RandomPolicy : virtual Policy<E>, virtual PolicyDistributionMixin<E> {
 
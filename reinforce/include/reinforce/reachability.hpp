@@ -0,0 +1,50 @@
+#pragma once
+
+#include <concepts>
+#include <deque>
+#include <unordered_set>
+
+#include "reinforce/environment.hpp"
+
+// Most finite environments can be started from only part of their state space,
+// and can only ever reach part of the rest. An environment that knows which
+// states reset() can return declares them with
+//
+//   std::unordered_set<StateType, typename StateType::Hash> getInitialStates() const;
+//
+// Value functions are then initialised, and the dynamic programming solvers
+// sweep, only over the states reachable from them. Environments without it are
+// treated as though every state were relevant.
+namespace environment {
+
+template <typename T>
+concept InitialStateEnvironment = FiniteEnvironmentType<T> && requires(const T t) {
+  { t.getInitialStates() } -> std::same_as<std::unordered_set<typename T::StateType, typename T::StateType::Hash>>;
+};
+
+/**
+ * @brief Every state reachable from the initial states of the environment, the
+ * initial states included.
+ *
+ * @details A breadth first search over getReachableActions and
+ * getReachableStates. For a MarkovDecisionEnvironment prefer
+ * IndexedTransitionModel::reachable which searches by index.
+ */
+template <InitialStateEnvironment E>
+std::unordered_set<typename E::StateType, typename E::StateType::Hash> reachableStates(const E &environment) {
+  auto states = environment.getInitialStates();
+  auto queue = std::deque<typename E::StateType>(states.begin(), states.end());
+  while (not queue.empty()) {
+    const auto state = queue.front();
+    queue.pop_front();
+    for (const auto &action : environment.getReachableActions(state)) {
+      for (const auto &next : environment.getReachableStates(state, action)) {
+        if (states.insert(next).second)
+          queue.push_back(next);
+      }
+    }
+  }
+  return states;
+}
+
+} // namespace environment
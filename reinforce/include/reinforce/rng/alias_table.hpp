@@ -0,0 +1,185 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "reinforce/rng/engine.hpp"
+
+namespace rng {
+
+/// @brief A uniform draw from {0, ..., n - 1} using Lemire's multiply and
+/// reject method. Costs one engine draw and no division in the common case.
+template <class E = Engine>
+std::size_t uniformIndex(std::size_t n, E &engine = threadEngine()) {
+  static_assert(E::max() == std::numeric_limits<std::uint64_t>::max(), "uniformIndex needs a full 64 bit engine");
+  const auto bound = static_cast<std::uint64_t>(n);
+  auto product = static_cast<unsigned __int128>(engine()) * bound;
+  auto low = static_cast<std::uint64_t>(product);
+  if (low < bound) {
+    const auto threshold = -bound % bound;
+    while (low < threshold) {
+      product = static_cast<unsigned __int128>(engine()) * bound;
+      low = static_cast<std::uint64_t>(product);
+    }
+  }
+  return static_cast<std::size_t>(product >> 64);
+}
+
+namespace detail {
+
+/// @brief Why the weights cannot be sampled from, or nullptr when they can.
+template <typename PrecisionType>
+const char *alias_weights_error(std::span<const PrecisionType> weights) {
+  PrecisionType total = 0;
+  for (const auto &w : weights) {
+    if (!(w >= 0))
+      return "AliasTable weights must be non negative";
+    total += w;
+  }
+  if (!(total > 0))
+    return "AliasTable weights must have a positive sum";
+  return nullptr;
+}
+
+/// @brief Vose's construction over valid weights. On entry cutoff holds the
+/// weights; on exit cutoff and alias hold the table, indexed from 0. small
+/// and large are scratch space, reused between calls.
+template <typename PrecisionType>
+void build_alias(
+    std::span<PrecisionType> cutoff,
+    std::span<std::size_t> alias,
+    std::vector<std::size_t> &small,
+    std::vector<std::size_t> &large) {
+  const auto n = cutoff.size();
+  PrecisionType total = 0;
+  for (const auto &w : cutoff)
+    total += w;
+
+  small.clear();
+  large.clear();
+  for (std::size_t i = 0; i < n; ++i) {
+    cutoff[i] *= static_cast<PrecisionType>(n) / total;
+    alias[i] = i;
+    (cutoff[i] < 1 ? small : large).push_back(i);
+  }
+
+  while (!small.empty() && !large.empty()) {
+    const auto s = small.back();
+    const auto l = large.back();
+    small.pop_back();
+    alias[s] = l;
+    cutoff[l] -= 1 - cutoff[s];
+    if (cutoff[l] < 1) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  // Whatever remains only differs from 1 by rounding
+  for (const auto i : large)
+    cutoff[i] = 1;
+  for (const auto i : small)
+    cutoff[i] = 1;
+}
+
+} // namespace detail
+
+/**
+ * @brief Walker's alias method for sampling an index in proportion to a set of
+ * non negative weights.
+ *
+ * @details Construction is O(n) (Vose's variant). Each sample costs one
+ * uniform index, one uniform real and a comparison, and never allocates. The
+ * table is immutable once built so a single table can be shared between
+ * threads as long as each uses its own engine.
+ */
+template <typename PrecisionType = double>
+class AliasTable {
+public:
+  AliasTable() = default;
+
+  template <std::ranges::input_range R>
+  explicit AliasTable(const R &weights) {
+    for (const auto &w : weights)
+      cutoff.push_back(static_cast<PrecisionType>(w));
+    if (const auto error = detail::alias_weights_error<PrecisionType>(cutoff))
+      throw std::runtime_error(error);
+
+    alias.resize(cutoff.size());
+    auto small = std::vector<std::size_t>{};
+    auto large = std::vector<std::size_t>{};
+    detail::build_alias<PrecisionType>(cutoff, alias, small, large);
+  }
+
+  std::size_t size() const { return cutoff.size(); }
+  bool empty() const { return cutoff.empty(); }
+
+  template <class E = Engine>
+  std::size_t operator()(E &engine = threadEngine()) const {
+    const auto i = uniformIndex(cutoff.size(), engine);
+    return uniform<PrecisionType>(engine) < cutoff[i] ? i : alias[i];
+  }
+
+private:
+  std::vector<PrecisionType> cutoff;
+  std::vector<std::size_t> alias;
+};
+
+/**
+ * @brief One alias table per row of weights stored back to back in compressed
+ * row form, as in the rows of an IndexedTransitionModel. Row r covers the
+ * weights [offsets[r], offsets[r + 1]) and samples an index within the row.
+ *
+ * @details Every table is built up front into two arrays aligned with the
+ * weights, so the tables are immutable and can be shared between threads like
+ * AliasTable. Rows that cannot be sampled, empty ones included, only throw
+ * when sampled.
+ */
+template <typename PrecisionType = double>
+class RowAliasTables {
+public:
+  RowAliasTables() = default;
+
+  template <typename WEIGHT_T>
+  RowAliasTables(std::span<const std::size_t> offsets, std::span<const WEIGHT_T> weights)
+      : offsets(offsets.begin(), offsets.end()),
+        cutoff(weights.begin(), weights.end()),
+        alias(weights.size()),
+        valid(offsets.empty() ? 0 : offsets.size() - 1) {
+    auto small = std::vector<std::size_t>{};
+    auto large = std::vector<std::size_t>{};
+    for (std::size_t r = 0; r < nRows(); ++r) {
+      const auto begin = this->offsets[r];
+      const auto n = this->offsets[r + 1] - begin;
+      const auto rowCutoff = std::span<PrecisionType>(cutoff).subspan(begin, n);
+      valid[r] = n > 0 and detail::alias_weights_error<PrecisionType>(rowCutoff) == nullptr;
+      if (valid[r])
+        detail::build_alias<PrecisionType>(rowCutoff, std::span<std::size_t>(alias).subspan(begin, n), small, large);
+    }
+  }
+
+  std::size_t nRows() const { return valid.size(); }
+  std::size_t size(std::size_t r) const { return offsets[r + 1] - offsets[r]; }
+
+  /// @brief An index within row r, drawn in proportion to its weights.
+  template <class E = Engine>
+  std::size_t operator()(std::size_t r, E &engine = threadEngine()) const {
+    if (not valid[r])
+      throw std::runtime_error("AliasTable row weights must be non negative with a positive sum");
+    const auto begin = offsets[r];
+    const auto i = uniformIndex(offsets[r + 1] - begin, engine);
+    return uniform<PrecisionType>(engine) < cutoff[begin + i] ? i : alias[begin + i];
+  }
+
+private:
+  std::vector<std::size_t> offsets;
+  std::vector<PrecisionType> cutoff;
+  std::vector<std::size_t> alias;
+  std::vector<std::uint8_t> valid;
+};
+
+} // namespace rng
@@ -0,0 +1,154 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace rng {
+
+// Library wide random number generation. Every environment, policy and sampler
+// draws from an Engine: a xoshiro256** generator with 32 bytes of state that is
+// cheap to construct, copy and split into independent streams. Engines handed
+// out by makeEngine are streams split from a single global seed so that runs
+// are reproducible once rng::seed has been called.
+
+constexpr std::uint64_t defaultSeed = 0x853c49e6748fea9bULL;
+
+/// @brief One step of splitmix64. Used to expand a single seed into a full
+/// generator state and to decorrelate stream ids.
+constexpr std::uint64_t splitmix64(std::uint64_t &state) {
+  std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief xoshiro256** (Blackman and Vigna). A 64 bit generator with a period of
+ * 2^256 - 1 that satisfies std::uniform_random_bit_generator so it can be used
+ * with the standard distributions and with xt::random.
+ *
+ * @details Independent streams can be made in two ways. jump advances the
+ * generator by 2^128 draws, giving non overlapping sequences. split derives a
+ * fresh generator from the current state and a stream id which is cheaper and
+ * does not need the streams to be created in order.
+ */
+class Xoshiro256StarStar {
+public:
+  using result_type = std::uint64_t;
+  using StateType = std::array<std::uint64_t, 4>;
+
+  constexpr explicit Xoshiro256StarStar(std::uint64_t seed = defaultSeed) { this->seed(seed); }
+  constexpr explicit Xoshiro256StarStar(const StateType &state) : s(state) {}
+
+  constexpr void seed(std::uint64_t seed) {
+    for (auto &w : s)
+      w = splitmix64(seed);
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  constexpr result_type operator()() {
+    const auto result = std::rotl(s[1] * 5, 7) * 9;
+    const auto t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = std::rotl(s[3], 45);
+    return result;
+  }
+
+  constexpr void discard(unsigned long long n) {
+    for (; n > 0; --n)
+      (*this)();
+  }
+
+  /// @brief Advance the generator by 2^128 draws.
+  constexpr void jump() {
+    constexpr auto polynomial =
+        StateType{0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+    auto next = StateType{};
+    for (const auto word : polynomial) {
+      for (int b = 0; b < 64; ++b) {
+        if (word & (std::uint64_t{1} << b)) {
+          for (std::size_t i = 0; i < next.size(); ++i)
+            next[i] ^= s[i];
+        }
+        (*this)();
+      }
+    }
+    s = next;
+  }
+
+  /// @brief A new generator for the given stream id. Distinct ids yield
+  /// statistically independent generators and this generator is unchanged.
+  constexpr Xoshiro256StarStar split(std::uint64_t stream) const {
+    auto h = s[0] ^ std::rotl(s[1], 16) ^ std::rotl(s[2], 32) ^ std::rotl(s[3], 48);
+    h ^= splitmix64(stream);
+    return Xoshiro256StarStar(h);
+  }
+
+  constexpr const StateType &state() const { return s; }
+
+  friend constexpr bool operator==(const Xoshiro256StarStar &lhs, const Xoshiro256StarStar &rhs) = default;
+
+private:
+  StateType s{};
+};
+
+using Engine = Xoshiro256StarStar;
+
+namespace detail {
+struct GlobalStreams {
+  std::atomic<std::uint64_t> seed{defaultSeed};
+  std::atomic<std::uint64_t> next{0};
+};
+
+inline GlobalStreams &globalStreams() {
+  static GlobalStreams streams;
+  return streams;
+}
+
+// Explicit stream ids are tagged so they never coincide with the sequential
+// streams handed out by makeEngine().
+constexpr std::uint64_t explicitStreamTag = std::uint64_t{1} << 63;
+} // namespace detail
+
+/// @brief Reseed the library. Engines made afterwards restart from stream 0.
+inline void seed(std::uint64_t seed) {
+  auto &streams = detail::globalStreams();
+  streams.seed = seed;
+  streams.next = 0;
+}
+
+/// @brief The next sequential stream split from the global seed.
+inline Engine makeEngine() {
+  auto &streams = detail::globalStreams();
+  return Engine(streams.seed.load()).split(streams.next.fetch_add(1));
+}
+
+/// @brief A stream chosen by the caller, for example one per worker thread.
+/// Unlike makeEngine the result does not depend on construction order.
+inline Engine makeEngine(std::uint64_t stream) {
+  return Engine(detail::globalStreams().seed.load()).split(stream | detail::explicitStreamTag);
+}
+
+/// @brief The engine owned by the calling thread. It is used wherever an
+/// engine isnt given explicitly and is created on first use.
+inline Engine &threadEngine() {
+  thread_local Engine engine = makeEngine();
+  return engine;
+}
+
+/// @brief A uniform draw from [0, 1).
+template <typename PrecisionType = double, class E = Engine>
+PrecisionType uniform(E &engine = threadEngine()) {
+  return std::uniform_real_distribution<PrecisionType>(0, 1)(engine);
+}
+
+} // namespace rng
@@ -1,6 +1,8 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <type_traits>
 #include <xtensor/xfixed.hpp>
@@ -95,6 +97,67 @@ concept AnyArraySpecType = isBoundedArraySpec<T> || isCategoricalArraySpec<T>;
 template <typename... T>
 concept AllElementsAnyArraySpecType = (AnyArraySpecType<T> && ...);
 
+// Counting helpers for finite array specs. Every entry of the array takes a
+// value in [min, max) so each entry contributes (max - min) possible values and
+// the array as a whole contributes that to the power of the number of entries.
+
+template <AnyArraySpecType T>
+constexpr std::size_t nEntries() {
+  std::size_t n = 1;
+  for (const auto d : T::dims)
+    n *= d;
+  return n;
+}
+
+template <AnyArraySpecType T>
+constexpr std::size_t entryRadix() {
+  return static_cast<std::size_t>(T::max - T::min);
+}
+
+template <AnyArraySpecType T>
+constexpr std::size_t nArrayValues() {
+  std::size_t n = 1;
+  for (std::size_t i = 0; i < nEntries<T>(); ++i)
+    n *= entryRadix<T>();
+  return n;
+}
+
+// Allocation free hashing. Raw bytes are mixed with 64 bit FNV-1a and the
+// hashes of separate objects are combined with the boost golden ratio mix.
+
+constexpr std::uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+constexpr std::uint64_t fnvPrime = 1099511628211ULL;
+
+inline std::size_t hashBytes(const unsigned char *bytes, std::size_t n, std::size_t seed = fnvOffsetBasis) {
+  std::uint64_t h = seed;
+  for (std::size_t i = 0; i < n; ++i) {
+    h ^= bytes[i];
+    h *= fnvPrime;
+  }
+  return static_cast<std::size_t>(h);
+}
+
+constexpr std::size_t hashCombine(std::size_t seed, std::size_t h) {
+  return seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// Hash the buffer of an xtensor_fixed. Floating point entries are hashed one at
+// a time so that -0.0 and 0.0, which compare equal, also hash equal.
+template <typename DATA_T>
+std::size_t hashArray(const DATA_T &data, std::size_t seed = fnvOffsetBasis) {
+  using ValueType = typename DATA_T::value_type;
+  if constexpr (std::is_floating_point_v<ValueType>) {
+    for (ValueType v : data) {
+      if (v == ValueType(0))
+        v = ValueType(0);
+      seed = hashBytes(reinterpret_cast<const unsigned char *>(&v), sizeof(ValueType), seed);
+    }
+    return seed;
+  } else {
+    return hashBytes(reinterpret_cast<const unsigned char *>(data.data()), data.size() * sizeof(ValueType), seed);
+  }
+}
+
 template <typename T>
 struct type_getter_bound {
   using type = typename T::ValueType;
@@ -121,11 +184,11 @@ struct CompositeArray : std::tuple<typename T::DataType...> {
   }
 
   std::size_t hash() const {
-    auto ss = std::stringstream();
-    ss << *this;
-    std::hash<std::string> hasher;
-    std::size_t h = hasher(ss.str());
-    return h;
+    return [this]<std::size_t... N>(std::index_sequence<N...>) {
+      std::size_t h = fnvOffsetBasis;
+      ((h = hashArray(std::get<N>(*this), h)), ...);
+      return h;
+    }(std::make_index_sequence<sizeof...(T)>());
   }
 
   friend bool operator==(const CompositeArray &lhs, const CompositeArray &rhs) {
@@ -157,7 +220,7 @@ struct CompositeArraySpec : std::tuple<T...> {
 
     else if constexpr (isFinite) {
       return [&]<std::size_t... N>(std::index_sequence<N...>) {
-        return ((std::tuple_element_t<N, tupleType>::max - std::tuple_element_t<N, tupleType>::min) * ...);
+        return (nArrayValues<std::tuple_element_t<N, tupleType>>() * ...);
       }(std::make_index_sequence<sizeof...(T)>());
     }
 
@@ -252,6 +315,131 @@ constant_spec_gen(const typename T::tupleValueType &value) {
   }(std::make_index_sequence<std::tuple_size_v<typename T::tupleType>>());
 }
 
+// Mixed radix indexing of finite specs. Every entry is a digit with radix
+// (max - min). Entries are read in row major order within an array and the
+// arrays of a composite are read in tuple order with the first being the most
+// significant. toIndex and fromIndex are inverses over [0, nPossibleValues()).
+
+template <AnyArraySpecType T>
+requires(T::isFinite)
+std::size_t toIndex(const typename T::DataType &data) {
+  constexpr auto radix = entryRadix<T>();
+  std::size_t index = 0;
+  for (const auto &v : data)
+    index = index * radix + static_cast<std::size_t>(v - T::min);
+  return index;
+}
+
+template <AnyArraySpecType T>
+requires(T::isFinite)
+typename T::DataType fromIndex(std::size_t index) {
+  using ValueType = typename T::DataType::value_type;
+  constexpr auto radix = entryRadix<T>();
+  auto data = typename T::DataType();
+  for (auto it = data.rbegin(); it != data.rend(); ++it) {
+    *it = static_cast<ValueType>(T::min + index % radix);
+    index /= radix;
+  }
+  return data;
+}
+
+template <CompositeArraySpecType T>
+requires(T::isFinite)
+std::size_t toIndex(const typename T::DataType &data) {
+  return [&data]<std::size_t... N>(std::index_sequence<N...>) {
+    std::size_t index = 0;
+    ((index = index * nArrayValues<std::tuple_element_t<N, typename T::tupleType>>() +
+              toIndex<std::tuple_element_t<N, typename T::tupleType>>(std::get<N>(data))),
+     ...);
+    return index;
+  }(std::make_index_sequence<std::tuple_size_v<typename T::tupleType>>());
+}
+
+template <CompositeArraySpecType T>
+requires(T::isFinite)
+typename T::DataType fromIndex(std::size_t index) {
+  return [index]<std::size_t... N>(std::index_sequence<N...>) mutable {
+    constexpr auto radices = std::array<std::size_t, sizeof...(N)>{
+        nArrayValues<std::tuple_element_t<N, typename T::tupleType>>()...};
+    auto digits = std::array<std::size_t, sizeof...(N)>{};
+    for (std::size_t i = sizeof...(N); i-- > 0;) {
+      digits[i] = index % radices[i];
+      index /= radices[i];
+    }
+    return typename T::DataType(fromIndex<std::tuple_element_t<N, typename T::tupleType>>(digits[N])...);
+  }(std::make_index_sequence<std::tuple_size_v<typename T::tupleType>>());
+}
+
+// Every value of a finite spec as a lazy random access range in index order.
+// Values are decoded with fromIndex on access so nothing is materialised and a
+// sweep of the range takes O(1) memory regardless of the size of the spec.
+
+template <typename T>
+concept FiniteSpecType = (AnyArraySpecType<T> || CompositeArraySpecType<T>)&&T::isFinite;
+
+template <FiniteSpecType T>
+constexpr std::size_t nSpecValues() {
+  if constexpr (CompositeArraySpecType<T>)
+    return T::nPossibleValues();
+  else
+    return nArrayValues<T>();
+}
+
+template <FiniteSpecType T>
+struct SpecValues {
+  using value_type = typename T::DataType;
+
+  struct iterator {
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = typename T::DataType;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+
+    std::size_t index = 0;
+
+    value_type operator*() const { return fromIndex<T>(index); }
+    value_type operator[](difference_type n) const { return fromIndex<T>(index + n); }
+
+    iterator &operator++() {
+      ++index;
+      return *this;
+    }
+    iterator operator++(int) { return iterator{index++}; }
+    iterator &operator--() {
+      --index;
+      return *this;
+    }
+    iterator operator--(int) { return iterator{index--}; }
+    iterator &operator+=(difference_type n) {
+      index += n;
+      return *this;
+    }
+    iterator &operator-=(difference_type n) {
+      index -= n;
+      return *this;
+    }
+    friend iterator operator+(iterator it, difference_type n) { return it += n; }
+    friend iterator operator+(difference_type n, iterator it) { return it += n; }
+    friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(const iterator &lhs, const iterator &rhs) {
+      return static_cast<difference_type>(lhs.index) - static_cast<difference_type>(rhs.index);
+    }
+    friend bool operator==(const iterator &lhs, const iterator &rhs) = default;
+    friend auto operator<=>(const iterator &lhs, const iterator &rhs) = default;
+  };
+
+  constexpr static std::size_t size() { return nSpecValues<T>(); }
+  constexpr iterator begin() const { return iterator{0}; }
+  constexpr iterator end() const { return iterator{size()}; }
+  value_type operator[](std::size_t i) const { return fromIndex<T>(i); }
+};
+
+template <FiniteSpecType T>
+constexpr SpecValues<T> values() {
+  return SpecValues<T>{};
+}
+
 // Turn spec into a tuple
 template <isBoundedArraySpec T>
 struct BoundedArray {
@@ -0,0 +1,203 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <xtensor/xfixed.hpp>
+#include <xtensor/xtensor.hpp>
+
+#include "reinforce/spec.hpp"
+
+namespace spec {
+
+// Structure of arrays storage for many samples of a composite spec. Each tuple
+// element is held as one contiguous tensor whose leading dimension indexes the
+// sample, so element k of sample i lives in the i-th row of std::get<k>(batch).
+// With a compile time batch size the element tensors are xtensor_fixed, with
+// dynamicBatchSize they are xtensor and the size is given at construction.
+
+constexpr std::size_t dynamicBatchSize = std::numeric_limits<std::size_t>::max();
+
+template <std::size_t N, typename SHAPE_T>
+struct BatchShapeGetter;
+
+template <std::size_t N, std::size_t... DIMS>
+struct BatchShapeGetter<N, xt::xshape<DIMS...>> {
+  using type = xt::xshape<N, DIMS...>;
+};
+
+template <AnyArraySpecType T, std::size_t N>
+struct BatchArrayGetter {
+  using ValueType = typename T::DataType::value_type;
+  using type = std::conditional_t<
+      N == dynamicBatchSize,
+      xt::xtensor<ValueType, T::nDim + 1>,
+      xt::xtensor_fixed<ValueType, typename BatchShapeGetter<N, typename T::Shape>::type>>;
+};
+
+template <typename TUPLE_T, std::size_t N>
+struct BatchTupleGetter;
+
+template <std::size_t N, AnyArraySpecType... T>
+struct BatchTupleGetter<std::tuple<T...>, N> {
+  using type = std::tuple<typename BatchArrayGetter<T, N>::type...>;
+};
+
+template <CompositeArraySpecType T, std::size_t N>
+struct Batch : BatchTupleGetter<typename T::tupleType, N>::type {
+  using SpecType = T;
+  using DataType = typename T::DataType;
+  using tupleType = typename T::tupleType;
+  using tupleDataType = typename BatchTupleGetter<typename T::tupleType, N>::type;
+
+  constexpr static std::size_t extent = N;
+  constexpr static bool isDynamic = N == dynamicBatchSize;
+  constexpr static std::size_t nElements = std::tuple_size_v<tupleType>;
+
+  template <std::size_t K>
+  using ElementSpecType = std::tuple_element_t<K, tupleType>;
+
+  Batch() requires(!isDynamic) = default;
+  explicit Batch(std::size_t n) requires(isDynamic) : tupleDataType(makeElements(n)), batchSize(n) {}
+
+  constexpr std::size_t size() const {
+    if constexpr (isDynamic)
+      return batchSize;
+    else
+      return N;
+  }
+
+  // Copy sample i out of the batch
+  DataType get(std::size_t i) const {
+    return [&]<std::size_t... K>(std::index_sequence<K...>) {
+      return DataType(getElement<K>(i)...);
+    }(std::make_index_sequence<nElements>());
+  }
+
+  // Copy a sample into row i of the batch
+  void set(std::size_t i, const DataType &data) {
+    [&]<std::size_t... K>(std::index_sequence<K...>) {
+      ((setElement<K>(i, std::get<K>(data))), ...);
+    }(std::make_index_sequence<nElements>());
+  }
+
+  // The shape of the tensor holding element K including the batch dimension
+  template <std::size_t K>
+  static auto elementShape(std::size_t n) {
+    auto shape = std::array<std::size_t, ElementSpecType<K>::nDim + 1>{n};
+    std::copy(ElementSpecType<K>::dims.begin(), ElementSpecType<K>::dims.end(), std::next(shape.begin()));
+    return shape;
+  }
+
+private:
+  std::size_t batchSize = isDynamic ? 0 : N;
+
+  static tupleDataType makeElements(std::size_t n) {
+    return [n]<std::size_t... K>(std::index_sequence<K...>) {
+      return tupleDataType(std::tuple_element_t<K, tupleDataType>(elementShape<K>(n))...);
+    }(std::make_index_sequence<nElements>());
+  }
+
+  template <std::size_t K>
+  typename ElementSpecType<K>::DataType getElement(std::size_t i) const {
+    constexpr auto stride = nEntries<ElementSpecType<K>>();
+    auto element = typename ElementSpecType<K>::DataType();
+    const auto *row = std::get<K>(*this).data() + i * stride;
+    std::copy(row, row + stride, element.data());
+    return element;
+  }
+
+  template <std::size_t K>
+  void setElement(std::size_t i, const typename ElementSpecType<K>::DataType &element) {
+    constexpr auto stride = nEntries<ElementSpecType<K>>();
+    std::copy(element.data(), element.data() + stride, std::get<K>(*this).data() + i * stride);
+  }
+};
+
+template <CompositeArraySpecType T>
+using DynamicBatch = Batch<T, dynamicBatchSize>;
+
+template <typename T>
+concept isBatch = requires {
+  typename T::SpecType;
+  T::extent;
+} && std::is_base_of_v<Batch<typename T::SpecType, T::extent>, T>;
+
+template <typename T>
+concept isFixedBatch = isBatch<T> && !T::isDynamic;
+
+template <typename T>
+concept isDynamicBatch = isBatch<T> && T::isDynamic;
+
+// Batched generators mirroring default_spec_gen and constant_spec_gen. Every
+// sample in the batch receives the same value.
+
+template <isBatch B>
+B fill_batch(B batch, const double &value) {
+  [&]<std::size_t... K>(std::index_sequence<K...>) {
+    ((std::fill(
+         std::get<K>(batch).begin(),
+         std::get<K>(batch).end(),
+         static_cast<typename B::template ElementSpecType<K>::DataType::value_type>(value))),
+     ...);
+  }(std::make_index_sequence<B::nElements>());
+  return batch;
+}
+
+template <isBatch B>
+void check_batch_bounds(const double &value) {
+  [&]<std::size_t... K>(std::index_sequence<K...>) {
+    (
+        [&] {
+          using ElementSpec = typename B::template ElementSpecType<K>;
+          if (value < ElementSpec::min || value > ElementSpec::max) {
+            throw std::runtime_error((std::ostringstream() << "Value " << value
+                                                           << "is outside of the bounds of the spec ["
+                                                           << ElementSpec::min << ", " << ElementSpec::max << "]")
+                                         .str());
+          }
+        }(),
+        ...);
+  }(std::make_index_sequence<B::nElements>());
+}
+
+// The default for each element is its min
+template <isBatch B>
+B fill_batch_min(B batch) {
+  [&]<std::size_t... K>(std::index_sequence<K...>) {
+    ((std::fill(
+         std::get<K>(batch).begin(),
+         std::get<K>(batch).end(),
+         static_cast<typename B::template ElementSpecType<K>::DataType::value_type>(
+             B::template ElementSpecType<K>::min))),
+     ...);
+  }(std::make_index_sequence<B::nElements>());
+  return batch;
+}
+
+template <isFixedBatch B>
+B default_spec_gen() {
+  return fill_batch_min(B());
+}
+
+template <isDynamicBatch B>
+B default_spec_gen(std::size_t n) {
+  return fill_batch_min(B(n));
+}
+
+template <isFixedBatch B>
+B constant_spec_gen(const double &value) {
+  check_batch_bounds<B>(value);
+  return fill_batch(B(), value);
+}
+
+template <isDynamicBatch B>
+B constant_spec_gen(std::size_t n, const double &value) {
+  check_batch_bounds<B>(value);
+  return fill_batch(B(n), value);
+}
+
+} // namespace spec
@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <tuple>
+#include <utility>
+
+#include "reinforce/spec.hpp"
+
+namespace spec {
+
+// Bit packed storage for finite composite specs. Every entry of every array in
+// the spec is stored as its offset from min using the fewest bits that can hold
+// (max - min - 1). Entries are laid out in the same order as toIndex (tuple
+// order, row major within an array) and never straddle a word, so reading or
+// writing a field is a shift and a mask.
+
+template <CompositeArraySpecType T>
+requires(T::isFinite)
+struct PackedLayout {
+  using tupleType = typename T::tupleType;
+  using WordType = std::uint64_t;
+
+  struct Field {
+    std::size_t word;
+    std::size_t shift;
+    std::size_t bits;
+  };
+
+  constexpr static std::size_t wordBits = 64;
+  constexpr static std::size_t nElements = std::tuple_size_v<tupleType>;
+
+  constexpr static std::array<std::size_t, nElements> elementEntries =
+      []<std::size_t... N>(std::index_sequence<N...>) {
+        return std::array<std::size_t, nElements>{nEntries<std::tuple_element_t<N, tupleType>>()...};
+      }(std::make_index_sequence<nElements>());
+
+  constexpr static std::array<std::size_t, nElements> elementBits = []<std::size_t... N>(std::index_sequence<N...>) {
+    return std::array<std::size_t, nElements>{
+        static_cast<std::size_t>(std::bit_width(entryRadix<std::tuple_element_t<N, tupleType>>() - 1))...};
+  }(std::make_index_sequence<nElements>());
+
+  // Index of the first field belonging to each element
+  constexpr static std::array<std::size_t, nElements> firstField = [] {
+    auto first = std::array<std::size_t, nElements>{};
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < nElements; ++i) {
+      first[i] = n;
+      n += elementEntries[i];
+    }
+    return first;
+  }();
+
+  constexpr static std::size_t nFields = [] {
+    std::size_t n = 0;
+    for (const auto e : elementEntries)
+      n += e;
+    return n;
+  }();
+
+  constexpr static std::array<Field, nFields> fields = [] {
+    auto f = std::array<Field, nFields>{};
+    std::size_t word = 0, shift = 0, i = 0;
+    for (std::size_t e = 0; e < nElements; ++e) {
+      for (std::size_t k = 0; k < elementEntries[e]; ++k, ++i) {
+        if (shift + elementBits[e] > wordBits) {
+          ++word;
+          shift = 0;
+        }
+        f[i] = Field{word, shift, elementBits[e]};
+        shift += elementBits[e];
+      }
+    }
+    return f;
+  }();
+
+  constexpr static std::size_t nWords = nFields == 0 ? 1 : fields[nFields - 1].word + 1;
+
+  constexpr static WordType mask(std::size_t bits) {
+    return bits >= wordBits ? ~WordType(0) : (WordType(1) << bits) - 1;
+  }
+};
+
+template <CompositeArraySpecType T>
+requires(T::isFinite)
+struct PackedCompositeArray {
+  using SpecType = T;
+  using DataType = typename T::DataType;
+  using LayoutType = PackedLayout<T>;
+  using WordType = typename LayoutType::WordType;
+
+  template <std::size_t N>
+  using ElementSpecType = std::tuple_element_t<N, typename T::tupleType>;
+  template <std::size_t N>
+  using ElementValueType = typename ElementSpecType<N>::DataType::value_type;
+
+  // With every field zero all entries sit at the spec minimum, matching
+  // default_spec_gen.
+  std::array<WordType, LayoutType::nWords> words{};
+
+  constexpr PackedCompositeArray() = default;
+  explicit PackedCompositeArray(const DataType &data) {
+    [&]<std::size_t... N>(std::index_sequence<N...>) {
+      ((packElement<N>(std::get<N>(data))), ...);
+    }(std::make_index_sequence<LayoutType::nElements>());
+  }
+
+  template <std::size_t N>
+  constexpr ElementValueType<N> get(std::size_t entry = 0) const {
+    const auto &f = LayoutType::fields[LayoutType::firstField[N] + entry];
+    const auto raw = (words[f.word] >> f.shift) & LayoutType::mask(f.bits);
+    return static_cast<ElementValueType<N>>(ElementSpecType<N>::min + raw);
+  }
+
+  template <std::size_t N>
+  constexpr void set(std::size_t entry, const ElementValueType<N> &value) {
+    const auto &f = LayoutType::fields[LayoutType::firstField[N] + entry];
+    const auto raw = static_cast<WordType>(value - ElementSpecType<N>::min) & LayoutType::mask(f.bits);
+    words[f.word] = (words[f.word] & ~(LayoutType::mask(f.bits) << f.shift)) | (raw << f.shift);
+  }
+
+  DataType unpack() const {
+    return [this]<std::size_t... N>(std::index_sequence<N...>) {
+      return DataType(unpackElement<N>()...);
+    }(std::make_index_sequence<LayoutType::nElements>());
+  }
+
+  friend constexpr bool operator==(const PackedCompositeArray &lhs, const PackedCompositeArray &rhs) = default;
+
+  constexpr std::size_t hash() const {
+    std::size_t h = 0;
+    for (const auto w : words)
+      h = hashCombine(h, static_cast<std::size_t>(w * 0x9e3779b97f4a7c15ULL));
+    return h;
+  }
+
+  struct Hash {
+    constexpr std::size_t operator()(const PackedCompositeArray &t) const { return t.hash(); }
+  };
+
+  friend std::ostream &operator<<(std::ostream &os, const PackedCompositeArray &rhs) {
+    os << "Packed" << rhs.unpack();
+    return os;
+  }
+
+private:
+  template <std::size_t N>
+  void packElement(const typename ElementSpecType<N>::DataType &element) {
+    std::size_t k = 0;
+    for (const auto &v : element)
+      set<N>(k++, static_cast<ElementValueType<N>>(v));
+  }
+
+  template <std::size_t N>
+  typename ElementSpecType<N>::DataType unpackElement() const {
+    auto element = typename ElementSpecType<N>::DataType();
+    std::size_t k = 0;
+    for (auto &v : element)
+      v = get<N>(k++);
+    return element;
+  }
+};
+
+} // namespace spec
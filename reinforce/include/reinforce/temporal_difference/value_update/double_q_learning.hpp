@@ -6,6 +6,7 @@
 
 #include "reinforce/policy/finite/epsilon_greedy_policy.hpp"
 #include "reinforce/policy/objectives/finite_value_function.hpp"
+#include "reinforce/rng/engine.hpp"
 #include "reinforce/temporal_difference/value_update/value_update.hpp"
 
 #define DQU DoubleQLearningUpdater<VALUE_FUNCTION_T, E>
@@ -47,13 +48,13 @@ struct DoubleQLearningStepMixin {
   }
 };
 
-template <typename CRTP, class E = xt::random::default_engine_type>
+template <typename CRTP, class E = rng::Engine>
 struct DoubleQLearningValueUpdateMixin {
 
   SETUP_TYPES_W_VALUE_FUNCTION(CRTP::ValueFunctionType);
   using EngineType = E;
 
-  EngineType &engine = xt::random::get_default_random_engine();
+  EngineType engine = rng::makeEngine();
   constexpr static PrecisionType QPROB = 0.5F;
 
   /** @brief Update one of the policies (Q1 or Q2) in double Q learning. Generalised
@@ -78,7 +79,7 @@ struct DoubleQLearningValueUpdateMixin {
     // Get Argmax Action from off policy
     const auto onPolicyArgmaxAction = offPolicy.getArgmaxAction(environment, environment.state);
     const auto offPolicyValueOfOnPolicyAction =
-        offPolicy.valueAt(KeyMaker::make(environment, environment.state, onPolicyArgmaxAction));
+        offPolicy.valueAtOrInitial(KeyMaker::make(environment, environment.state, onPolicyArgmaxAction));
     auto &offPolicyValueOfOffPolicyAction = offPolicy[keyCurrent].value;
 
     offPolicyValueOfOffPolicyAction =
@@ -135,7 +136,7 @@ struct DoubleQLearningValueUpdateMixin {
       const PrecisionType &discountRate) -> void {
 
     // with prob 0.5 update q1 using thegreedy action from q2 else update q2 using the greedy action from q1
-    if (xt::random::rand<double>(xt::xshape<1>{}, 0, 1, this->engine)[0] < this->QPROB) {
+    if (rng::uniform(this->engine) < this->QPROB) {
       updatePolicy(environment, policy0, policy1, key, reward, discountRate);
     } else {
       updatePolicy(environment, policy1, policy0, key, reward, discountRate);
@@ -143,7 +144,7 @@ struct DoubleQLearningValueUpdateMixin {
   }
 };
 
-template <policy::objectives::isFiniteAdditiveValueFunctionCombination V, class E = xt::random::default_engine_type>
+template <policy::objectives::isFiniteAdditiveValueFunctionCombination V, class E = rng::Engine>
 requires policy::objectives::isStateActionKeymaker<typename V::KeyMaker> && policy::isFiniteEpsilonSoftPolicy<V>
 using DoubleQLearningUpdater =
     TemporalDifferenceValueUpdater<V, DoubleQLearningStepMixin, DoubleQLearningValueUpdateMixin>;
@@ -32,7 +32,7 @@ struct ExpectedSarsaValueUpdateMixin {
         [&](const auto &a, const auto &action) {
           const auto val =
               policy.getProbability(environment, KeyMaker::get_state_from_key(environment, keyCurrent), action) *
-              valueFunction.valueAt(KeyMaker::make(environment, environment.state, action));
+              valueFunction.valueAtOrInitial(KeyMaker::make(environment, environment.state, action));
           return a + val;
         });
 
@@ -46,8 +46,8 @@ struct OnPolicySarsaReturn {
     const auto last = end - 1;
     if (last->isDone)
       return {
-          G + discountRate *
-                  valueFunction.valueAt(KeyMaker::make(environment, last->transition.state, last->transition.action))};
+          G + discountRate * valueFunction.valueAtOrInitial(
+                                 KeyMaker::make(environment, last->transition.state, last->transition.action))};
 
     return {G};
   }
@@ -121,7 +121,7 @@ struct OffPolicySarsaReturnCalculator {
 
     if (const auto last = end - 1; last->isDone)
       return {
-          .ret = G + discountRate * valueFunction.valueAt(
+          .ret = G + discountRate * valueFunction.valueAtOrInitial(
                                         KeyMaker::make(environment, last->transition.state, last->transition.action)),
           .importanceRatio = rho};
 
@@ -52,7 +52,8 @@ struct NStepTreeBackupReturn {
                  std::accumulate(
                      availableActions.begin(), availableActions.end(), 0.0F, [&](const auto &v, const auto &a) {
                        return v + policy.getProbability(environment, last->transition.state, a) *
-                                      valueFunction.valueAt(KeyMaker::make(environment,last->transition.state, a));
+                                      valueFunction.valueAtOrInitial(
+                                          KeyMaker::make(environment, last->transition.state, a));
                      });
     }();
 
@@ -78,7 +79,8 @@ struct NStepTreeBackupReturn {
                          if (itr.transition.action == a)
                            return v;
                          return v + policy.getProbability(environment, itr.transition.state, a) *
-                                        valueFunction.valueAt(KeyMaker::make(environment, itr.transition.state, a));
+                                        valueFunction.valueAtOrInitial(
+                                            KeyMaker::make(environment, itr.transition.state, a));
                        })
 
              +
@@ -1,6 +1,4 @@
 #pragma once
-#include <limits>
-#include <numeric>
 #include <tuple>
 #include <utility>
 
@@ -52,17 +50,7 @@ struct QLearningValueUpdateMixin {
 
     // get the max value from the next state.
     // This is the difference between SARSA and Q-Learning.
-    const auto reachableActions = environment.getReachableActions(environment.state);
-    const auto maxNextValue = std::accumulate(
-        reachableActions.begin(),
-        reachableActions.end(),
-        std::numeric_limits<PrecisionType>::lowest(),
-        [&](const auto &a, const auto &action) {
-          const auto val = valueFunction.valueAt(KeyMaker::make(environment, environment.state, action));
-          if (val > a)
-            return val;
-          return a;
-        });
+    const auto maxNextValue = valueFunction.maxValueAt(environment, environment.state);
 
     valueFunction[keyCurrent].value =
         valueFunction.valueAt(keyCurrent) +
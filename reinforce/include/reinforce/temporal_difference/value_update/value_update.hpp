@@ -92,7 +92,7 @@ struct DefaultValueUpdater {
     valueFunction[keyCurrent].value =
         valueFunction.valueAt(keyCurrent) +
         temporal_differenc_error(
-            valueFunction.valueAt(keyCurrent), valueFunction.valueAt(keyNext), reward, discountRate);
+            valueFunction.valueAt(keyCurrent), valueFunction.valueAtOrInitial(keyNext), reward, discountRate);
     valueFunction[keyCurrent].step++;
   };
 };
@@ -34,7 +34,9 @@ struct Transition {
   }
 
   struct Hash {
-    std::size_t operator()(const Transition &t) const { return t.state.hash() ^ t.action.hash() ^ t.nextState.hash(); }
+    std::size_t operator()(const Transition &t) const {
+      return spec::hashCombine(spec::hashCombine(t.state.hash(), t.action.hash()), t.nextState.hash());
+    }
   };
 
   bool isDone() const { return kind == TransitionKind::TERMINAL; }
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief An open addressing hash map with Robin Hood probing.
+ *
+ * @details Entries live in one power of two sized array rather than a node per
+ * entry, so a lookup is a few adjacent loads. Each slot keeps its distance
+ * from the slot its hash prefers and the hash itself. Inserting takes the slot
+ * of any entry closer to its preferred slot than the new one and carries that
+ * entry on (Robin Hood), which keeps probe sequences short and sorted by
+ * distance, so a lookup stops as soon as it passes an entry closer to home
+ * than it would be. Erasing shifts the run that follows back by one slot
+ * instead of leaving a tombstone. Full hashes are compared before keys so
+ * unequal keys are rarely compared.
+ *
+ * The interface is the part of std::unordered_map used for value and returns
+ * tables: operator[], at, find, try_emplace, emplace, erase and iteration over
+ * (key, value) pairs. Unlike std::unordered_map, inserting or erasing moves
+ * entries, invalidating every iterator and reference into the map.
+ */
+template <typename KEY_T, typename VALUE_T, typename HASH_T = std::hash<KEY_T>, typename EQUAL_T = std::equal_to<KEY_T>>
+class FlatHashMap {
+public:
+  using key_type = KEY_T;
+  using mapped_type = VALUE_T;
+  using value_type = std::pair<KEY_T, VALUE_T>;
+  using size_type = std::size_t;
+  using hasher = HASH_T;
+  using key_equal = EQUAL_T;
+
+  template <bool CONST>
+  class Iterator {
+  public:
+    using MapType = std::conditional_t<CONST, const FlatHashMap, FlatHashMap>;
+    using value_type = FlatHashMap::value_type;
+    using reference = std::conditional_t<CONST, const value_type &, value_type &>;
+    using pointer = std::conditional_t<CONST, const value_type *, value_type *>;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    Iterator() = default;
+    Iterator(MapType *map, std::size_t slot) : map(map), slot(slot) { skip(); }
+    operator Iterator<true>() const requires(not CONST) { return Iterator<true>(map, slot); }
+
+    reference operator*() const { return *map->entries[slot]; }
+    pointer operator->() const { return &*map->entries[slot]; }
+
+    Iterator &operator++() {
+      ++slot;
+      skip();
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const Iterator &other) const { return slot == other.slot; }
+
+  private:
+    MapType *map = nullptr;
+    std::size_t slot = 0;
+
+    void skip() {
+      while (slot < map->meta.size() and map->meta[slot].distance == 0)
+        ++slot;
+    }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+
+  std::size_t size() const { return nEntries; }
+  bool empty() const { return nEntries == 0; }
+  /// @brief The number of slots, a power of two or zero.
+  std::size_t capacity() const { return meta.size(); }
+  double load_factor() const { return meta.empty() ? 0.0 : double(nEntries) / double(meta.size()); }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, meta.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, meta.size()); }
+
+  iterator find(const KEY_T &key) { return iterator(this, locate(key, mix(hasher{}(key)))); }
+  const_iterator find(const KEY_T &key) const { return const_iterator(this, locate(key, mix(hasher{}(key)))); }
+
+  bool contains(const KEY_T &key) const { return find(key) != end(); }
+  std::size_t count(const KEY_T &key) const { return contains(key) ? 1 : 0; }
+
+  VALUE_T &at(const KEY_T &key) { return entries[checked(key)]->second; }
+  const VALUE_T &at(const KEY_T &key) const { return entries[checked(key)]->second; }
+
+  VALUE_T &operator[](const KEY_T &key) { return try_emplace(key).first->second; }
+
+  template <typename... ARGS>
+  std::pair<iterator, bool> try_emplace(const KEY_T &key, ARGS &&...args) {
+    const auto hash = mix(hasher{}(key));
+    const auto slot = locate(key, hash);
+    if (slot != meta.size())
+      return {iterator(this, slot), false};
+    if ((nEntries + 1) * 8 > meta.size() * 7)
+      rehash(meta.empty() ? minCapacity : meta.size() * 2);
+    const auto inserted =
+        place(hash, value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                               std::forward_as_tuple(std::forward<ARGS>(args)...)));
+    return {iterator(this, inserted), true};
+  }
+
+  std::pair<iterator, bool> emplace(const KEY_T &key, const VALUE_T &value) { return try_emplace(key, value); }
+  std::pair<iterator, bool> insert(const value_type &entry) { return try_emplace(entry.first, entry.second); }
+
+  std::size_t erase(const KEY_T &key) {
+    auto slot = locate(key, mix(hasher{}(key)));
+    if (slot == meta.size())
+      return 0;
+    // Backward shift: pull every following entry that is not in its preferred
+    // slot back by one, so no tombstone is left behind
+    const auto mask = meta.size() - 1;
+    for (auto next = (slot + 1) & mask; meta[next].distance > 1; slot = next, next = (next + 1) & mask) {
+      entries[slot] = std::move(entries[next]);
+      meta[slot] = {meta[next].hash, meta[next].distance - 1};
+    }
+    entries[slot].reset();
+    meta[slot] = {};
+    --nEntries;
+    return 1;
+  }
+
+  void clear() {
+    entries.clear();
+    meta.clear();
+    nEntries = 0;
+  }
+
+  /// @brief Make room for n entries without rehashing.
+  void reserve(std::size_t n) {
+    auto slots = minCapacity;
+    while (n * 8 > slots * 7)
+      slots *= 2;
+    if (slots > meta.size())
+      rehash(slots);
+  }
+
+private:
+  struct Meta {
+    std::size_t hash = 0;
+    /// @brief One more than the distance from the preferred slot, zero when
+    /// the slot is empty.
+    std::size_t distance = 0;
+  };
+
+  constexpr static std::size_t minCapacity = 16;
+
+  std::vector<Meta> meta;
+  std::vector<std::optional<value_type>> entries;
+  std::size_t nEntries = 0;
+
+  /// @brief Spread the bits of a hash, the slot is taken from the low ones.
+  static std::size_t mix(std::size_t hash) {
+    auto x = static_cast<std::uint64_t>(hash);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return static_cast<std::size_t>(x);
+  }
+
+  /// @brief The slot of the key or capacity() when it is absent.
+  std::size_t locate(const KEY_T &key, std::size_t hash) const {
+    if (meta.empty())
+      return 0;
+    const auto mask = meta.size() - 1;
+    auto slot = hash & mask;
+    for (std::size_t distance = 1; meta[slot].distance >= distance; ++distance, slot = (slot + 1) & mask) {
+      if (meta[slot].hash == hash and key_equal{}(entries[slot]->first, key))
+        return slot;
+    }
+    return meta.size();
+  }
+
+  std::size_t checked(const KEY_T &key) const {
+    const auto slot = locate(key, mix(hasher{}(key)));
+    if (slot == meta.size())
+      throw std::out_of_range("Key is not present in the flat hash map");
+    return slot;
+  }
+
+  /// @brief Insert an entry known to be absent. Returns its slot.
+  std::size_t place(std::size_t hash, value_type &&entry) {
+    const auto mask = meta.size() - 1;
+    auto carried = Meta{hash, 1};
+    auto carriedEntry = std::move(entry);
+    auto result = meta.size();
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask, ++carried.distance) {
+      if (meta[slot].distance == 0) {
+        meta[slot] = carried;
+        entries[slot].emplace(std::move(carriedEntry));
+        ++nEntries;
+        return result == meta.size() ? slot : result;
+      }
+      if (meta[slot].distance < carried.distance) {
+        std::swap(meta[slot], carried);
+        std::swap(*entries[slot], carriedEntry);
+        if (result == meta.size())
+          result = slot;
+      }
+    }
+  }
+
+  void rehash(std::size_t slots) {
+    auto oldMeta = std::exchange(meta, std::vector<Meta>(slots));
+    auto oldEntries = std::exchange(entries, std::vector<std::optional<value_type>>(slots));
+    nEntries = 0;
+    for (std::size_t i = 0; i < oldMeta.size(); ++i) {
+      if (oldMeta[i].distance != 0)
+        place(oldMeta[i].hash, std::move(*oldEntries[i]));
+    }
+  }
+};
+
+} // namespace utils
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace utils {
+
+/**
+ * @brief A whole file mapped read only into memory.
+ *
+ * @details Pages are loaded lazily by the kernel on first access and are
+ * shared through the page cache by every process that maps the same file, so
+ * opening is O(1) in the size of the file. The mapping lives as long as the
+ * object.
+ */
+class MappedFile {
+public:
+  /// @throws std::system_error When the file cannot be opened or mapped.
+  explicit MappedFile(const std::filesystem::path &path) {
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "Cannot open " + path.string());
+
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+      const auto error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "Cannot stat " + path.string());
+    }
+    nBytes = static_cast<std::size_t>(status.st_size);
+
+    if (nBytes > 0) {
+      mapping = ::mmap(nullptr, nBytes, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapping == MAP_FAILED) {
+        const auto error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot map " + path.string());
+      }
+    }
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (mapping != nullptr)
+      ::munmap(mapping, nBytes);
+  }
+
+  const std::byte *data() const { return static_cast<const std::byte *>(mapping); }
+  std::size_t size() const { return nBytes; }
+
+private:
+  void *mapping = nullptr;
+  std::size_t nBytes = 0;
+};
+
+} // namespace utils
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief A square sparse matrix in compressed sparse row form.
+ *
+ * @details Rows are appended in order with addEntry / endRow. The entries of
+ * row i are columns[rowOffsets[i]..rowOffsets[i + 1]) and values alike.
+ */
+template <typename PRECISION_T>
+struct CsrMatrix {
+  using PrecisionType = PRECISION_T;
+  using IndexType = std::uint32_t;
+
+  std::vector<std::size_t> rowOffsets = {0};
+  std::vector<IndexType> columns;
+  std::vector<PrecisionType> values;
+
+  std::size_t size() const { return rowOffsets.size() - 1; }
+  std::size_t nEntries() const { return columns.size(); }
+
+  void addEntry(std::size_t column, PrecisionType value) {
+    columns.push_back(static_cast<IndexType>(column));
+    values.push_back(value);
+  }
+  void endRow() { rowOffsets.push_back(columns.size()); }
+
+  /// @brief y = A x
+  void multiply(const std::vector<PrecisionType> &x, std::vector<PrecisionType> &y) const {
+    y.resize(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+      PrecisionType sum = 0;
+      for (auto k = rowOffsets[i]; k < rowOffsets[i + 1]; ++k)
+        sum += values[k] * x[columns[k]];
+      y[i] = sum;
+    }
+  }
+
+  /// @brief The diagonal entry of every row, zero where it is not stored.
+  std::vector<PrecisionType> diagonal() const {
+    auto d = std::vector<PrecisionType>(size(), 0);
+    for (std::size_t i = 0; i < size(); ++i) {
+      for (auto k = rowOffsets[i]; k < rowOffsets[i + 1]; ++k) {
+        if (columns[k] == i)
+          d[i] += values[k];
+      }
+    }
+    return d;
+  }
+};
+
+struct LinearSolveResult {
+  std::size_t iterations;
+  /// @brief max_i |b - A x|_i at the returned x
+  double residual;
+};
+
+namespace detail {
+
+template <typename PRECISION_T>
+double dot(const std::vector<PRECISION_T> &x, const std::vector<PRECISION_T> &y) {
+  double sum = 0;
+  for (std::size_t i = 0; i < x.size(); ++i)
+    sum += static_cast<double>(x[i]) * static_cast<double>(y[i]);
+  return sum;
+}
+
+template <typename PRECISION_T>
+double max_norm(const std::vector<PRECISION_T> &x) {
+  double norm = 0;
+  for (const auto &v : x)
+    norm = std::max(norm, static_cast<double>(std::abs(v)));
+  return norm;
+}
+
+} // namespace detail
+
+/**
+ * @brief Solve A x = b by BiCGSTAB with a Jacobi (diagonal) preconditioner.
+ *
+ * @details BiCGSTAB handles the non symmetric systems that arise from Markov
+ * chains and needs only products with A. The preconditioner scales each row by
+ * the inverse of its diagonal, which for diagonally dominant systems such as
+ * I - gamma P with gamma < 1 keeps the iteration count small. x holds the
+ * initial guess on entry and the solution on return.
+ *
+ * @param tolerance Stop once every component of the residual b - A x is at
+ * most tolerance in magnitude.
+ * @throws std::runtime_error When it does not converge within maxIterations.
+ * The last iterate is left in x.
+ */
+template <typename PRECISION_T>
+LinearSolveResult bicgstab(
+    const CsrMatrix<PRECISION_T> &A,
+    const std::vector<PRECISION_T> &b,
+    std::vector<PRECISION_T> &x,
+    PRECISION_T tolerance,
+    std::size_t maxIterations = 1000) {
+
+  const auto n = A.size();
+  if (b.size() != n or x.size() != n)
+    throw std::invalid_argument("bicgstab: dimensions of A, b and x differ");
+
+  auto inverseDiagonal = A.diagonal();
+  for (auto &d : inverseDiagonal)
+    d = d == PRECISION_T(0) ? PRECISION_T(1) : PRECISION_T(1) / d;
+  auto precondition = [&](const std::vector<PRECISION_T> &in, std::vector<PRECISION_T> &out) {
+    out.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = inverseDiagonal[i] * in[i];
+  };
+
+  // r = b - A x, recomputed from x rather than carried by the recurrences
+  auto r = std::vector<PRECISION_T>(n);
+  auto residual = [&] {
+    A.multiply(x, r);
+    for (std::size_t i = 0; i < n; ++i)
+      r[i] = b[i] - r[i];
+    return detail::max_norm(r);
+  };
+  if (const auto norm = residual(); norm <= tolerance)
+    return {0, norm};
+
+  auto rHat = r;
+  auto p = std::vector<PRECISION_T>(n, 0);
+  auto v = std::vector<PRECISION_T>(n, 0);
+  auto s = std::vector<PRECISION_T>(n);
+  auto t = std::vector<PRECISION_T>(n);
+  auto y = std::vector<PRECISION_T>(n);
+  auto z = std::vector<PRECISION_T>(n);
+  double rho = 1, alpha = 1, omega = 1;
+
+  // A breakdown (a zero inner product) restarts from the current x with the
+  // shadow residual reset to r, after which rho = |r|^2 > 0. This happens on
+  // near nilpotent systems such as I - gamma P for a deterministic chain. The
+  // same restart follows a recursive residual that met the tolerance while
+  // the true one, having drifted from it by rounding, did not.
+  auto restart = [&] {
+    rHat = r;
+    std::fill(p.begin(), p.end(), PRECISION_T(0));
+    std::fill(v.begin(), v.end(), PRECISION_T(0));
+    rho = alpha = omega = 1;
+  };
+
+  for (std::size_t iteration = 1; iteration <= maxIterations; ++iteration) {
+    auto rhoNext = detail::dot(rHat, r);
+    if (rhoNext == 0.0) {
+      restart();
+      rhoNext = detail::dot(rHat, r);
+    }
+    const auto beta = (rhoNext / rho) * (alpha / omega);
+    rho = rhoNext;
+    for (std::size_t i = 0; i < n; ++i)
+      p[i] = r[i] + static_cast<PRECISION_T>(beta) * (p[i] - static_cast<PRECISION_T>(omega) * v[i]);
+
+    precondition(p, y);
+    A.multiply(y, v);
+    const auto rHatV = detail::dot(rHat, v);
+    if (rHatV == 0.0) {
+      restart();
+      continue;
+    }
+    alpha = rho / rHatV;
+    for (std::size_t i = 0; i < n; ++i) {
+      x[i] += static_cast<PRECISION_T>(alpha) * y[i];
+      s[i] = r[i] - static_cast<PRECISION_T>(alpha) * v[i];
+    }
+    if (detail::max_norm(s) <= tolerance) {
+      if (const auto norm = residual(); norm <= tolerance)
+        return {iteration, norm};
+      restart();
+      continue;
+    }
+
+    precondition(s, z);
+    A.multiply(z, t);
+    const auto tt = detail::dot(t, t);
+    omega = tt == 0.0 ? 0.0 : detail::dot(t, s) / tt;
+    for (std::size_t i = 0; i < n; ++i) {
+      x[i] += static_cast<PRECISION_T>(omega) * z[i];
+      r[i] = s[i] - static_cast<PRECISION_T>(omega) * t[i];
+    }
+    if (detail::max_norm(r) <= tolerance) {
+      if (const auto norm = residual(); norm <= tolerance)
+        return {iteration, norm};
+      restart();
+      continue;
+    }
+    if (omega == 0.0)
+      restart();
+  }
+  throw std::runtime_error("bicgstab: did not converge");
+}
+
+} // namespace utils
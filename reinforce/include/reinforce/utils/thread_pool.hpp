@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief A fixed set of worker threads that run one data parallel job at a
+ * time.
+ *
+ * @details run(n, f) splits [0, n) into size() contiguous chunks and calls
+ * f(worker, begin, end) once per chunk. The calling thread works on chunk 0 and
+ * run returns once every chunk is done. Chunks are a pure function of n and
+ * size(), so a reduction into a per worker slot is deterministic. The first
+ * exception thrown by any chunk is rethrown from run.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t nThreads = std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+      : nThreads(std::max<std::size_t>(1, nThreads)) {
+    for (std::size_t w = 1; w < this->nThreads; ++w)
+      workers.emplace_back([this, w] { work(w); });
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &t : workers)
+      t.join();
+  }
+
+  /// @brief The number of chunks a job is split into, including the caller.
+  std::size_t size() const { return nThreads; }
+
+  /// @brief The half open range of [0, n) handled by the given worker.
+  std::pair<std::size_t, std::size_t> chunk(std::size_t worker, std::size_t n) const {
+    const auto base = n / nThreads;
+    const auto extra = n % nThreads;
+    const auto begin = worker * base + std::min(worker, extra);
+    return {begin, begin + base + (worker < extra ? 1 : 0)};
+  }
+
+  template <typename F>
+  void run(std::size_t n, F &&f) {
+    {
+      std::lock_guard lock(mutex);
+      job = [this, n, &f](std::size_t worker) {
+        const auto [begin, end] = chunk(worker, n);
+        if (begin != end)
+          f(worker, begin, end);
+      };
+      pending = nThreads - 1;
+      error = nullptr;
+      ++generation;
+    }
+    wake.notify_all();
+
+    runChunk(0);
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    job = nullptr;
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+private:
+  std::size_t nThreads;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::function<void(std::size_t)> job;
+  std::size_t generation = 0;
+  std::size_t pending = 0;
+  std::exception_ptr error;
+  bool stopping = false;
+
+  void runChunk(std::size_t worker) {
+    try {
+      job(worker);
+    } catch (...) {
+      std::lock_guard lock(mutex);
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+
+  void work(std::size_t worker) {
+    std::size_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock lock(mutex);
+        wake.wait(lock, [&] { return stopping or generation != seen; });
+        if (stopping)
+          return;
+        seen = generation;
+      }
+      runChunk(worker);
+      {
+        std::lock_guard lock(mutex);
+        --pending;
+      }
+      done.notify_one();
+    }
+  }
+};
+
+} // namespace utils
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <unordered_set>
+
 #include <reinforce/environment.hpp>
 #include <reinforce/markov_decision_process/finite_transition_model.hpp>
 
@@ -16,20 +22,21 @@ struct simple_environment_builder {
 
   struct type : environment::FiniteEnvironment<StepType0, RewardType0, ReturnType0> {
     SETUP_TYPES(SINGLE_ARG(environment::FiniteEnvironment<StepType0, RewardType0, ReturnType0>));
+    constexpr static bool isSpecEnumerable = true;
     StateType reset() override { return StateType{}; }
     StateType stateFromIndex(std::size_t i) const override { return StateType{i, {}}; }
     ActionSpace actionFromIndex(std::size_t i) const override { return ActionSpace{i}; }
     std::unordered_set<StateType, typename StateType::Hash> getAllPossibleStates() const override {
       std::unordered_set<StateType, typename StateType::Hash> states;
-      for (std::size_t i = 0; i < N; ++i) {
-        states.insert(StateType{i, {}});
+      for (const auto &observable : spec::values<typename StateType::ObservableSpecType>()) {
+        states.insert(StateType{observable, {}});
       }
       return states;
     };
     std::unordered_set<ActionSpace, typename ActionSpace::Hash> getAllPossibleActions() const override {
       std::unordered_set<ActionSpace, typename ActionSpace::Hash> actions;
-      for (std::size_t i = 0; i < M; ++i) {
-        actions.insert(ActionSpace{i});
+      for (const auto &action : spec::values<ActionSpecType>()) {
+        actions.insert(ActionSpace{action});
       }
       return actions;
     };
@@ -95,15 +102,15 @@ struct simple_markov_environment_builder {
     ActionSpace actionFromIndex(std::size_t i) const override { return ActionSpace{i}; }
     std::unordered_set<StateType, typename StateType::Hash> getAllPossibleStates() const override {
       std::unordered_set<StateType, typename StateType::Hash> states;
-      for (std::size_t i = 0; i < N; ++i) {
-        states.insert(StateType{i, {}});
+      for (const auto &observable : spec::values<typename StateType::ObservableSpecType>()) {
+        states.insert(StateType{observable, {}});
       }
       return states;
     };
     std::unordered_set<ActionSpace, typename ActionSpace::Hash> getAllPossibleActions() const override {
       std::unordered_set<ActionSpace, typename ActionSpace::Hash> actions;
-      for (std::size_t i = 0; i < M; ++i) {
-        actions.insert(ActionSpace{i});
+      for (const auto &action : spec::values<ActionSpecType>()) {
+        actions.insert(ActionSpace{action});
       }
       return actions;
     };
@@ -114,6 +121,116 @@ struct simple_markov_environment_builder {
 template <std::size_t N, std::size_t M>
 using simple_markov_environment_builder_t = typename simple_markov_environment_builder<N, M>::type;
 
+// A deterministic chain 0 -> 1 -> ... -> N-1. Action 0 moves one step right and
+// action 1 stays put. Entering N-1 pays 1 and N-1 is absorbing with no reward.
+// When ACYCLIC action 1 instead jumps two steps right and N-1 is terminal with
+// no transitions, so the transition graph has no cycles.
+template <std::size_t N, bool ACYCLIC = false>
+struct chain_markov_environment_builder {
+
+  using StateType0 = state::State<float, spec::CompositeArraySpec<spec::BoundedAarraySpec<int, 0, N, 1>>>;
+  using ActionType0 = action::Action<StateType0, spec::CompositeArraySpec<spec::BoundedAarraySpec<int, 0, 2, 1>>>;
+  using StepType0 = step::Step<ActionType0>;
+
+  struct RewardType0 : reward::Reward<ActionType0> {
+    using typename reward::Reward<ActionType0>::PrecisionType;
+    using typename reward::Reward<ActionType0>::TransitionType;
+    static PrecisionType reward(const TransitionType &t) {
+      const auto last = static_cast<int>(N - 1);
+      const auto from = std::get<0>(t.state.observable)[0];
+      const auto to = std::get<0>(t.nextState.observable)[0];
+      return to == last and from != last ? 1.0F : 0.0F;
+    }
+  };
+  using ReturnType0 = returns::Return<RewardType0>;
+
+  struct type : environment::MarkovDecisionEnvironment<StepType0, RewardType0, ReturnType0> {
+    SETUP_TYPES(SINGLE_ARG(environment::MarkovDecisionEnvironment<StepType0, RewardType0, ReturnType0>));
+    using typename BaseType::TransitionModel;
+
+    static TransitionModel makeTransitionModel() {
+      auto model = TransitionModel{};
+      for (std::size_t i = 0; i < N; ++i) {
+        model.states[i] = StateType{i, {}};
+        if (ACYCLIC and i == N - 1)
+          continue;
+        const auto next = std::min(i + 1, N - 1);
+        const auto other = ACYCLIC ? std::min(i + 2, N - 1) : i;
+        model.transitions.emplace(TransitionType{StateType(i, {}), ActionSpace(0), StateType(next, {})}, 1.0F);
+        model.transitions.emplace(TransitionType{StateType(i, {}), ActionSpace(1), StateType(other, {})}, 1.0F);
+      }
+      model.actions = {ActionSpace{0}, ActionSpace{1}};
+      return model;
+    }
+
+    type() : BaseType(makeTransitionModel()) {}
+
+    StateType reset() override { return StateType{}; }
+    StateType getNullState() const override { return StateType{0, {}}; }
+  };
+};
+
+template <std::size_t N, bool ACYCLIC = false>
+using chain_markov_environment_builder_t = typename chain_markov_environment_builder<N, ACYCLIC>::type;
+
+// K identical chains of length L leading to a shared goal, state K * L. State
+// i sits at position i % L of its chain. Action 0 moves one step along, from
+// the last position into the goal, and action 1 does the same with
+// probability 1/2 and otherwise stays put. Entering the goal pays 1 and the
+// goal is absorbing with no reward. States at the same position of different
+// chains behave identically, so the model lumps into L + 1 blocks.
+template <std::size_t K, std::size_t L>
+struct parallel_chains_markov_environment_builder {
+
+  static constexpr std::size_t N = K * L + 1;
+  using StateType0 = state::State<float, spec::CompositeArraySpec<spec::BoundedAarraySpec<int, 0, N, 1>>>;
+  using ActionType0 = action::Action<StateType0, spec::CompositeArraySpec<spec::BoundedAarraySpec<int, 0, 2, 1>>>;
+  using StepType0 = step::Step<ActionType0>;
+
+  struct RewardType0 : reward::Reward<ActionType0> {
+    using typename reward::Reward<ActionType0>::PrecisionType;
+    using typename reward::Reward<ActionType0>::TransitionType;
+    static PrecisionType reward(const TransitionType &t) {
+      const auto goal = static_cast<int>(N - 1);
+      const auto from = std::get<0>(t.state.observable)[0];
+      const auto to = std::get<0>(t.nextState.observable)[0];
+      return to == goal and from != goal ? 1.0F : 0.0F;
+    }
+  };
+  using ReturnType0 = returns::Return<RewardType0>;
+
+  struct type : environment::MarkovDecisionEnvironment<StepType0, RewardType0, ReturnType0> {
+    SETUP_TYPES(SINGLE_ARG(environment::MarkovDecisionEnvironment<StepType0, RewardType0, ReturnType0>));
+    using typename BaseType::TransitionModel;
+
+    static TransitionModel makeTransitionModel() {
+      auto model = TransitionModel{};
+      for (std::size_t i = 0; i < N; ++i) {
+        model.states[i] = StateType{i, {}};
+        const auto next = i == N - 1 or i % L == L - 1 ? N - 1 : i + 1;
+        const auto from = StateType(i, {});
+        model.transitions.emplace(TransitionType{from, ActionSpace(0), StateType(next, {})}, 1.0F);
+        if (next == i) {
+          model.transitions.emplace(TransitionType{from, ActionSpace(1), from}, 1.0F);
+          continue;
+        }
+        model.transitions.emplace(TransitionType{from, ActionSpace(1), StateType(next, {})}, 0.5F);
+        model.transitions.emplace(TransitionType{from, ActionSpace(1), from}, 0.5F);
+      }
+      model.actions = {ActionSpace{0}, ActionSpace{1}};
+      return model;
+    }
+
+    type() : BaseType(makeTransitionModel()) {}
+
+    StateType reset() override { return StateType{}; }
+    StateType getNullState() const override { return StateType{0, {}}; }
+  };
+};
+
+template <std::size_t K, std::size_t L>
+using parallel_chains_markov_environment_builder_t = typename parallel_chains_markov_environment_builder<K, L>::type;
+
 using S1A1 = simple_environment_builder_t<1, 1>;
 using S1A2 = simple_environment_builder_t<1, 2>;
 using S1A3 = simple_environment_builder_t<1, 3>;
@@ -123,4 +240,33 @@ using S2A2 = simple_environment_builder_t<2, 2>;
 using MS5A2 = simple_markov_environment_builder_t<5, 2>;
 using MS5A10 = simple_markov_environment_builder_t<5, 10>;
 
+inline constexpr std::size_t chainLength = 64;
+using MChain64 = chain_markov_environment_builder_t<chainLength>;
+using MAcyclicChain64 = chain_markov_environment_builder_t<chainLength, true>;
+using MParallelChains8x8 = parallel_chains_markov_environment_builder_t<8, 8>;
+
+// MChain64 started half way along, so only its upper half is reachable
+struct UpperChain : MChain64 {
+  StateType reset() override {
+    this->state = StateType{chainLength / 2, {}};
+    return this->state;
+  }
+  std::unordered_set<StateType, typename StateType::Hash> getInitialStates() const {
+    return {StateType{chainLength / 2, {}}};
+  }
+};
+
+// The optimal value of state i of an n state chain, which is paid 1 on
+// reaching the end, and the end is worth nothing
+inline double optimalChainValue(std::size_t i, std::size_t n = chainLength, double discountRate = 0.99) {
+  return i == n - 1 ? 0.0 : std::pow(discountRate, n - 2 - i);
+}
+
+// Check that every state of MChain64 has its optimal value, up to margin
+template <typename VALUE_FUNCTION_T>
+void checkOptimalChainValues(VALUE_FUNCTION_T &values, double margin) {
+  for (std::size_t i = 0; i < chainLength; ++i)
+    CHECK(std::abs(values.valueAt(MChain64::StateType{i, {}}) - optimalChainValue(i)) <= margin);
+}
+
 } // namespace fixtures
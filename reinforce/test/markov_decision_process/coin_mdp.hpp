@@ -8,6 +8,7 @@
 #include <xtensor/xview.hpp>
 
 #include <reinforce/markov_decision_process/finite_transition_model.hpp>
+#include <reinforce/monte_carlo/value_update/average_return.hpp>
 #include <reinforce/policy/distribution_policy.hpp>
 #include <reinforce/policy/finite/distribution_policy.hpp>
 #include <reinforce/policy/random_policy.hpp>
@@ -167,6 +168,20 @@ private:
   }
 };
 
+// Record the returns 1 then 2 from (s0, a0) with NiaveAverageReturnsUpdate,
+// updating the value after each. Returns the value left at (s0, a0), which is
+// their average 1.5.
+template <typename VALUE_FUNCTION_T>
+typename VALUE_FUNCTION_T::PrecisionType
+averageOfTwoReturns(CoinModelDataFixture &data, VALUE_FUNCTION_T &valueFunction) {
+  auto updater = monte_carlo::NiaveAverageReturnsUpdate<VALUE_FUNCTION_T>();
+  for (const auto ret : {1, 2}) {
+    updater.updateReturns(valueFunction, data.policy, data.policy, data.environ, data.s0, data.a0, ret);
+    updater.updateValue(valueFunction, data.policy, data.policy, data.environ, data.s0, data.a0);
+  }
+  return valueFunction[VALUE_FUNCTION_T::KeyMaker::make(data.environ, data.s0, data.a0)].value;
+}
+
 static_assert(environment::FullyKnownFiniteStateEnvironment<CoinEnviron>);
 static_assert(environment::FullyKnownConditionalStateActionEnvironment<CoinEnviron>);
 
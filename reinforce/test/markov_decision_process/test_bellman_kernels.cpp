@@ -0,0 +1,73 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <reinforce/markov_decision_process/bellman_kernels.hpp>
+#include <reinforce/markov_decision_process/indexed_transition_model.hpp>
+
+#include "coin_mdp.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+namespace {
+
+template <typename PRECISION_T>
+void check_dot_gather() {
+  // Lengths either side of the 4, 8 and 16 lane widths exercise the tails
+  constexpr std::size_t nValues = 41;
+  auto values = std::vector<PRECISION_T>(nValues);
+  for (std::size_t i = 0; i < nValues; ++i)
+    values[i] = static_cast<PRECISION_T>(i % 5) - static_cast<PRECISION_T>(1.5);
+
+  for (const std::size_t n : {0, 1, 3, 4, 7, 8, 15, 16, 17, 33, 40}) {
+    auto successors = std::vector<std::uint32_t>(n);
+    auto probabilities = std::vector<PRECISION_T>(n);
+    PRECISION_T expected = 0;
+    for (std::size_t k = 0; k < n; ++k) {
+      successors[k] = static_cast<std::uint32_t>((k * 7 + 3) % nValues);
+      probabilities[k] = static_cast<PRECISION_T>(1.0) / static_cast<PRECISION_T>(k + 2);
+      expected += probabilities[k] * values[successors[k]];
+    }
+    CHECK(kernels::dot_gather(probabilities.data(), successors.data(), n, values.data()) == Approx(expected));
+  }
+}
+
+} // namespace
+
+TEST_CASE("dot_gather matches a scalar loop") {
+  SECTION("float") { check_dot_gather<float>(); }
+  SECTION("double") { check_dot_gather<double>(); }
+}
+
+TEST_CASE("max_backup takes the best action of a state") {
+
+  auto data = CoinModelDataFixture();
+  const auto model = environment::IndexedTransitionModel<CoinReward>(
+      data.transitionModel.transitions, data.transitionModel.states, data.transitionModel.actions);
+  const auto values = std::vector<float>{2.0F, -1.0F};
+  const auto discountRate = 0.9F;
+
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    const auto q0 = kernels::backup(model, values.data(), discountRate, model.row(i, 0));
+    const auto q1 = kernels::backup(model, values.data(), discountRate, model.row(i, 1));
+
+    float expected = model.expectedRewards[model.row(i, 0)];
+    const auto row = model(i, 0);
+    for (std::size_t k = 0; k < row.size(); ++k)
+      expected += discountRate * row.probabilities[k] * values[row.successors[k]];
+    CHECK(q0 == Approx(expected));
+
+    const auto best = kernels::max_backup(model, values.data(), discountRate, i);
+    CHECK(best.value == Approx(std::max(q0, q1)));
+    CHECK(best.action == (q1 > q0 ? 1U : 0U));
+  }
+
+  SECTION("States without transitions have no best action") {
+    const auto empty = environment::IndexedTransitionModel<CoinReward>(
+        CoinTransitionModel::TransitionModelMap{}, data.transitionModel.states, data.transitionModel.actions);
+    CHECK(kernels::max_backup(empty, values.data(), discountRate, 0).action == empty.nActions());
+  }
+}
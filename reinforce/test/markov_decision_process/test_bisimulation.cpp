@@ -0,0 +1,127 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include <reinforce/markov_decision_process/bisimulation.hpp>
+#include <reinforce/markov_decision_process/value_iteration.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+namespace {
+
+using Chains = fixtures::MParallelChains8x8;
+using ChainsValueFunction = policy::objectives::FiniteStateValueFunction<Chains, 0.0F, 0.99F>;
+constexpr std::size_t length = 8;
+
+// Every state moves into the blocks with the same probabilities as the
+// representative of its block, so no block can split further
+template <typename MODEL_T>
+void checkStable(const MODEL_T &model) {
+  const auto partition = bisimulation::coarsest_partition(model);
+  auto blockProbabilities = [&](std::size_t i, std::size_t a) {
+    auto probabilities = std::vector<double>(partition.size(), 0.0);
+    const auto row = model(i, a);
+    for (std::size_t k = 0; k < row.size(); ++k)
+      probabilities[partition.blocks[row.successors[k]]] += row.probabilities[k];
+    return probabilities;
+  };
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    const auto r = partition.representatives[partition.blocks[i]];
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      const auto expected = blockProbabilities(r, a);
+      const auto probabilities = blockProbabilities(i, a);
+      for (std::size_t b = 0; b < partition.size(); ++b)
+        CHECK(probabilities[b] == Approx(expected[b]).margin(1e-6));
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("Coarsest bisimulation", "[bisimulation]") {
+
+  SECTION("Parallel chains lump by position") {
+    const auto environ = Chains();
+    const auto &model = environ.indexedTransitionModel;
+    const auto lumped = bisimulation::quotient(model);
+    const auto &partition = lumped.partition;
+
+    REQUIRE(partition.size() == length + 1);
+    REQUIRE(lumped.model.nStates() == length + 1);
+    for (std::size_t i = 0; i + 1 < model.nStates(); ++i)
+      CHECK(partition.blocks[i] == partition.blocks[i % length]);
+    CHECK(partition.blocks.back() == length);
+    for (std::size_t b = 0; b < partition.size(); ++b) {
+      CHECK(partition.blocks[partition.representatives[b]] == b);
+      CHECK(lumped.model.states[b] == model.states[partition.representatives[b]]);
+    }
+
+    // The quotient rows are those of the representative, into blocks
+    const auto last = lumped.model(length - 1, 1);
+    REQUIRE(last.size() == 2);
+    CHECK(last.successors[0] == length - 1);
+    CHECK(last.successors[1] == length);
+    CHECK(last.probabilities[1] == Approx(0.5));
+    CHECK(lumped.model.expectedRewards[lumped.model.row(length - 1, 1)] == Approx(0.5));
+    CHECK(lumped.model.terminal[length]);
+  }
+
+  SECTION("States with distinct values stay apart") {
+    const auto chain = fixtures::MChain64();
+    CHECK(bisimulation::coarsest_partition(chain.indexedTransitionModel).size() == 64);
+
+    const auto data = CoinModelDataFixture{};
+    CHECK(bisimulation::coarsest_partition(data.environ.indexedTransitionModel).size() == 2);
+  }
+
+  SECTION("Blocks are stable") {
+    checkStable(Chains().indexedTransitionModel);
+    checkStable(fixtures::MChain64().indexedTransitionModel);
+    checkStable(CoinModelDataFixture{}.environ.indexedTransitionModel);
+  }
+}
+
+TEST_CASE("Value iteration over the quotient", "[bisimulation]") {
+
+  const auto environ = Chains();
+  const auto &model = environ.indexedTransitionModel;
+
+  auto serial = ChainsValueFunction{};
+  value_iteration::value_iteration_policy_estimation(serial, environ, 1e-6F);
+
+  SECTION("Values agree with the full model") {
+    auto lumped = ChainsValueFunction{};
+    bisimulation::value_iteration_policy_estimation(lumped, environ, 1e-6F);
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      const auto expected = i + 1 == model.nStates() ? 0.0 : fixtures::optimalChainValue(i % length, length + 1);
+      CHECK(lumped.valueAt(model.states[i]) == Approx(expected).margin(1e-4));
+      CHECK(lumped.valueAt(model.states[i]) == Approx(serial.valueAt(model.states[i])).margin(1e-4));
+    }
+  }
+
+  SECTION("Every state of a block takes its greedy action") {
+    auto values = ChainsValueFunction{};
+    auto policy = policy::FiniteDeterministicPolicy<Chains>(environ);
+    for (std::size_t i = 0; i < model.nStates(); ++i)
+      policy.setActionIndex(i, 1);
+
+    bisimulation::value_iteration(values, environ, policy, 1e-6F);
+    for (std::size_t i = 0; i + 1 < model.nStates(); ++i)
+      CHECK(policy.actionIndex(i) == 0);
+
+    const auto lumped = bisimulation::quotient(model);
+    CHECK(bisimulation::policy_improvement(values, environ, lumped, policy));
+  }
+
+  SECTION("States without a current action are not stable") {
+    // An empty table gives every action probability zero
+    using ChainsPolicy = policy::FiniteDistributionPolicy<policy::objectives::FiniteStateActionValueFunction<Chains>>;
+    auto policy = ChainsPolicy{};
+    const auto lumped = bisimulation::quotient(model);
+    CHECK_FALSE(bisimulation::policy_improvement(serial, environ, lumped, policy));
+  }
+}
@@ -12,8 +12,64 @@
 
 #include "coin_mdp.hpp"
 
+using namespace Catch;
+
 TEST_CASE("Finite MDP creating a type works") {
 
   // // Fill out the entire matrix of transition probs
   auto data = CoinModelDataFixture();
 }
+
+TEST_CASE("Finite MDP steps follow the transition probabilities") {
+
+  auto data = CoinModelDataFixture();
+  auto &environ = data.environ;
+  environ.seed(17);
+
+  const auto probabilities = environ.getTransitionProbabilities(data.s0, data.a0);
+  CHECK(probabilities.size() == 2);
+
+  constexpr int n = 20000;
+  int heads = 0;
+  for (int i = 0; i < n; ++i)
+    heads += environ.step(data.a0).nextState == data.s0;
+  CHECK(static_cast<double>(heads) / n == Approx(0.8).margin(0.02));
+
+  const auto &model = environ.indexedTransitionModel;
+  const auto row = model(model.stateIndex(data.s1), model.actionIndex(data.a1));
+  const auto probabilitiesS1A1 = environ.getTransitionProbabilities(data.s1, data.a1);
+  for (std::size_t k = 0; k < row.size(); ++k)
+    CHECK(
+        probabilitiesS1A1[k] ==
+        data.transitionModel.transitions.at({data.s1, data.a1, model.states[row.successors[k]]}));
+
+  auto emptyEnviron = CoinEnviron{CoinTransitionModel{}, data.s0};
+  CHECK_THROWS_AS(emptyEnviron.step(data.a0), std::out_of_range);
+}
+
+TEST_CASE("Finite MDP random actions are drawn from the reachable actions", "[markov_decision_process]") {
+
+  auto data = CoinModelDataFixture();
+  auto transitionModel = data.transitionModel;
+  std::erase_if(transitionModel.transitions, [&](const auto &entry) {
+    return entry.first.state == data.s1 and entry.first.action == data.a1;
+  });
+  auto environ = CoinEnviron{transitionModel, data.s0};
+  environ.seed(5);
+
+  int a0 = 0;
+  for (int i = 0; i < 1000; ++i) {
+    CHECK(environ.randomAction(data.s1) == data.a0);
+    a0 += environ.randomAction(data.s0) == data.a0;
+  }
+  CHECK(a0 > 400);
+  CHECK(a0 < 600);
+
+  CHECK(environ.isReachableAction(data.s1, data.a0));
+  CHECK_FALSE(environ.isReachableAction(data.s1, data.a1));
+  CHECK(environ.isReachableAction(data.s0, data.a1));
+
+  auto emptyEnviron = CoinEnviron{CoinTransitionModel{}, data.s0};
+  CHECK_THROWS_AS(emptyEnviron.randomAction(data.s0), std::out_of_range);
+  CHECK_FALSE(emptyEnviron.isReachableAction(data.s0, data.a0));
+}
@@ -0,0 +1,94 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/markov_decision_process/indexed_transition_model.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+
+TEST_CASE("IndexedTransitionModel compiles the transition map into rows") {
+
+  auto data = CoinModelDataFixture();
+  const auto &transitions = data.transitionModel.transitions;
+  const auto model = environment::IndexedTransitionModel<CoinReward>(
+      transitions, data.transitionModel.states, data.transitionModel.actions);
+
+  CHECK(model.nStates() == 2);
+  CHECK(model.nActions() == 2);
+  CHECK(model.nRows() == 4);
+  CHECK(model.nEntries() == transitions.size());
+  CHECK(model.rowOffsets.back() == transitions.size());
+
+  SECTION("States and actions are indexed by position") {
+    CHECK(model.stateIndex(data.s0) == 0);
+    CHECK(model.stateIndex(data.s1) == 1);
+    CHECK(model.actionIndex(data.a0) == 0);
+    CHECK(model.actionIndex(data.a1) == 1);
+  }
+
+  SECTION("Every row matches the transition map") {
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      CHECK(model.hasTransitions(i));
+      for (std::size_t a = 0; a < model.nActions(); ++a) {
+        const auto row = model(i, a);
+        CHECK(row.size() == 2);
+        double total = 0, expectedReward = 0;
+        for (std::size_t k = 0; k < row.size(); ++k) {
+          const auto t = T{model.states[i], model.actions[a], model.states[row.successors[k]]};
+          CHECK(row.probabilities[k] == transitions.at(t));
+          CHECK(row.rewards[k] == CoinReward::reward(t));
+          total += row.probabilities[k];
+          expectedReward += row.probabilities[k] * row.rewards[k];
+        }
+        CHECK(total == Approx(1.0));
+        CHECK(model.expectedRewards[model.row(i, a)] == Approx(expectedReward));
+      }
+    }
+  }
+
+  SECTION("Transitions to unknown states are rejected") {
+    auto bad = transitions;
+    bad.emplace(T{data.s0, data.a0, CoinState{2.0F, {}}}, 0.0F);
+    CHECK_THROWS_AS(
+        environment::IndexedTransitionModel<CoinReward>(bad, data.transitionModel.states, data.transitionModel.actions),
+        std::out_of_range);
+    CHECK(model.findState(CoinState{2.0F, {}}) == model.npos);
+  }
+
+  SECTION("Terminal states are those that only return to themselves with no reward") {
+    CHECK(not model.terminal[0]);
+    CHECK(not model.terminal[1]);
+
+    const auto chain = fixtures::MChain64();
+    const auto &absorbing = chain.indexedTransitionModel;
+    for (std::size_t i = 0; i + 1 < absorbing.nStates(); ++i)
+      CHECK(not absorbing.terminal[i]);
+    CHECK(absorbing.terminal[63]);
+    CHECK(absorbing.isAbsorbing(63));
+
+    const auto acyclic = fixtures::MAcyclicChain64();
+    CHECK(not acyclic.indexedTransitionModel.hasTransitions(63));
+    CHECK(acyclic.indexedTransitionModel.terminal[63]);
+    CHECK(not acyclic.indexedTransitionModel.isAbsorbing(63));
+    CHECK(not acyclic.indexedTransitionModel.terminal[62]);
+  }
+}
+
+TEST_CASE("MarkovDecisionEnvironment answers queries from the indexed model") {
+
+  auto data = CoinModelDataFixture();
+  const auto &environ = data.environ;
+
+  CHECK(environ.getAllPossibleStates().size() == 2);
+  CHECK(environ.getAllPossibleActions().size() == 2);
+  CHECK(environ.getReachableActions(data.s0).size() == 2);
+  CHECK(environ.getReachableStates(data.s0, data.a1).size() == 2);
+  CHECK(environ.getTransitions(data.s1, data.a0).size() == 2);
+
+  const auto unknown = CoinState{2.0F, {}};
+  CHECK(environ.getReachableActions(unknown).empty());
+  CHECK(environ.getReachableStates(unknown, data.a0).empty());
+  CHECK(environ.getTransitionProbabilities(unknown, data.a0).empty());
+}
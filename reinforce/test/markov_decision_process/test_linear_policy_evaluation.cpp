@@ -0,0 +1,91 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/markov_decision_process/linear_policy_evaluation.hpp>
+#include <reinforce/policy/finite/distribution_policy.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+// Discounted so that values depend on successors and not just the reward
+using DiscountedCoinValueFunction = policy::objectives::FiniteStateValueFunction<CoinEnviron, 0.0F, 0.9F>;
+
+TEST_CASE("Linear policy evaluation reaches the iterative fixed point") {
+
+  auto data = CoinModelDataFixture{};
+  const auto &environ = data.environ;
+  data.policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data.s0, data.a0)).value = 1.0F;
+  data.policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data.s0, data.a1)).value = 0.0F;
+  data.policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data.s1, data.a0)).value = 0.0F;
+  data.policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data.s1, data.a1)).value = 0.5F;
+
+  auto iterative = DiscountedCoinValueFunction{};
+  markov_decision_process::policy_evaluation(iterative, environ, data.policy, 1e-7F);
+
+  SECTION("The assembled system holds one entry per successor") {
+    auto values = DiscountedCoinValueFunction{};
+    const auto system = linear_solve::assemble(values, environ, data.policy);
+    CHECK(system.matrix.size() == 2);
+    CHECK(system.matrix.nEntries() == 4);
+    for (std::size_t i = 0; i < 2; ++i) {
+      // Every row of P_pi sums to one so every row of I - gamma P_pi sums to 1 - gamma
+      double total = 0.0;
+      for (auto k = system.matrix.rowOffsets[i]; k < system.matrix.rowOffsets[i + 1]; ++k)
+        total += system.matrix.values[k];
+      CHECK(total == Approx(0.1));
+    }
+  }
+
+  SECTION("Exact solve") {
+    auto exact = DiscountedCoinValueFunction{};
+    const auto result = linear_solve::policy_evaluation(exact, environ, data.policy, 1e-6F);
+    CHECK(result.residual <= 1e-6);
+    for (const auto &s : {data.s0, data.s1})
+      CHECK(exact.valueAt(s) == Approx(iterative.valueAt(s)).margin(1e-4));
+  }
+
+  SECTION("Repeated sweeps") {
+    auto swept = DiscountedCoinValueFunction{};
+    const auto delta = linear_solve::modified_policy_evaluation(swept, environ, data.policy, 500);
+    CHECK(delta < 1e-6F);
+    for (const auto &s : {data.s0, data.s1})
+      CHECK(swept.valueAt(s) == Approx(iterative.valueAt(s)).margin(1e-4));
+  }
+}
+
+TEST_CASE("Policy iteration with linear evaluation finds the optimal policy") {
+
+  using Chain = fixtures::MChain64;
+  using ChainValueFunction = policy::objectives::FiniteStateValueFunction<Chain, 0.0F, 0.99F>;
+  using ChainPolicy = policy::FiniteDistributionPolicy<policy::objectives::FiniteStateActionValueFunction<Chain>>;
+  constexpr auto n = fixtures::chainLength;
+
+  auto environ = Chain();
+  const auto &states = environ.indexedTransitionModel.states;
+  auto policy = ChainPolicy{};
+  // Starts uniform. From the all-stay policy every value is zero and policy
+  // iteration only fixes one state per improvement, however it evaluates.
+  policy.initialize(environ);
+
+  auto checkOptimal = [&](ChainValueFunction &values) {
+    fixtures::checkOptimalChainValues(values, 1e-3);
+    for (std::size_t i = 0; i + 1 < n; ++i)
+      CHECK(policy.getArgmaxAction(environ, states[i]) == Chain::ActionSpace{0});
+  };
+
+  SECTION("Exact evaluation needs a handful of solves") {
+    auto values = ChainValueFunction{};
+    const auto evaluations = linear_solve::policy_iteration(values, environ, policy, 1e-7F);
+    CHECK(evaluations <= 3);
+    checkOptimal(values);
+  }
+
+  SECTION("Modified policy iteration") {
+    auto values = ChainValueFunction{};
+    linear_solve::modified_policy_iteration(values, environ, policy, 8, 1e-7F);
+    checkOptimal(values);
+  }
+}
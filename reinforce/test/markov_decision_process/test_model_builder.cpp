@@ -0,0 +1,177 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <reinforce/markov_decision_process/model_builder.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+
+namespace {
+
+struct Row {
+  std::size_t state, action, nextState;
+  float probability, reward;
+};
+
+template <typename MODEL_T>
+std::vector<Row> rowsOf(const MODEL_T &model) {
+  auto rows = std::vector<Row>();
+  for (std::size_t i = 0; i < model.nStates(); ++i) {
+    for (std::size_t a = 0; a < model.nActions(); ++a) {
+      const auto row = model(i, a);
+      for (std::size_t k = 0; k < row.size(); ++k)
+        rows.push_back(Row{i, a, row.successors[k], row.probabilities[k], row.rewards[k]});
+    }
+  }
+  return rows;
+}
+
+/// @brief The compiled constructor keeps the order of the transition map within a row, the builder sorts by
+/// successor, so rows are compared as sets.
+template <typename MODEL_T>
+void checkSameModel(const MODEL_T &built, const MODEL_T &compiled) {
+  REQUIRE(built.nStates() == compiled.nStates());
+  REQUIRE(built.nActions() == compiled.nActions());
+  REQUIRE(built.nEntries() == compiled.nEntries());
+  CHECK(std::equal(built.rowOffsets.begin(), built.rowOffsets.end(), compiled.rowOffsets.begin()));
+  CHECK(std::equal(built.terminal.begin(), built.terminal.end(), compiled.terminal.begin()));
+  for (std::size_t r = 0; r < compiled.nRows(); ++r) {
+    CHECK(built.expectedRewards[r] == Approx(compiled.expectedRewards[r]));
+    const auto row = built[r];
+    CHECK(std::is_sorted(row.successors.begin(), row.successors.end()));
+    const auto expected = compiled[r];
+    for (std::size_t k = 0; k < expected.size(); ++k) {
+      const auto at = std::find(row.successors.begin(), row.successors.end(), expected.successors[k]);
+      REQUIRE(at != row.successors.end());
+      const auto j = static_cast<std::size_t>(at - row.successors.begin());
+      CHECK(row.probabilities[j] == Approx(expected.probabilities[k]));
+      CHECK(row.rewards[j] == Approx(expected.rewards[k]));
+    }
+  }
+}
+
+std::size_t nRunFiles() {
+  auto n = std::size_t(0);
+  for (const auto &entry : std::filesystem::directory_iterator(std::filesystem::temp_directory_path()))
+    n += entry.path().filename().string().starts_with("reinforce_model_builder_");
+  return n;
+}
+
+} // namespace
+
+TEST_CASE("The streaming builder reproduces compiled models") {
+
+  SECTION("Coin MDP, built in memory") {
+    auto data = CoinModelDataFixture{};
+    const auto &compiled = data.environ.indexedTransitionModel;
+    auto builder = environment::IndexedTransitionModelBuilder<CoinReward>(compiled.states, compiled.actions);
+    for (const auto &row : rowsOf(compiled))
+      builder.add(row.state, row.action, row.nextState, row.probability, row.reward);
+    CHECK(builder.size() == compiled.nEntries());
+
+    const auto built = builder.build();
+    CHECK(builder.nRuns() == 0);
+    checkSameModel(built, compiled);
+    CHECK(built.findState(data.s1) == compiled.findState(data.s1));
+  }
+
+  SECTION("Chain, shuffled and split into repeated entries across many runs") {
+    using Reward = fixtures::MChain64::RewardType;
+    const auto environ = fixtures::MChain64();
+    const auto &compiled = environ.indexedTransitionModel;
+
+    auto rows = rowsOf(compiled);
+    auto split = std::vector<Row>();
+    for (const auto &row : rows) {
+      split.push_back(Row{row.state, row.action, row.nextState, row.probability / 4, row.reward});
+      split.push_back(Row{row.state, row.action, row.nextState, row.probability * 3 / 4, row.reward});
+    }
+    auto gen = std::mt19937(7);
+    std::shuffle(split.begin(), split.end(), gen);
+
+    const auto before = nRunFiles();
+    auto builder = environment::IndexedTransitionModelBuilder<Reward>(
+        compiled.states, compiled.actions, environment::ModelBuilderOptions{.chunkSize = 7});
+    for (const auto &row : split)
+      builder.add(row.state, row.action, row.nextState, row.probability, row.reward);
+    CHECK(builder.nRuns() == split.size() / 7);
+    CHECK(nRunFiles() == before + builder.nRuns());
+
+    const auto built = builder.build();
+    checkSameModel(built, compiled);
+    CHECK(builder.nRuns() == 0);
+    CHECK(builder.size() == 0);
+    CHECK(nRunFiles() == before);
+  }
+}
+
+TEST_CASE("The streaming builder validates what it is given") {
+
+  using Reward = fixtures::MChain64::RewardType;
+  const auto environ = fixtures::MChain64();
+  const auto &compiled = environ.indexedTransitionModel;
+
+  SECTION("Indices and probabilities are checked as they are added") {
+    auto builder = environment::IndexedTransitionModelBuilder<Reward>(compiled.states, compiled.actions);
+    CHECK_THROWS_AS(builder.add(compiled.nStates(), 0, 0, 1, 0), std::out_of_range);
+    CHECK_THROWS_AS(builder.add(0, compiled.nActions(), 0, 1, 0), std::out_of_range);
+    CHECK_THROWS_AS(builder.add(0, 0, compiled.nStates(), 1, 0), std::out_of_range);
+    CHECK_THROWS_AS(builder.add(0, 0, 1, 1.5F, 0), std::invalid_argument);
+    CHECK_THROWS_AS(builder.add(0, 0, 1, -0.5F, 0), std::invalid_argument);
+    CHECK(builder.size() == 0);
+  }
+
+  SECTION("Every (state, action) pair must sum to one") {
+    for (const auto chunkSize : {std::size_t(2), std::size_t(1) << 10}) {
+      auto builder = environment::IndexedTransitionModelBuilder<Reward>(
+          compiled.states, compiled.actions, environment::ModelBuilderOptions{.chunkSize = chunkSize});
+      builder.add(0, 0, 1, 0.5F, 0);
+      builder.add(0, 1, 0, 1, 0);
+      builder.add(3, 0, 4, 0.25F, 0);
+      builder.add(3, 0, 4, 0.5F, 0);
+      CHECK_THROWS_AS(builder.build(), std::invalid_argument);
+    }
+  }
+
+  SECTION("Pairs without transitions are left empty") {
+    auto builder = environment::IndexedTransitionModelBuilder<Reward>(compiled.states, compiled.actions);
+    builder.add(5, 1, 5, 1, 2);
+    builder.add(2, 0, 3, 0.5F, 1);
+    builder.add(2, 0, 2, 0.5F, 3);
+    const auto built = builder.build();
+    CHECK(built.nEntries() == 3);
+    CHECK(built(0, 0).empty());
+    CHECK(built(2, 1).empty());
+    CHECK(built(2, 0).size() == 2);
+    CHECK(built.expectedRewards[built.row(2, 0)] == Approx(2));
+    CHECK(built(5, 1).size() == 1);
+    CHECK(built.expectedRewards[built.row(5, 1)] == Approx(2));
+    CHECK(built(63, 1).empty());
+  }
+
+  SECTION("Offsets step over runs of empty rows") {
+    // Every third row has as many entries as its row index modulo 4, so some
+    // of them are empty too
+    auto builder = environment::IndexedTransitionModelBuilder<Reward>(
+        compiled.states, compiled.actions, environment::ModelBuilderOptions{.chunkSize = 16});
+    auto expected = std::vector<std::size_t>{0};
+    for (std::size_t r = 0; r < compiled.nRows(); ++r) {
+      const auto n = r % 3 == 1 ? r % 4 : 0;
+      for (std::size_t k = 0; k < n; ++k)
+        builder.add(r / compiled.nActions(), r % compiled.nActions(), k, 1.0F / static_cast<float>(n), 0);
+      expected.push_back(expected.back() + n);
+    }
+    CHECK(builder.nRuns() > 1);
+    const auto built = builder.build();
+    REQUIRE(built.rowOffsets.size() == expected.size());
+    CHECK(std::equal(built.rowOffsets.begin(), built.rowOffsets.end(), expected.begin()));
+  }
+}
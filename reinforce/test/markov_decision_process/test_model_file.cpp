@@ -0,0 +1,167 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <reinforce/markov_decision_process/model_file.hpp>
+#include <reinforce/markov_decision_process/value_iteration.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+namespace {
+
+std::filesystem::path temporaryPath(const std::string &name) {
+  return std::filesystem::temp_directory_path() / ("reinforce_test_" + name + ".mdp");
+}
+
+template <typename MODEL_T>
+void checkSameModel(const MODEL_T &lhs, const MODEL_T &rhs) {
+  REQUIRE(lhs.nStates() == rhs.nStates());
+  REQUIRE(lhs.nActions() == rhs.nActions());
+  REQUIRE(lhs.nEntries() == rhs.nEntries());
+  for (std::size_t i = 0; i < lhs.nStates(); ++i)
+    CHECK(lhs.states[i] == rhs.states[i]);
+  for (std::size_t a = 0; a < lhs.nActions(); ++a)
+    CHECK(lhs.actions[a] == rhs.actions[a]);
+  CHECK(std::equal(lhs.rowOffsets.begin(), lhs.rowOffsets.end(), rhs.rowOffsets.begin()));
+  CHECK(std::equal(lhs.successors.begin(), lhs.successors.end(), rhs.successors.begin()));
+  CHECK(std::equal(lhs.probabilities.begin(), lhs.probabilities.end(), rhs.probabilities.begin()));
+  CHECK(std::equal(lhs.rewards.begin(), lhs.rewards.end(), rhs.rewards.begin()));
+  CHECK(std::equal(lhs.expectedRewards.begin(), lhs.expectedRewards.end(), rhs.expectedRewards.begin()));
+  CHECK(std::equal(lhs.terminal.begin(), lhs.terminal.end(), rhs.terminal.begin()));
+}
+
+environment::model_file::Header readHeader(const std::filesystem::path &path) {
+  auto header = environment::model_file::Header{};
+  std::ifstream(path, std::ios::binary).read(reinterpret_cast<char *>(&header), sizeof(header));
+  return header;
+}
+
+template <typename T>
+void overwrite(const std::filesystem::path &path, std::uint64_t offset, const T &value) {
+  auto file = std::fstream(path, std::ios::binary | std::ios::in | std::ios::out);
+  file.seekp(static_cast<std::streamoff>(offset));
+  file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+TEST_CASE("A compiled model round trips through a model file") {
+
+  SECTION("Coin MDP") {
+    auto data = CoinModelDataFixture{};
+    const auto path = temporaryPath("coin");
+    environment::model_file::write(path, data.environ.indexedTransitionModel);
+    const auto mapped = environment::model_file::read<CoinReward>(path);
+    checkSameModel(mapped, data.environ.indexedTransitionModel);
+    CHECK(mapped.findState(data.s1) == data.environ.indexedTransitionModel.findState(data.s1));
+    std::filesystem::remove(path);
+  }
+
+  SECTION("The mapping outlives the file name and every copy of the model") {
+    const auto environ = fixtures::MChain64();
+    const auto path = temporaryPath("chain");
+    environment::model_file::write(path, environ.indexedTransitionModel);
+    auto copy = environment::model_file::read<fixtures::MChain64::RewardType>(path);
+    {
+      const auto mapped = environment::model_file::read<fixtures::MChain64::RewardType>(path);
+      copy = mapped;
+    }
+    std::filesystem::remove(path);
+    checkSameModel(copy, environ.indexedTransitionModel);
+  }
+}
+
+TEST_CASE("Environments can be served from a model file") {
+
+  auto data = CoinModelDataFixture{};
+  const auto path = temporaryPath("coin_environment");
+  environment::model_file::write(path, data.environ.indexedTransitionModel);
+
+  SECTION("A concrete environment inherits the model constructor") {
+    auto environ = CoinEnviron(environment::model_file::read<CoinReward>(path), data.s0);
+    CHECK(environ.transitionModel.transitions.empty());
+    CHECK(environ.getAllPossibleStates() == data.environ.getAllPossibleStates());
+    CHECK(environ.getReachableStates(data.s0, data.a1) == data.environ.getReachableStates(data.s0, data.a1));
+    CHECK(environ.stateFromIndex(1) == data.environ.stateFromIndex(1));
+
+    auto serial = policy::objectives::FiniteStateValueFunction<CoinEnviron, 0.0F, 0.9F>{};
+    auto mapped = serial;
+    value_iteration::value_iteration_policy_estimation(serial, data.environ, 1e-6F);
+    value_iteration::value_iteration_policy_estimation(mapped, environ, 1e-6F);
+    for (const auto &s : {data.s0, data.s1})
+      CHECK(mapped.valueAt(s) == Approx(serial.valueAt(s)));
+  }
+
+  SECTION("The generic reader environment steps from the mapping") {
+    using Mapped = environment::MappedMarkovDecisionEnvironment<CoinStep, CoinReward, CoinReturn>;
+    auto environ = Mapped(path, data.s1);
+    CHECK(environ.reset() == data.s1);
+    environ.seed(3);
+    for (int i = 0; i < 20; ++i) {
+      const auto t = environ.step(data.a0);
+      CHECK(environ.getReachableStates(t.state, data.a0).contains(t.nextState));
+      environ.update(t);
+    }
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Invalid model files are rejected") {
+
+  auto data = CoinModelDataFixture{};
+  const auto path = temporaryPath("invalid");
+
+  SECTION("Missing file") {
+    std::filesystem::remove(path);
+    CHECK_THROWS_AS(environment::model_file::read<CoinReward>(path), std::system_error);
+  }
+
+  SECTION("Not a model file") {
+    std::ofstream(path) << "definitely not an MDP";
+    CHECK_THROWS_AS(environment::model_file::read<CoinReward>(path), std::runtime_error);
+  }
+
+  SECTION("Unsupported version") {
+    environment::model_file::write(path, data.environ.indexedTransitionModel);
+    {
+      auto file = std::fstream(path, std::ios::binary | std::ios::in | std::ios::out);
+      const std::uint32_t future = environment::model_file::version + 1;
+      file.seekp(offsetof(environment::model_file::Header, version));
+      file.write(reinterpret_cast<const char *>(&future), sizeof(future));
+    }
+    CHECK_THROWS_AS(environment::model_file::read<CoinReward>(path), std::runtime_error);
+  }
+
+  SECTION("Successor out of range") {
+    environment::model_file::write(path, data.environ.indexedTransitionModel);
+    const auto header = readHeader(path);
+    overwrite(path, header.successors.offset, static_cast<std::uint32_t>(header.nStates));
+    CHECK_THROWS_AS(environment::model_file::read<CoinReward>(path), std::runtime_error);
+    // Trusted files skip the pass over the entries
+    CHECK_NOTHROW(environment::model_file::read<CoinReward>(path, environment::model_file::Validation::sections));
+  }
+
+  SECTION("Decreasing row offsets") {
+    environment::model_file::write(path, data.environ.indexedTransitionModel);
+    const auto header = readHeader(path);
+    overwrite(path, header.rowOffsets.offset + sizeof(std::uint64_t), header.nEntries + 1);
+    CHECK_THROWS_AS(environment::model_file::read<CoinReward>(path), std::runtime_error);
+  }
+
+  SECTION("Truncated file") {
+    environment::model_file::write(path, data.environ.indexedTransitionModel);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    CHECK_THROWS_AS(environment::model_file::read<CoinReward>(path), std::runtime_error);
+  }
+
+  std::filesystem::remove(path);
+}
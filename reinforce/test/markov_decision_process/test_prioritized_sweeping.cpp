@@ -0,0 +1,55 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/markov_decision_process/prioritized_sweeping.hpp>
+#include <reinforce/markov_decision_process/value_iteration.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+TEST_CASE("The indexed model lists the predecessors of every state") {
+  const auto environ = fixtures::MChain64();
+  const auto predecessors = environ.indexedTransitionModel.predecessors();
+
+  // 0 only reaches itself, every other state is reached from itself and its left neighbour
+  CHECK(predecessors[0].size() == 1);
+  for (std::size_t i = 1; i < 64; ++i) {
+    REQUIRE(predecessors[i].size() == 2);
+    CHECK(predecessors[i][0] == i - 1);
+    CHECK(predecessors[i][1] == i);
+  }
+}
+
+TEST_CASE("Prioritized sweeping converges to the value iteration estimate") {
+
+  SECTION("Coin MDP") {
+    auto data = CoinModelDataFixture{};
+    auto serial = policy::objectives::FiniteStateValueFunction<CoinEnviron, 0.0F, 0.9F>{};
+    auto prioritized = serial;
+    value_iteration::value_iteration_policy_estimation(serial, data.environ, 1e-6F);
+    prioritized_sweeping::value_iteration_policy_estimation(prioritized, data.environ, 1e-6F);
+    for (const auto &s : {data.s0, data.s1})
+      CHECK(prioritized.valueAt(s) == Approx(serial.valueAt(s)).margin(1e-4));
+  }
+
+  SECTION("A long chain needs far fewer backups than full sweeps") {
+    constexpr auto n = fixtures::chainLength;
+    const auto environ = fixtures::MChain64();
+    auto serial = policy::objectives::FiniteStateValueFunction<fixtures::MChain64, 0.0F, 0.9F>{};
+    auto prioritized = serial;
+    value_iteration::value_iteration_policy_estimation(serial, environ, 1e-6F);
+    const auto backups = prioritized_sweeping::value_iteration_policy_estimation(prioritized, environ, 1e-6F);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto &s = environ.indexedTransitionModel.states[i];
+      CHECK(prioritized.valueAt(s) == Approx(fixtures::optimalChainValue(i, n, 0.9)).margin(1e-4));
+      CHECK(prioritized.valueAt(s) == Approx(serial.valueAt(s)).margin(1e-4));
+    }
+    // In index order the serial sweeps move the reward back one state per
+    // sweep, so they need on the order of n * n backups.
+    CHECK(backups < 4 * n);
+  }
+}
@@ -0,0 +1,107 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+
+#include <reinforce/markov_decision_process/real_time_dynamic_programming.hpp>
+#include <reinforce/markov_decision_process/value_iteration.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+namespace {
+
+using fixtures::optimalChainValue;
+using fixtures::UpperChain;
+using UpperChainValueFunction = policy::objectives::FiniteStateValueFunction<UpperChain, 0.0F, 0.99F>;
+constexpr auto n = fixtures::chainLength;
+
+} // namespace
+
+TEST_CASE("LRTDP only solves the states reachable from reset") {
+
+  auto environ = UpperChain();
+  const auto &model = environ.indexedTransitionModel;
+  auto values = UpperChainValueFunction{};
+  auto engine = rng::Engine(3);
+
+  const auto result =
+      rtdp::value_iteration_policy_estimation(values, environ, 1e-6F, rtdp::Options{.solvedStarts = 1}, engine);
+
+  CHECK(result.converged);
+  CHECK(result.states.size() == n / 2);
+  CHECK(std::all_of(result.states.begin(), result.states.end(), [](auto i) { return i >= n / 2; }));
+  for (std::size_t i = n / 2; i < n; ++i)
+    CHECK(values.valueAt(model.states[i]) == Approx(optimalChainValue(i)).margin(1e-4));
+  for (std::size_t i = 0; i < n / 2; ++i)
+    CHECK(values.find(model.states[i]) == values.end());
+}
+
+TEST_CASE("LRTDP agrees with value iteration on a stochastic model") {
+
+  using DiscountedCoinValueFunction = policy::objectives::FiniteStateValueFunction<CoinEnviron, 0.0F, 0.9F>;
+  auto data = CoinModelDataFixture{};
+  auto engine = rng::Engine(5);
+
+  auto serial = DiscountedCoinValueFunction{};
+  value_iteration::value_iteration_policy_estimation(serial, data.environ, 1e-7F);
+
+  auto labelled = DiscountedCoinValueFunction{};
+  const auto result = rtdp::value_iteration_policy_estimation(labelled, data.environ, 1e-7F, {}, engine);
+  CHECK(result.converged);
+  CHECK(result.states.size() == 2);
+  CHECK(labelled.valueAt(data.s0) == Approx(serial.valueAt(data.s0)).margin(1e-4));
+  CHECK(labelled.valueAt(data.s1) == Approx(serial.valueAt(data.s1)).margin(1e-4));
+}
+
+TEST_CASE("RTDP trials and the greedy policy") {
+
+  auto environ = UpperChain();
+  const auto &model = environ.indexedTransitionModel;
+  auto engine = rng::Engine(7);
+
+  SECTION("Plain trials propagate the reward back one state per trial") {
+    auto values = UpperChainValueFunction{};
+    const auto result = rtdp::trial_policy_estimation(values, environ, n / 2, {}, engine);
+    CHECK(result.trials == n / 2);
+    for (std::size_t i = n / 2; i < n; ++i)
+      CHECK(values.valueAt(model.states[i]) == Approx(optimalChainValue(i)).margin(1e-4));
+  }
+
+  SECTION("Only the policy of visited states is improved") {
+    auto values = UpperChainValueFunction{};
+    auto policy = policy::FiniteDeterministicPolicy<UpperChain>(environ);
+    for (std::size_t i = 0; i < n; ++i)
+      policy.setActionIndex(i, 1);
+
+    rtdp::value_iteration(values, environ, policy, 1e-6F, rtdp::Options{.solvedStarts = 1}, engine);
+    for (std::size_t i = 0; i < n / 2; ++i)
+      CHECK(policy.actionIndex(i) == 1);
+    for (std::size_t i = n / 2; i < n - 1; ++i)
+      CHECK(policy.actionIndex(i) == 0);
+  }
+}
+
+TEST_CASE("LRTDP plans alike with dense storage") {
+
+  auto environ = UpperChain();
+  const auto &model = environ.indexedTransitionModel;
+  auto sparseEngine = rng::Engine(11);
+  auto denseEngine = rng::Engine(11);
+
+  auto sparse = UpperChainValueFunction{};
+  auto dense = UpperChainValueFunction{};
+  const auto sparseResult = rtdp::value_iteration_policy_estimation(
+      sparse, environ, 1e-6F, rtdp::Options{.solvedStarts = 1}, sparseEngine);
+  const auto denseResult = rtdp::value_iteration_policy_estimation(
+      dense, environ, 1e-6F, rtdp::Options{.solvedStarts = 1, .denseStorage = true}, denseEngine);
+
+  CHECK(denseResult.converged);
+  CHECK(denseResult.trials == sparseResult.trials);
+  CHECK(denseResult.backups == sparseResult.backups);
+  CHECK(denseResult.states == sparseResult.states);
+  for (const auto i : sparseResult.states)
+    CHECK(dense.valueAt(model.states[i]) == Approx(sparse.valueAt(model.states[i])).margin(1e-6));
+}
@@ -0,0 +1,57 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/markov_decision_process/synchronous.hpp>
+
+#include "coin_mdp.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+// Discounted so that values depend on successors and not just the reward
+using DiscountedCoinValueFunction = policy::objectives::FiniteStateValueFunction<CoinEnviron, 0.0F, 0.9F>;
+
+TEST_CASE("Synchronous dynamic programming reaches the serial fixed point") {
+
+  auto serial = CoinModelDataFixture{};
+  auto parallel = CoinModelDataFixture{};
+  const auto &environ = serial.environ;
+  auto pool = utils::ThreadPool(3);
+  auto serialValues = DiscountedCoinValueFunction{};
+  auto parallelValues = DiscountedCoinValueFunction{};
+
+  for (auto *data : {&serial, &parallel}) {
+    data->policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data->s0, data->a0)).value = 1.0F;
+    data->policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data->s0, data->a1)).value = 0.0F;
+    data->policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data->s1, data->a0)).value = 0.0F;
+    data->policy.at(CoinDistributionPolicy::KeyMaker::make(environ, data->s1, data->a1)).value = 0.0F;
+  }
+
+  SECTION("Policy evaluation") {
+    policy_evaluation(serialValues, environ, serial.policy, 1e-6F);
+    synchronous::policy_evaluation(parallelValues, environ, parallel.policy, 1e-6F, pool);
+    for (const auto &s : {serial.s0, serial.s1})
+      CHECK(parallelValues.valueAt(s) == Approx(serialValues.valueAt(s)).margin(1e-4));
+  }
+
+  SECTION("Value iteration") {
+    value_iteration::value_iteration(serialValues, environ, serial.policy, 1e-6F);
+    synchronous::value_iteration(parallelValues, environ, parallel.policy, 1e-6F, pool);
+    for (const auto &s : {serial.s0, serial.s1}) {
+      CHECK(parallelValues.valueAt(s) == Approx(serialValues.valueAt(s)).margin(1e-4));
+      for (const auto &a : {serial.a0, serial.a1})
+        CHECK(parallel.policy.getProbability(environ, s, a) == Approx(serial.policy.getProbability(environ, s, a)));
+    }
+  }
+
+  SECTION("Policy iteration") {
+    policy_iteration(serialValues, environ, serial.policy, 1e-6F);
+    synchronous::policy_iteration(parallelValues, environ, parallel.policy, 1e-6F, pool);
+    for (const auto &s : {serial.s0, serial.s1}) {
+      CHECK(parallelValues.valueAt(s) == Approx(serialValues.valueAt(s)).margin(1e-4));
+      for (const auto &a : {serial.a0, serial.a1})
+        CHECK(parallel.policy.getProbability(environ, s, a) == Approx(serial.policy.getProbability(environ, s, a)));
+    }
+    CHECK(synchronous::policy_improvement(parallelValues, environ, parallel.policy, pool));
+  }
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <set>
+
+#include <reinforce/markov_decision_process/topological_value_iteration.hpp>
+#include <reinforce/markov_decision_process/value_iteration.hpp>
+
+#include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+TEST_CASE("The indexed model finds strongly connected components in reverse topological order") {
+
+  SECTION("Every state of a chain is its own component, terminal first") {
+    const auto environ = fixtures::MChain64();
+    const auto components = environ.indexedTransitionModel.stronglyConnectedComponents();
+    REQUIRE(components.size() == 64);
+    for (std::size_t c = 0; c < 64; ++c) {
+      REQUIRE(components[c].size() == 1);
+      CHECK(components[c][0] == 63 - c);
+    }
+  }
+
+  SECTION("The coin MDP is a single component") {
+    auto data = CoinModelDataFixture{};
+    const auto components = data.environ.indexedTransitionModel.stronglyConnectedComponents();
+    REQUIRE(components.size() == 1);
+    CHECK(std::set<std::size_t>(components[0].begin(), components[0].end()) == std::set<std::size_t>{0, 1});
+  }
+
+  SECTION("Every transition leads to the same or an earlier component") {
+    const auto environ = fixtures::MS5A10();
+    const auto &model = environ.indexedTransitionModel;
+    const auto components = model.stronglyConnectedComponents();
+    auto componentOf = std::vector<std::size_t>(model.nStates());
+    std::size_t nStates = 0;
+    for (std::size_t c = 0; c < components.size(); ++c) {
+      for (const auto i : components[c])
+        componentOf[i] = c;
+      nStates += components[c].size();
+    }
+    CHECK(nStates == model.nStates());
+    for (std::size_t i = 0; i < model.nStates(); ++i) {
+      for (std::size_t a = 0; a < model.nActions(); ++a) {
+        for (const auto j : model(i, a).successors)
+          CHECK(componentOf[j] <= componentOf[i]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Topological value iteration converges to the value iteration estimate") {
+
+  SECTION("Coin MDP") {
+    auto data = CoinModelDataFixture{};
+    auto serial = policy::objectives::FiniteStateValueFunction<CoinEnviron, 0.0F, 0.9F>{};
+    auto topological = serial;
+    value_iteration::value_iteration_policy_estimation(serial, data.environ, 1e-6F);
+    topological::value_iteration_policy_estimation(topological, data.environ, 1e-6F);
+    for (const auto &s : {data.s0, data.s1})
+      CHECK(topological.valueAt(s) == Approx(serial.valueAt(s)).margin(1e-4));
+  }
+
+  SECTION("A chain with self transitions") {
+    const auto environ = fixtures::MChain64();
+    auto serial = policy::objectives::FiniteStateValueFunction<fixtures::MChain64, 0.0F, 0.9F>{};
+    auto topological = serial;
+    value_iteration::value_iteration_policy_estimation(serial, environ, 1e-6F);
+    const auto backups = topological::value_iteration_policy_estimation(topological, environ, 1e-6F);
+    for (const auto &s : environ.indexedTransitionModel.states)
+      CHECK(topological.valueAt(s) == Approx(serial.valueAt(s)).margin(1e-4));
+    // Each singleton with a self transition settles after a couple of backups
+    CHECK(backups <= 3 * 64);
+  }
+
+  SECTION("An acyclic chain takes exactly one backup per state") {
+    constexpr auto n = fixtures::chainLength;
+    const auto environ = fixtures::MAcyclicChain64();
+    auto values = policy::objectives::FiniteStateValueFunction<fixtures::MAcyclicChain64, 0.0F, 0.9F>{};
+    const auto backups = topological::value_iteration_policy_estimation(values, environ, 1e-6F);
+
+    // The terminal state has no transitions and is never backed up
+    CHECK(backups == n - 1);
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+      const auto steps = (n - 1 - i + 1) / 2;
+      const auto expected = std::pow(0.9, steps - 1);
+      CHECK(values.valueAt(environ.indexedTransitionModel.states[i]) == Approx(expected).margin(1e-5));
+    }
+  }
+}
@@ -1,15 +1,24 @@
+#include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <iostream>
 #include <limits>
 
+#include <reinforce/markov_decision_process/bisimulation.hpp>
 #include <reinforce/markov_decision_process/finite_transition_model.hpp>
+#include <reinforce/markov_decision_process/linear_policy_evaluation.hpp>
 #include <reinforce/markov_decision_process/policy_iteration.hpp>
+#include <reinforce/markov_decision_process/prioritized_sweeping.hpp>
+#include <reinforce/markov_decision_process/real_time_dynamic_programming.hpp>
+#include <reinforce/markov_decision_process/synchronous.hpp>
+#include <reinforce/markov_decision_process/topological_value_iteration.hpp>
 #include <reinforce/markov_decision_process/value_iteration.hpp>
 #include <reinforce/policy/distribution_policy.hpp>
+#include <reinforce/policy/finite/distribution_policy.hpp>
 #include <reinforce/policy/random_policy.hpp>
 
 #include "coin_mdp.hpp"
+#include "environment_fixtures.hpp"
 
 using namespace Catch;
 using namespace environment;
@@ -65,4 +74,66 @@ TEST_CASE("Coin MPD can undergo policy value iteration") {
     auto p11 = policy.getProbability(environ, s1, a1);
     REQUIRE_THAT(p11, Catch::Matchers::WithinAbs(0.0, std::numeric_limits<float>::epsilon()));
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Absorbing states are worth zero whatever the initial value") {
+
+  // The last state of the chain only returns to itself with no reward. An
+  // initial value above every optimal value keeps the real time planner
+  // optimistic.
+  using Chain = fixtures::MChain64;
+  using ChainValueFunction = policy::objectives::FiniteStateValueFunction<Chain, 5.0F, 0.99F>;
+  using ChainPolicy = policy::FiniteDistributionPolicy<policy::objectives::FiniteStateActionValueFunction<Chain>>;
+  constexpr auto n = fixtures::chainLength;
+
+  auto environ = Chain();
+  const auto &states = environ.indexedTransitionModel.states;
+  REQUIRE(environ.indexedTransitionModel.isAbsorbing(n - 1));
+  auto values = ChainValueFunction{};
+
+  SECTION("In place sweeps") {
+    value_iteration_policy_estimation(values, environ, 1e-6F);
+    fixtures::checkOptimalChainValues(values, 1e-3);
+  }
+
+  SECTION("Synchronous sweeps") {
+    auto pool = utils::ThreadPool(2);
+    synchronous::value_iteration_policy_estimation(values, environ, 1e-6F, pool);
+    fixtures::checkOptimalChainValues(values, 1e-3);
+  }
+
+  SECTION("Topological sweeps") {
+    topological::value_iteration_policy_estimation(values, environ, 1e-6F);
+    fixtures::checkOptimalChainValues(values, 1e-3);
+  }
+
+  SECTION("Prioritized sweeping") {
+    prioritized_sweeping::value_iteration_policy_estimation(values, environ, 1e-6F);
+    fixtures::checkOptimalChainValues(values, 1e-3);
+  }
+
+  SECTION("Bisimulation quotient") {
+    bisimulation::value_iteration_policy_estimation(values, environ, 1e-6F);
+    fixtures::checkOptimalChainValues(values, 1e-3);
+  }
+
+  SECTION("Real time dynamic programming") {
+    auto engine = rng::Engine(3);
+    rtdp::value_iteration_policy_estimation(values, environ, 1e-6F, rtdp::Options{.solvedStarts = 1}, engine);
+    fixtures::checkOptimalChainValues(values, 1e-3);
+  }
+
+  SECTION("Policy evaluation") {
+    auto policy = ChainPolicy{};
+    policy.initialize(environ);
+    policy_evaluation(values, environ, policy, 1e-6F);
+    CHECK(values.valueAt(states[n - 1]) == 0.0F);
+  }
+
+  SECTION("Linear policy iteration") {
+    auto policy = ChainPolicy{};
+    policy.initialize(environ);
+    linear_solve::policy_iteration(values, environ, policy, 1e-7F);
+    fixtures::checkOptimalChainValues(values, 1e-3);
+  }
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <limits>
+
+#include <reinforce/markov_decision_process/linear_policy_evaluation.hpp>
+#include <reinforce/markov_decision_process/policy_iteration.hpp>
+#include <reinforce/markov_decision_process/synchronous.hpp>
+#include <reinforce/policy/finite/deterministic_policy.hpp>
+
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace policy;
+using namespace fixtures;
+
+TEST_CASE("FiniteDeterministicPolicy", "[policy][finite][deterministic]") {
+
+  const auto env = MChain64{};
+  const auto &model = env.indexedTransitionModel;
+  const auto s3 = model.states[3];
+  const auto stay = MChain64::ActionSpace{1};
+  const auto right = MChain64::ActionSpace{0};
+
+  auto policy = FiniteDeterministicPolicy<MChain64>(env);
+  static_assert(isDistributionPolicy<decltype(policy)>);
+  static_assert(isDeterministicPolicy<decltype(policy)>);
+  REQUIRE(policy.size() == model.nStates());
+
+  SECTION("Starts on the first action with transitions") {
+    for (std::size_t i = 0; i < model.nStates(); ++i)
+      CHECK(policy.actionIndex(i) == 0);
+
+    const auto acyclic = MAcyclicChain64{};
+    const auto other = FiniteDeterministicPolicy<MAcyclicChain64>(acyclic);
+    CHECK(other.actionIndex(63) == 0);
+  }
+
+  SECTION("The distribution puts all mass on one action") {
+    CHECK(policy.getProbability(env, s3, right) == 1.0F);
+    CHECK(policy.getProbability(env, s3, stay) == 0.0F);
+    CHECK(policy.getLogProbability(env, s3, right) == 0.0F);
+    CHECK(policy.getLogProbability(env, s3, stay) == -std::numeric_limits<float>::infinity());
+    CHECK(policy.getNormalisationConstant(env, s3) == 1.0F);
+    CHECK(policy.getArgmaxAction(env, s3) == right);
+    CHECK(policy(env, s3) == right);
+
+    const auto probabilities = policy.getProbabilities(env, s3);
+    REQUIRE(probabilities.size() == 1);
+    CHECK(probabilities[0].first == std::make_pair(s3, right));
+    CHECK(probabilities[0].second == 1.0F);
+  }
+
+  SECTION("Setting an action only changes that state") {
+    policy.setDeterministicPolicy(env, s3, stay);
+    CHECK(policy.actionIndex(3) == 1);
+    CHECK(policy.getProbability(env, s3, stay) == 1.0F);
+    CHECK(policy.getArgmaxAction(env, model.states[4]) == right);
+    policy.setActionIndex(3, 0);
+    CHECK(policy.getArgmaxAction(env, s3) == right);
+  }
+}
+
+TEST_CASE("Policy iteration over a deterministic policy", "[policy][finite][deterministic]") {
+
+  using ChainValueFunction = policy::objectives::FiniteStateValueFunction<MChain64, 0.0F, 0.99F>;
+  constexpr auto n = chainLength;
+
+  const auto env = MChain64{};
+  auto policy = FiniteDeterministicPolicy<MChain64>(env);
+  // Stay in every other state, so improvement has something to fix
+  for (std::size_t i = 0; i < n; i += 2)
+    policy.setActionIndex(i, 1);
+
+  auto checkOptimal = [&](ChainValueFunction &values) {
+    checkOptimalChainValues(values, 1e-3);
+    for (std::size_t i = 0; i + 1 < n; ++i)
+      CHECK(policy.actionIndex(i) == 0);
+  };
+
+  SECTION("In place") {
+    auto values = ChainValueFunction{};
+    markov_decision_process::policy_iteration(values, env, policy, 1e-6F);
+    checkOptimal(values);
+  }
+
+  SECTION("Synchronous") {
+    auto pool = utils::ThreadPool(2);
+    auto values = ChainValueFunction{};
+    markov_decision_process::synchronous::policy_iteration(values, env, policy, 1e-6F, pool);
+    checkOptimal(values);
+  }
+
+  SECTION("Linear solve") {
+    auto values = ChainValueFunction{};
+    const auto evaluations = markov_decision_process::linear_solve::policy_iteration(values, env, policy, 1e-7F);
+    // Values upstream of a stay are zero and tie, so each improvement repairs the stay nearest the goal
+    CHECK(evaluations <= n / 2 + 1);
+    checkOptimal(values);
+  }
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <vector>
+
+#include <reinforce/policy/objectives/argmax_kernels.hpp>
+#include <reinforce/policy/objectives/dense_finite_value_function.hpp>
+#include <reinforce/policy/objectives/finite_value_function.hpp>
+
+#include "environment_fixtures.hpp"
+
+using namespace policy::objectives;
+using namespace fixtures;
+
+namespace {
+
+template <typename T>
+struct Entry {
+  T value;
+  std::size_t step;
+};
+
+template <typename T>
+std::size_t argmax(const std::vector<Entry<T>> &entries, const std::vector<std::uint8_t> &mask) {
+  return kernels::masked_argmax(&entries[0].value, sizeof(Entry<T>), mask.data(), entries.size());
+}
+
+template <typename T>
+void checkKernel() {
+  // Long enough for full vectors and a scalar tail
+  constexpr std::size_t n = 21;
+  auto entries = std::vector<Entry<T>>(n);
+  auto mask = std::vector<std::uint8_t>(n, 1);
+  for (std::size_t k = 0; k < n; ++k)
+    entries[k] = {T(-10) - T(k), k};
+
+  CHECK(argmax(entries, mask) == 0);
+
+  entries[13].value = 5;
+  entries[18].value = 5;
+  CHECK(argmax(entries, mask) == 13);
+
+  // Masked entries are never chosen, whatever their value
+  mask[13] = 0;
+  CHECK(argmax(entries, mask) == 18);
+  entries[20].value = 7;
+  CHECK(argmax(entries, mask) == 20);
+  mask[20] = 0;
+  mask[18] = 0;
+  CHECK(argmax(entries, mask) == 0);
+
+  // The first of equal values wins across lanes
+  entries[3].value = 1;
+  entries[2].value = 1;
+  entries[9].value = 1;
+  CHECK(argmax(entries, mask) == 2);
+
+  mask.assign(n, 0);
+  CHECK(argmax(entries, mask) == n);
+  mask[17] = 1;
+  CHECK(argmax(entries, mask) == 17);
+}
+
+} // namespace
+
+TEST_CASE("masked_argmax", "[policy][objectives][argmax]") {
+  SECTION("float") { checkKernel<float>(); }
+  SECTION("double") { checkKernel<double>(); }
+}
+
+TEST_CASE("getArgmaxKey", "[policy][objectives][argmax]") {
+
+  auto env = MChain64{};
+  const auto &states = env.indexedTransitionModel.states;
+  const auto a0 = MChain64::ActionSpace{0};
+  const auto a1 = MChain64::ActionSpace{1};
+
+  SECTION("Map tables only look at the state") {
+    auto values = FiniteStateActionValueFunction<MChain64>{};
+    values.initialize(env);
+    values[decltype(values)::KeyMaker::make(env, states[9], a0)].value = 10.0F;
+    values[decltype(values)::KeyMaker::make(env, states[3], a1)].value = 1.0F;
+    CHECK(values.getArgmaxKey(env, states[3]) == decltype(values)::KeyMaker::make(env, states[3], a1));
+    CHECK(values.getArgmaxKey(env, states[9]) == decltype(values)::KeyMaker::make(env, states[9], a0));
+    // Ties go to the lowest action
+    CHECK(values.getArgmaxKey(env, states[5]) == decltype(values)::KeyMaker::make(env, states[5], a0));
+  }
+
+  SECTION("Dense tables take the argmax of the row") {
+    using ValueFunction = DenseFiniteStateActionValueFunction<MChain64>;
+    STATIC_REQUIRE(hasRowArgmax<ValueFunction::ValueTableType>);
+    auto values = ValueFunction{};
+    CHECK(values.getArgmaxKey(env, states[3]).first == states[3]);
+
+    values.initialize(env);
+    values[ValueFunction::KeyMaker::make(env, states[9], a0)].value = 10.0F;
+    values[ValueFunction::KeyMaker::make(env, states[3], a1)].value = 1.0F;
+    CHECK(values.getArgmaxKey(env, states[3]) == ValueFunction::KeyMaker::make(env, states[3], a1));
+    CHECK(values.getArgmaxKey(env, states[9]) == ValueFunction::KeyMaker::make(env, states[9], a0));
+    CHECK(values.getArgmaxKey(env, states[5]) == ValueFunction::KeyMaker::make(env, states[5], a0));
+
+    // Absent entries are skipped
+    values.erase(ValueFunction::KeyMaker::make(env, states[3], a1));
+    values[ValueFunction::KeyMaker::make(env, states[3], a0)].value = -1.0F;
+    CHECK(values.getArgmaxKey(env, states[3]) == ValueFunction::KeyMaker::make(env, states[3], a0));
+  }
+}
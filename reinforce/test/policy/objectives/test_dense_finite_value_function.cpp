@@ -0,0 +1,215 @@
+#include <catch2/catch_approx.hpp>
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <stdexcept>
+
+#include <reinforce/policy/finite/greedy_policy.hpp>
+#include <reinforce/policy/objectives/dense_finite_value_function.hpp>
+#include <reinforce/temporal_difference/value_update/q_learning.hpp>
+
+#include "environment_fixtures.hpp"
+#include "markov_decision_process/coin_mdp.hpp"
+
+using namespace Catch;
+using namespace policy::objectives;
+using namespace fixtures;
+
+TEST_CASE("DenseKeyIndex", "[policy][objectives][dense]") {
+
+  const auto env = MChain64{};
+  const auto s5 = env.indexedTransitionModel.states[5];
+  const auto a1 = MChain64::ActionSpace{1};
+
+  SECTION("State action keys are numbered state major") {
+    using Index = DenseKeyIndex<StateActionKeymaker<MChain64>>;
+    STATIC_REQUIRE(Index::size == 64 * 2);
+    const auto key = StateActionKeymaker<MChain64>::make(env, s5, a1);
+    CHECK(Index::index(key) == 11);
+    CHECK(Index::key(11) == key);
+  }
+
+  SECTION("Packed keys number the same way") {
+    using Index = DenseKeyIndex<PackedStateActionKeymaker<MChain64>>;
+    const auto key = PackedStateActionKeymaker<MChain64>::make(env, s5, a1);
+    CHECK(Index::index(key) == 11);
+    CHECK(Index::key(11) == key);
+  }
+
+  SECTION("State and action keys") {
+    STATIC_REQUIRE(DenseKeyIndex<StateKeymaker<MChain64>>::size == 64);
+    STATIC_REQUIRE(DenseKeyIndex<ActionKeymaker<MChain64>>::size == 2);
+    CHECK(DenseKeyIndex<StateKeymaker<MChain64>>::index(s5) == 5);
+    CHECK(DenseKeyIndex<ActionKeymaker<MChain64>>::key(1) == a1);
+  }
+}
+
+TEST_CASE("DenseValueTable", "[policy][objectives][dense]") {
+
+  using ValueFunction = DenseFiniteStateActionValueFunction<MChain64>;
+  STATIC_REQUIRE(isFiniteValueFunction<ValueFunction>);
+  STATIC_REQUIRE(isFiniteStateValueFunction<ValueFunction>);
+
+  const auto env = MChain64{};
+  const auto &states = env.indexedTransitionModel.states;
+  auto values = ValueFunction{};
+  const auto k3 = ValueFunction::KeyMaker::make(env, states[3], MChain64::ActionSpace{0});
+  const auto k9 = ValueFunction::KeyMaker::make(env, states[9], MChain64::ActionSpace{1});
+
+  REQUIRE(values.empty());
+  CHECK(values.find(k3) == values.end());
+  CHECK_THROWS_AS(values.at(k3), std::out_of_range);
+
+  SECTION("Lookups behave as the map does") {
+    CHECK(values.valueAt(k9) == 0.0F);
+    values[k3].value = 2.0F;
+    values[k3].step++;
+    CHECK(values.size() == 2);
+    CHECK(values.at(k3).value == 2.0F);
+    CHECK(values.at(k3).step == 2);
+    CHECK(values.find(k9)->second.value == 0.0F);
+    CHECK_FALSE(values.emplace(k3, FiniteValue<MChain64>(5.0F)).second);
+    CHECK(values.valueAt(k3) == 2.0F);
+  }
+
+  SECTION("Iteration visits present keys in index order") {
+    values[k9].value = 1.0F;
+    values[k3].value = 2.0F;
+    auto it = values.begin();
+    CHECK(it->first == k3);
+    CHECK((*it).second.value == 2.0F);
+    ++it;
+    CHECK(it->first == k9);
+    CHECK(++it == values.end());
+
+    CHECK(values.erase(k3) == 1);
+    CHECK(values.begin()->first == k9);
+    CHECK(values.size() == 1);
+  }
+
+  SECTION("incrementalUpdate averages rewards") {
+    const auto t = MChain64::TransitionType{states[62], MChain64::ActionSpace{0}, states[63]};
+    values.incrementalUpdate(env, t);
+    values.incrementalUpdate(env, t);
+    const auto key = ValueFunction::KeyMaker::make(env, states[62], MChain64::ActionSpace{0});
+    CHECK(values.at(key).value == Approx(1.0));
+    CHECK(values.at(key).step == 2);
+  }
+}
+
+TEST_CASE("Cached row argmax", "[policy][objectives][dense]") {
+
+  using ValueFunction = DenseFiniteStateActionValueFunction<S1A4>;
+  STATIC_REQUIRE(hasCachedRowArgmax<ValueFunction::ValueTableType>);
+
+  auto env = S1A4{};
+  const auto s0 = env.stateFromIndex(0);
+  const auto key = [&](std::size_t a) { return ValueFunction::KeyMaker::make(env, s0, env.actionFromIndex(a)); };
+  auto values = ValueFunction{};
+  CHECK(values.rowArgmax(0) == 4);
+
+  values.initialize(env);
+  CHECK(values.rowArgmax(0) == 0);
+
+  SECTION("Raising a value moves the argmax to it") {
+    values[key(2)].value = 1.0F;
+    CHECK(values.rowArgmax(0) == 2);
+    values.at(key(3)).value = 1.0F;
+    CHECK(values.rowArgmax(0) == 2);
+    values.find(key(1))->second.value = 2.0F;
+    CHECK(values.rowArgmax(0) == 1);
+  }
+
+  SECTION("Lowering or erasing the best rescans the row") {
+    values[key(2)].value = 3.0F;
+    values[key(3)].value = 2.0F;
+    CHECK(values.rowArgmax(0) == 2);
+    values[key(2)].value = -1.0F;
+    CHECK(values.rowArgmax(0) == 3);
+    values.erase(key(3));
+    CHECK(values.rowArgmax(0) == 0);
+    CHECK(values.getArgmaxKey(env, s0) == key(0));
+  }
+
+  SECTION("A reference written after a read is seen") {
+    auto &value = values[key(1)];
+    const auto &constValues = values;
+    CHECK(constValues.rowArgmax(0) == 0);
+    value.value = 4.0F;
+    CHECK(constValues.rowArgmax(0) == 1);
+    value.value = -4.0F;
+    CHECK(constValues.rowArgmax(0) == 0);
+
+    // Handing out another entry of the row settles the first
+    values[key(3)].value = 1.0F;
+    CHECK(values.rowArgmax(0) == 3);
+    CHECK(values.rowSize(0) == 4);
+    values.erase(key(3));
+    CHECK(values.rowArgmax(0) == 0);
+    CHECK(values.rowSize(0) == 3);
+  }
+
+  SECTION("Writes while iterating are seen") {
+    for (auto [k, v] : values)
+      v.value = k == key(3) ? 5.0F : 0.0F;
+    CHECK(values.rowArgmax(0) == 3);
+  }
+
+  SECTION("Reads do not invalidate the cache and agree with a rescan") {
+    auto allowed = std::array<std::uint8_t, 4>{};
+    for (std::size_t step = 0; step < 200; ++step) {
+      values[key(step * 7 % 4)].value = float(step * 13 % 11) - 5.0F;
+      values.valueAt(key(step % 4));
+      allowed.fill(1);
+      CHECK(values.rowArgmax(0) == values.rowArgmax(0, allowed.data()));
+    }
+  }
+}
+
+TEST_CASE("Dense value functions are drop in", "[policy][objectives][dense]") {
+
+  SECTION("FiniteGreedyPolicy") {
+    auto env = S1A4{};
+    auto policy = policy::FiniteGreedyPolicy<DenseFiniteStateActionValueFunction<S1A4>>{};
+    const auto s0 = env.stateFromIndex(0);
+    policy[decltype(policy)::KeyMaker::make(env, s0, env.actionFromIndex(1))].value = 2.0;
+    CHECK(policy(env, s0) == env.actionFromIndex(1));
+    CHECK(policy.getProbability(env, s0, env.actionFromIndex(1)) == Approx(1.0));
+    policy[decltype(policy)::KeyMaker::make(env, s0, env.actionFromIndex(0))].value = 3.0;
+    CHECK(policy(env, s0) == env.actionFromIndex(0));
+  }
+
+  auto data = CoinModelDataFixture{};
+  auto &environ = data.environ;
+
+  SECTION("Q learning") {
+    using ValueFunction = DenseFiniteStateActionValueFunction<CoinEnviron>;
+    const auto key = [&](const CoinState &s, const CoinAction &a) {
+      return ValueFunction::KeyMaker::make(environ, s, a);
+    };
+    auto valueFunction = ValueFunction{};
+    auto updater = temporal_difference::QLearningUpdater<ValueFunction>();
+    updater.initialize(environ, valueFunction);
+    REQUIRE(valueFunction.size() == 4);
+    valueFunction[key(data.s0, data.a0)].value = 1.0F;
+    valueFunction[key(data.s1, data.a0)].value = 2.0F;
+    valueFunction[key(data.s1, data.a1)].value = -1.0F;
+
+    // The behaviour policy takes a1 from s0, wherever the coin lands
+    data.policy.setDeterministicPolicy(environ, data.s0, data.a1);
+    updater.update(valueFunction, data.policy, data.policy, environ, data.a1, 0.5F);
+
+    // Q(s0, a1) moves from 0 to the target r + 0.5 max_a Q(s', a)
+    const auto landed = environ.state;
+    const auto reward = landed == data.s1 ? 1.0F : -1.0F;
+    const auto maxNext = landed == data.s1 ? 2.0F : 1.0F;
+    CHECK(valueFunction.valueAt(key(data.s0, data.a1)) == Approx(reward + 0.5F * maxNext));
+    CHECK(valueFunction.at(key(data.s0, data.a1)).step == 2);
+    CHECK(valueFunction.valueAt(key(data.s0, data.a0)) == 1.0F);
+  }
+
+  SECTION("Monte Carlo average returns") {
+    auto valueFunction = DenseFiniteStateActionValueFunction<CoinEnviron>{};
+    CHECK(averageOfTwoReturns(data, valueFunction) == 1.5);
+  }
+}
@@ -0,0 +1,90 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/markov_decision_process/policy_iteration.hpp>
+#include <reinforce/policy/objectives/dense_finite_value_function.hpp>
+#include <reinforce/policy/objectives/finite_value_function.hpp>
+
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace policy::objectives;
+using namespace fixtures;
+
+namespace {
+
+template <typename VALUE_FUNCTION_T>
+void checkReadsDoNotInsert() {
+  const auto env = MChain64{};
+  const auto &states = env.indexedTransitionModel.states;
+  const auto a0 = MChain64::ActionSpace{0};
+  const auto a1 = MChain64::ActionSpace{1};
+  const auto k0 = VALUE_FUNCTION_T::KeyMaker::make(env, states[3], a0);
+  const auto k1 = VALUE_FUNCTION_T::KeyMaker::make(env, states[3], a1);
+
+  auto values = VALUE_FUNCTION_T{};
+  const auto &constValues = values;
+
+  CHECK(constValues.valueAtOrInitial(k0) == 0.5F);
+  CHECK(constValues.maxValueAt(env, states[3]) == 0.5F);
+  CHECK(values.empty());
+
+  values[k1].value = 2.0F;
+  CHECK(constValues.valueAtOrInitial(k1) == 2.0F);
+  CHECK(constValues.valueAtOrInitial(env, states[3], a0) == 0.5F);
+  CHECK(constValues.maxValueAt(env, states[3]) == 2.0F);
+  CHECK(values.size() == 1);
+
+  // valueAt still makes the entry
+  CHECK(values.valueAt(k0) == 0.5F);
+  CHECK(values.size() == 2);
+}
+
+template <typename VALUE_FUNCTION_T>
+void checkMaxValueAt() {
+  auto env = MChain64{};
+  const auto &states = env.indexedTransitionModel.states;
+  const auto key = [&](std::size_t a) {
+    return VALUE_FUNCTION_T::KeyMaker::make(env, states[3], env.actionFromIndex(a));
+  };
+  auto values = VALUE_FUNCTION_T{};
+
+  // The missing action counts at the initial value, above the entry
+  values[key(0)].value = -1.0F;
+  CHECK(values.maxValueAt(env, states[3]) == 0.5F);
+
+  // Once every action has an entry only the entries count
+  values[key(1)].value = -2.0F;
+  CHECK(values.maxValueAt(env, states[3]) == -1.0F);
+  values.initialize(env);
+  values[key(0)].value = -3.0F;
+  CHECK(values.maxValueAt(env, states[3]) == -2.0F);
+  CHECK(values.maxValueAt(env, states[4]) == 0.5F);
+}
+
+} // namespace
+
+TEST_CASE("Reads do not insert", "[policy][objectives][finite_value_function]") {
+  SECTION("unordered_map") { checkReadsDoNotInsert<FiniteStateActionValueFunction<MChain64, 0.5F>>(); }
+  SECTION("FlatHashMap") { checkReadsDoNotInsert<FlatFiniteStateActionValueFunction<MChain64, 0.5F>>(); }
+  SECTION("DenseValueTable") { checkReadsDoNotInsert<DenseFiniteStateActionValueFunction<MChain64, 0.5F>>(); }
+}
+
+TEST_CASE("Expected values of rows do not insert", "[policy][objectives][finite_value_function]") {
+
+  const auto env = MChain64{};
+  const auto &model = env.indexedTransitionModel;
+  auto values = FiniteStateValueFunction<MChain64, 0.0F, 0.5F>{};
+  values[model.states[1]].value = 4.0F;
+
+  const auto value = markov_decision_process::value_from_state_action(
+      values, env, model.states[0], MChain64::ActionSpace{1});
+  CHECK(values.size() == 1);
+  CHECK(value == Approx(markov_decision_process::value_from_row(values, env, model.row(0, 1))));
+}
+
+TEST_CASE("The max value counts missing actions at the initial value", "[policy][objectives][finite_value_function]") {
+  SECTION("unordered_map") { checkMaxValueAt<FiniteStateActionValueFunction<MChain64, 0.5F>>(); }
+  SECTION("FlatHashMap") { checkMaxValueAt<FlatFiniteStateActionValueFunction<MChain64, 0.5F>>(); }
+  SECTION("DenseValueTable") { checkMaxValueAt<DenseFiniteStateActionValueFunction<MChain64, 0.5F>>(); }
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <reinforce/rng/alias_table.hpp>
+
+using namespace Catch;
+
+TEST_CASE("uniformIndex stays in range and covers every index", "[rng][alias]") {
+  auto engine = rng::Engine(3);
+  auto counts = std::array<int, 7>{};
+  for (int i = 0; i < 70000; ++i) {
+    const auto k = rng::uniformIndex(counts.size(), engine);
+    REQUIRE(k < counts.size());
+    ++counts[k];
+  }
+  for (const auto c : counts)
+    CHECK(c == Approx(10000).margin(500));
+
+  CHECK(rng::uniformIndex(1, engine) == 0);
+}
+
+TEST_CASE("AliasTable samples in proportion to its weights", "[rng][alias]") {
+  auto engine = rng::Engine(5);
+
+  SECTION("Weighted") {
+    const auto weights = std::vector<double>{1.0, 2.0, 0.0, 4.0, 3.0};
+    const auto table = rng::AliasTable(weights);
+    CHECK(table.size() == weights.size());
+
+    constexpr int n = 100000;
+    auto counts = std::vector<int>(weights.size());
+    for (int i = 0; i < n; ++i)
+      ++counts[table(engine)];
+
+    CHECK(counts[2] == 0);
+    for (std::size_t k = 0; k < weights.size(); ++k)
+      CHECK(static_cast<double>(counts[k]) / n == Approx(weights[k] / 10.0).margin(0.01));
+  }
+
+  SECTION("A single outcome") {
+    const auto table = rng::AliasTable<float>(std::array<float, 1>{0.3F});
+    for (int i = 0; i < 10; ++i)
+      CHECK(table(engine) == 0);
+  }
+
+  SECTION("Invalid weights are rejected") {
+    CHECK_THROWS_AS(rng::AliasTable(std::vector<double>{}), std::runtime_error);
+    CHECK_THROWS_AS(rng::AliasTable(std::vector<double>{0.0, 0.0}), std::runtime_error);
+    CHECK_THROWS_AS(rng::AliasTable(std::vector<double>{1.0, -1.0}), std::runtime_error);
+  }
+}
+
+TEST_CASE("RowAliasTables samples each row in proportion to its weights", "[rng][alias]") {
+  auto engine = rng::Engine(7);
+  // Rows {1, 3}, {}, {2}, {0, 1, 1}
+  const auto offsets = std::vector<std::size_t>{0, 2, 2, 3, 6};
+  const auto weights = std::vector<float>{1.0F, 3.0F, 2.0F, 0.0F, 1.0F, 1.0F};
+  const auto tables =
+      rng::RowAliasTables<double>(std::span<const std::size_t>(offsets), std::span<const float>(weights));
+  REQUIRE(tables.nRows() == 4);
+  CHECK(tables.size(1) == 0);
+
+  constexpr int n = 100000;
+  auto counts = std::vector<int>(weights.size());
+  auto outOfRow = 0;
+  for (const std::size_t r : {0, 2, 3}) {
+    for (int i = 0; i < n; ++i) {
+      const auto k = tables(r, engine);
+      if (k < tables.size(r))
+        ++counts[offsets[r] + k];
+      else
+        ++outOfRow;
+    }
+  }
+  CHECK(static_cast<double>(counts[0]) / n == Approx(0.25).margin(0.01));
+  CHECK(outOfRow == 0);
+  CHECK(counts[1] + counts[0] == n);
+  CHECK(counts[2] == n);
+  CHECK(counts[3] == 0);
+  CHECK(static_cast<double>(counts[4]) / n == Approx(0.5).margin(0.01));
+
+  CHECK_THROWS_AS(tables(1, engine), std::runtime_error);
+}
@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+#include <concepts>
+#include <random>
+
+#include <reinforce/rng/engine.hpp>
+
+#include "environment_fixtures.hpp"
+
+TEST_CASE("xoshiro256** matches the reference implementation", "[rng][engine]") {
+  auto engine = rng::Engine(rng::Engine::StateType{1, 2, 3, 4});
+  CHECK(engine() == 11520);
+  CHECK(engine() == 0);
+  CHECK(engine() == 1509978240);
+  CHECK(engine() == 1215971899390074240ULL);
+
+  STATIC_REQUIRE(std::uniform_random_bit_generator<rng::Engine>);
+}
+
+TEST_CASE("Engines are reproducible and streams are independent", "[rng][engine]") {
+
+  SECTION("The same seed reproduces the same sequence") {
+    auto a = rng::Engine(42);
+    auto b = rng::Engine(42);
+    for (int i = 0; i < 100; ++i)
+      CHECK(a() == b());
+  }
+
+  SECTION("Split streams differ from each other and from the parent") {
+    const auto parent = rng::Engine(42);
+    auto s0 = parent.split(0);
+    auto s1 = parent.split(1);
+    CHECK(s0 != s1);
+    CHECK(s0 != parent);
+    CHECK(parent.split(0) == s0);
+
+    auto same = 0;
+    for (int i = 0; i < 100; ++i)
+      same += s0() == s1();
+    CHECK(same == 0);
+  }
+
+  SECTION("Jump advances the state") {
+    auto a = rng::Engine(42);
+    auto b = a;
+    b.jump();
+    CHECK(a != b);
+    CHECK(a() != b());
+  }
+
+  SECTION("Reseeding the library reproduces the engines made after it") {
+    rng::seed(7);
+    auto a0 = rng::makeEngine();
+    auto a1 = rng::makeEngine();
+    rng::seed(7);
+    auto b0 = rng::makeEngine();
+    auto b1 = rng::makeEngine();
+    CHECK(a0 == b0);
+    CHECK(a1 == b1);
+    CHECK(a0 != a1);
+
+    CHECK(rng::makeEngine(3) == rng::makeEngine(3));
+    CHECK(rng::makeEngine(3) != rng::makeEngine(4));
+  }
+
+  SECTION("Uniform draws lie in [0, 1)") {
+    auto engine = rng::Engine(42);
+    for (int i = 0; i < 1000; ++i) {
+      const auto u = rng::uniform(engine);
+      CHECK(u >= 0.0);
+      CHECK(u < 1.0);
+    }
+  }
+}
+
+TEST_CASE("Environments seeded identically sample identically", "[rng][environment]") {
+  using E = fixtures::simple_environment_builder_t<5, 3>;
+  auto a = E();
+  auto b = E();
+  a.seed(11);
+  b.seed(11);
+  for (int i = 0; i < 50; ++i) {
+    CHECK(a.randomState() == b.randomState());
+    CHECK(a.randomAction() == b.randomAction());
+  }
+}
@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/policy/random_policy.hpp>
+#include <reinforce/spec/batch.hpp>
+
+using namespace spec;
+
+namespace {
+enum class Choices { A, B, C };
+using GridSpec = BoundedAarraySpec<int, -3, 4, 2, 3>;
+using NoiseSpec = BoundedAarraySpec<float, -1.0F, 1.0F, 2>;
+using ChoiceSpec = CategoricalArraySpec<Choices, 3, 1>;
+using MixedSpec = CompositeArraySpec<GridSpec, NoiseSpec, ChoiceSpec>;
+} // namespace
+
+TEST_CASE("Batch layout", "[spec][batch]") {
+
+  using FixedBatch = Batch<MixedSpec, 8>;
+  static_assert(isFixedBatch<FixedBatch>);
+  static_assert(!isDynamicBatch<FixedBatch>);
+  static_assert(isDynamicBatch<DynamicBatch<MixedSpec>>);
+  STATIC_REQUIRE(FixedBatch::extent == 8);
+  CHECK(FixedBatch().size() == 8);
+
+  // Each element is a single tensor with a leading batch dimension
+  static_assert(
+      std::is_same_v<std::tuple_element_t<0, FixedBatch::tupleDataType>, xt::xtensor_fixed<int, xt::xshape<8, 2, 3>>>);
+  static_assert(std::is_same_v<std::tuple_element_t<1, DynamicBatch<MixedSpec>::tupleDataType>, xt::xtensor<float, 2>>);
+
+  auto batch = DynamicBatch<MixedSpec>(5);
+  CHECK(batch.size() == 5);
+  CHECK(std::get<0>(batch).size() == 5 * 2 * 3);
+  CHECK(std::get<2>(batch).size() == 5);
+}
+
+TEST_CASE("Batch samples can be set and read back", "[spec][batch]") {
+
+  auto batch = default_spec_gen<DynamicBatch<MixedSpec>>(4);
+  const auto sample = MixedSpec::DataType({{0, 1, 2}, {3, -3, -2}}, {0.5F, -0.5F}, {2});
+  batch.set(2, sample);
+
+  CHECK(batch.get(2) == sample);
+  CHECK(batch.get(1) == default_spec_gen<MixedSpec>());
+  CHECK(batch.get(3) == default_spec_gen<MixedSpec>());
+
+  // The sample occupies row 2 of every element tensor
+  CHECK(std::get<0>(batch)(2, 1, 0) == 3);
+  CHECK(std::get<1>(batch)(2, 1) == -0.5F);
+  CHECK(std::get<2>(batch)(2, 0) == 2);
+}
+
+TEST_CASE("Batched generators", "[spec][batch]") {
+
+  SECTION("default_spec_gen uses the min") {
+    const auto batch = default_spec_gen<Batch<MixedSpec, 3>>();
+    for (std::size_t i = 0; i < batch.size(); ++i)
+      CHECK(batch.get(i) == default_spec_gen<MixedSpec>());
+  }
+
+  SECTION("constant_spec_gen fills every sample") {
+    const auto batch = constant_spec_gen<DynamicBatch<MixedSpec>>(6, 1.0);
+    CHECK(batch.get(5) == MixedSpec::DataType({{1, 1, 1}, {1, 1, 1}}, {1.0F, 1.0F}, {1}));
+    for (const auto &v : std::get<0>(batch))
+      CHECK(v == 1);
+    CHECK_THROWS(constant_spec_gen<Batch<MixedSpec, 2>>(-5.0));
+  }
+
+  SECTION("random_spec_gen respects the spec bounds") {
+    const auto batch = policy::random_spec_gen<DynamicBatch<MixedSpec>>(1000);
+    for (const auto &v : std::get<0>(batch)) {
+      CHECK(v >= GridSpec::min);
+      CHECK(v < GridSpec::max);
+    }
+    for (const auto &v : std::get<1>(batch)) {
+      CHECK(v >= NoiseSpec::min);
+      CHECK(v <= NoiseSpec::max);
+    }
+    for (const auto &v : std::get<2>(batch)) {
+      CHECK(v >= 0);
+      CHECK(v < 3);
+    }
+    const auto fixed = policy::random_spec_gen<Batch<MixedSpec, 16>>();
+    CHECK(fixed.size() == 16);
+  }
+}
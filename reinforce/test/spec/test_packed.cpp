@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/policy/objectives/finite_value_function.hpp>
+#include <reinforce/policy/objectives/value_function_keymaker.hpp>
+#include <reinforce/spec/packed.hpp>
+
+#include "environment_fixtures.hpp"
+
+using namespace spec;
+
+namespace {
+enum class Choices { A, B, C };
+using HandSpec = BoundedAarraySpec<int, 2, 22, 1>;
+using AceSpec = BoundedAarraySpec<int, 0, 2, 1>;
+using GridSpec = BoundedAarraySpec<int, -3, 4, 2, 3>;
+using ChoiceSpec = CategoricalArraySpec<Choices, 3, 1>;
+using HandStateSpec = CompositeArraySpec<HandSpec, AceSpec, HandSpec, AceSpec>;
+using MixedSpec = CompositeArraySpec<GridSpec, ChoiceSpec>;
+} // namespace
+
+TEST_CASE("PackedLayout", "[spec][packed]") {
+
+  using Layout = PackedLayout<HandStateSpec>;
+
+  // 20 values need 5 bits, 2 values need a single bit
+  static_assert(Layout::nFields == 4);
+  static_assert(Layout::elementBits[0] == 5);
+  static_assert(Layout::elementBits[1] == 1);
+  static_assert(Layout::fields[2].shift == 6);
+  static_assert(Layout::nWords == 1);
+  static_assert(sizeof(PackedCompositeArray<HandStateSpec>) == sizeof(std::uint64_t));
+
+  // Fields are never split across words
+  using WideSpec = CompositeArraySpec<BoundedAarraySpec<int, 0, 1000, 7>>;
+  using WideLayout = PackedLayout<WideSpec>;
+  static_assert(WideLayout::elementBits[0] == 10);
+  static_assert(WideLayout::nWords == 2);
+  static_assert(WideLayout::fields[6].word == 1);
+  static_assert(WideLayout::fields[6].shift == 0);
+}
+
+TEST_CASE("PackedCompositeArray", "[spec][packed]") {
+
+  using Packed = PackedCompositeArray<MixedSpec>;
+
+  SECTION("Default packed arrays hold the spec minimum") {
+    constexpr auto packed = Packed();
+    static_assert(packed.get<0>(0) == GridSpec::min);
+    static_assert(packed.get<1>() == 0);
+    CHECK(packed.unpack() == default_spec_gen<MixedSpec>());
+  }
+
+  SECTION("Fields can be set and read back at compile time") {
+    constexpr auto packed = [] {
+      auto p = Packed();
+      p.set<0>(4, -2);
+      p.set<1>(0, 2);
+      return p;
+    }();
+    static_assert(packed.get<0>(4) == -2);
+    static_assert(packed.get<0>(3) == GridSpec::min);
+    static_assert(packed.get<1>() == 2);
+  }
+
+  SECTION("Packing round trips every value of the spec") {
+    for (std::size_t i = 0; i < MixedSpec::nPossibleValues(); i += 97) {
+      const auto data = fromIndex<MixedSpec>(i);
+      const auto packed = Packed(data);
+      CHECK(packed.unpack() == data);
+      CHECK(packed == Packed(packed.unpack()));
+      CHECK(packed.hash() == Packed(data).hash());
+    }
+  }
+
+  SECTION("Distinct values pack differently") {
+    CHECK_FALSE(Packed(fromIndex<MixedSpec>(1)) == Packed(fromIndex<MixedSpec>(2)));
+  }
+}
+
+TEST_CASE("PackedStateActionKeymaker", "[spec][packed][policy][objectives][KeyMaker]") {
+
+  using Environment = fixtures::S2A2;
+  using KeyMaker = policy::objectives::PackedStateActionKeymaker<Environment>;
+  static_assert(policy::objectives::isValueFunctionKeymaker<KeyMaker>);
+  static_assert(policy::objectives::isStateActionKeymaker<KeyMaker>);
+
+  auto env = Environment();
+  auto state = typename Environment::StateType(1, {});
+  auto action = typename Environment::ActionSpace(1);
+
+  auto key = KeyMaker::make(env, state, action);
+  CHECK(KeyMaker::get_state_from_key(env, key) == state);
+  CHECK(KeyMaker::get_action_from_key(env, key) == action);
+  CHECK(key == KeyMaker::make(env, state, action));
+  CHECK_FALSE(key == KeyMaker::make(env, state, typename Environment::ActionSpace(0)));
+
+  using ValueFunction =
+      policy::objectives::FiniteValueFunctionHelper<KeyMaker, policy::objectives::FiniteValue<Environment>>;
+  auto valueFunction = ValueFunction();
+  valueFunction.initialize(env);
+  CHECK(valueFunction.size() == 4);
+  valueFunction.at(key).value = 1.0F;
+  CHECK(valueFunction.valueAt(KeyMaker::make(env, state, action)) == 1.0F);
+}
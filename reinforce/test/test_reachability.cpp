@@ -0,0 +1,97 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <reinforce/markov_decision_process/linear_policy_evaluation.hpp>
+#include <reinforce/markov_decision_process/policy_iteration.hpp>
+#include <reinforce/markov_decision_process/synchronous.hpp>
+#include <reinforce/markov_decision_process/topological_value_iteration.hpp>
+#include <reinforce/markov_decision_process/value_iteration.hpp>
+#include <reinforce/reachability.hpp>
+
+#include "environment_fixtures.hpp"
+
+using namespace Catch;
+using namespace markov_decision_process;
+
+namespace {
+
+using fixtures::optimalChainValue;
+using fixtures::UpperChain;
+using UpperChainValueFunction = policy::objectives::FiniteStateValueFunction<UpperChain, 0.0F, 0.99F>;
+constexpr auto n = fixtures::chainLength;
+
+} // namespace
+
+TEST_CASE("Reachable states", "[reachability]") {
+
+  static_assert(environment::InitialStateEnvironment<UpperChain>);
+  static_assert(not environment::InitialStateEnvironment<fixtures::MChain64>);
+
+  auto environ = UpperChain();
+  const auto &model = environ.indexedTransitionModel;
+
+  SECTION("By index") {
+    const auto starts = std::vector<std::uint32_t>{32};
+    const auto reachable = model.reachable(starts);
+    REQUIRE(reachable.size() == n);
+    for (std::size_t i = 0; i < n; ++i)
+      CHECK(reachable[i] == (i >= n / 2));
+    CHECK(model.reachable({}) == std::vector<std::uint8_t>(n, 0));
+  }
+
+  SECTION("By state") {
+    const auto states = environment::reachableStates(environ);
+    CHECK(states.size() == n / 2);
+    for (std::size_t i = n / 2; i < n; ++i)
+      CHECK(states.contains(model.states[i]));
+  }
+
+  SECTION("Value functions only initialise reachable states") {
+    auto values = UpperChainValueFunction{};
+    values.initialize(environ);
+    CHECK(values.size() == n / 2);
+    for (std::size_t i = 0; i < n / 2; ++i)
+      CHECK(values.find(model.states[i]) == values.end());
+  }
+}
+
+TEST_CASE("Solvers only sweep reachable states", "[reachability]") {
+
+  const auto environ = UpperChain();
+  const auto &model = environ.indexedTransitionModel;
+  auto values = UpperChainValueFunction{};
+
+  auto checkUpperHalf = [&](double margin) {
+    for (std::size_t i = n / 2; i < n; ++i)
+      CHECK(values.valueAt(model.states[i]) == Approx(optimalChainValue(i)).margin(margin));
+    for (std::size_t i = 0; i < n / 2; ++i)
+      CHECK(values.find(model.states[i]) == values.end());
+  };
+
+  SECTION("In place value iteration") {
+    value_iteration::value_iteration_policy_estimation(values, environ, 1e-6F);
+    checkUpperHalf(1e-4);
+  }
+
+  SECTION("Synchronous value iteration") {
+    auto pool = utils::ThreadPool(2);
+    synchronous::value_iteration_policy_estimation(values, environ, 1e-6F, pool);
+    checkUpperHalf(1e-4);
+  }
+
+  SECTION("Topological value iteration") {
+    topological::value_iteration_policy_estimation(values, environ, 1e-6F);
+    checkUpperHalf(1e-4);
+  }
+
+  SECTION("Policy iteration") {
+    auto policy = policy::FiniteDeterministicPolicy<UpperChain>(environ);
+    for (std::size_t i = 0; i < n; ++i)
+      policy.setActionIndex(i, 1);
+    linear_solve::policy_iteration(values, environ, policy, 1e-7F);
+    checkUpperHalf(1e-3);
+    // The policy of unreachable states is never improved
+    for (std::size_t i = 0; i < n / 2; ++i)
+      CHECK(policy.actionIndex(i) == 1);
+  }
+}
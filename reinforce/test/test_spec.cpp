@@ -1,7 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include <cmath>
 #include <iostream>
+#include <ranges>
 #include <tuple>
+#include <unordered_set>
 
 #include <xtensor/xfixed.hpp>
 
@@ -120,4 +122,102 @@ TEST_CASE("BoundedAarraySpec instantiation", "[spec][BoundedAarraySpec]") {
   [&]<std::size_t... k>(std::index_sequence<k...>) {
     (testType_impl.template operator()<k>(), ...);
   }(std::make_index_sequence<std::tuple_size_v<typesToCheck>>{});
-}
\ No newline at end of file
+}
+TEST_CASE("Mixed radix spec indexing", "[spec][toIndex][fromIndex]") {
+
+  enum class Choices { A, B, C };
+  using BoundedSpec = spec::BoundedAarraySpec<int, -2, 3, 2, 2>;
+  using CategoricalSpec = spec::CategoricalArraySpec<Choices, 3, 1>;
+  using Composite = spec::CompositeArraySpec<CategoricalSpec, BoundedSpec>;
+
+  // Every entry of an array contributes a digit with radix (max - min)
+  static_assert(spec::nArrayValues<BoundedSpec>() == 5 * 5 * 5 * 5);
+  static_assert(spec::nArrayValues<CategoricalSpec>() == 3);
+  static_assert(Composite::nPossibleValues() == 3 * 625);
+
+  SECTION("The first composite element is the most significant") {
+    auto data = Composite::DataType({1}, {{-2, -2}, {-2, -1}});
+    CHECK(spec::toIndex<Composite>(data) == 1 * 625 + 1);
+  }
+
+  SECTION("fromIndex is the inverse of toIndex") {
+    for (std::size_t i = 0; i < Composite::nPossibleValues(); ++i) {
+      const auto data = spec::fromIndex<Composite>(i);
+      CHECK(spec::toIndex<Composite>(data) == i);
+    }
+  }
+
+  SECTION("Decoded values respect the spec bounds") {
+    for (std::size_t i = 0; i < spec::nArrayValues<BoundedSpec>(); ++i) {
+      for (const auto &v : spec::fromIndex<BoundedSpec>(i)) {
+        CHECK(v >= BoundedSpec::min);
+        CHECK(v < BoundedSpec::max);
+      }
+    }
+  }
+}
+
+TEST_CASE("CompositeArray hashing", "[spec][CompositeArray][hash]") {
+
+  using IntSpec = spec::BoundedAarraySpec<int, 0, 10, 2>;
+  using FloatSpec = spec::BoundedAarraySpec<float, -1.0F, 1.0F, 1>;
+  using Composite = spec::CompositeArraySpec<IntSpec, FloatSpec>;
+  using DataType = Composite::DataType;
+
+  SECTION("Equal arrays hash equal") {
+    const auto a = DataType({1, 2}, {0.5F});
+    const auto b = DataType({1, 2}, {0.5F});
+    CHECK(a == b);
+    CHECK(a.hash() == b.hash());
+  }
+
+  SECTION("Signed zeros compare and hash equal") {
+    const auto a = DataType({1, 2}, {0.0F});
+    const auto b = DataType({1, 2}, {-0.0F});
+    CHECK(a == b);
+    CHECK(a.hash() == b.hash());
+  }
+
+  SECTION("Arrays that differ by element order hash differently") {
+    const auto a = DataType({1, 2}, {0.0F});
+    const auto b = DataType({2, 1}, {0.0F});
+    CHECK_FALSE(a == b);
+    CHECK(a.hash() != b.hash());
+  }
+}
+
+TEST_CASE("Lazy range over all values of a finite spec", "[spec][values]") {
+
+  enum class Choices { A, B, C };
+  using BoundedSpec = spec::BoundedAarraySpec<int, 1, 4, 2>;
+  using CategoricalSpec = spec::CategoricalArraySpec<Choices, 3, 1>;
+  using Composite = spec::CompositeArraySpec<BoundedSpec, CategoricalSpec>;
+
+  constexpr auto range = spec::values<Composite>();
+  static_assert(std::ranges::random_access_range<decltype(range)>);
+  static_assert(std::ranges::sized_range<decltype(range)>);
+  static_assert(range.size() == 27);
+  static_assert(spec::values<BoundedSpec>().size() == 9);
+
+  SECTION("Values are yielded in index order") {
+    std::size_t i = 0;
+    for (const auto &v : range) {
+      CHECK(spec::toIndex<Composite>(v) == i);
+      ++i;
+    }
+    CHECK(i == range.size());
+  }
+
+  SECTION("Random access matches iteration") {
+    CHECK(range[13] == *(range.begin() + 13));
+    CHECK(range.end() - range.begin() == 27);
+    CHECK(range[0] == spec::default_spec_gen<Composite>());
+  }
+
+  SECTION("Each value is distinct") {
+    std::unordered_set<std::size_t> hashes;
+    for (const auto &v : range)
+      hashes.insert(v.hash());
+    CHECK(hashes.size() == range.size());
+  }
+}
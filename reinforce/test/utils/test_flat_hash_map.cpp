@@ -0,0 +1,106 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <reinforce/monte_carlo/value_update/average_return.hpp>
+#include <reinforce/utils/flat_hash_map.hpp>
+
+#include "markov_decision_process/coin_mdp.hpp"
+
+namespace {
+
+// Sends every key to the same few slots so probe runs are long
+struct CollidingHash {
+  std::size_t operator()(int key) const { return static_cast<std::size_t>(key % 3); }
+};
+
+} // namespace
+
+TEST_CASE("FlatHashMap", "[utils][flat_hash_map]") {
+
+  auto map = utils::FlatHashMap<int, std::string>{};
+  REQUIRE(map.empty());
+  CHECK(map.find(1) == map.end());
+  CHECK_THROWS_AS(map.at(1), std::out_of_range);
+
+  SECTION("Insert and look up") {
+    CHECK(map.try_emplace(1, "one").second);
+    CHECK_FALSE(map.try_emplace(1, "uno").second);
+    CHECK(map.emplace(2, "two").first->second == "two");
+    map[3] = "three";
+    CHECK(map.size() == 3);
+    CHECK(map.at(1) == "one");
+    CHECK(map.find(3)->second == "three");
+    CHECK(map[4].empty());
+    CHECK(map.contains(4));
+  }
+
+  SECTION("Growth keeps every entry") {
+    for (int i = 0; i < 1000; ++i)
+      map[i] = std::to_string(i);
+    CHECK(map.size() == 1000);
+    CHECK(map.load_factor() <= 0.875);
+    for (int i = 0; i < 1000; ++i)
+      CHECK(map.at(i) == std::to_string(i));
+
+    std::size_t n = 0;
+    for (const auto &[key, value] : map) {
+      CHECK(value == std::to_string(key));
+      ++n;
+    }
+    CHECK(n == 1000);
+  }
+}
+
+TEST_CASE("FlatHashMap agrees with std::map under collisions", "[utils][flat_hash_map]") {
+
+  auto map = utils::FlatHashMap<int, int, CollidingHash>{};
+  auto reference = std::map<int, int>{};
+
+  // Interleave inserts and erases so backward shifting runs through long
+  // chains of colliding keys
+  for (int i = 0; i < 200; ++i) {
+    map[i] = i * i;
+    reference[i] = i * i;
+    if (i % 3 == 0) {
+      CHECK(map.erase(i / 2) == reference.erase(i / 2));
+    }
+  }
+  CHECK(map.erase(1000) == 0);
+
+  REQUIRE(map.size() == reference.size());
+  for (const auto &[key, value] : reference)
+    CHECK(map.at(key) == value);
+  for (const auto &[key, value] : map)
+    CHECK(reference.at(key) == value);
+
+  for (const auto &[key, value] : reference)
+    map.erase(key);
+  CHECK(map.empty());
+  CHECK(map.begin() == map.end());
+}
+
+TEST_CASE("Flat value functions", "[utils][flat_hash_map]") {
+
+  using FlatValueFunction = policy::objectives::FlatFiniteStateActionValueFunction<CoinEnviron>;
+  STATIC_REQUIRE(policy::objectives::isFiniteValueFunction<FlatValueFunction>);
+
+  auto data = CoinModelDataFixture{};
+  auto valueFunction = FlatValueFunction{};
+  valueFunction.initialize(data.environ);
+  CHECK(valueFunction.size() == 4);
+
+  // The returns of the updater are held in the same kind of table
+  auto updater = monte_carlo::NiaveAverageReturnsUpdate<FlatValueFunction>();
+  STATIC_REQUIRE(std::is_same_v<
+                 typename decltype(updater)::ReturnsMap,
+                 utils::FlatHashMap<
+                     FlatValueFunction::KeyType,
+                     typename decltype(updater)::ReturnsContainer,
+                     FlatValueFunction::KeyMaker::Hash>>);
+
+  CHECK(averageOfTwoReturns(data, valueFunction) == 1.5);
+}
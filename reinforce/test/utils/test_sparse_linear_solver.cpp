@@ -0,0 +1,81 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <reinforce/utils/sparse_linear_solver.hpp>
+
+using namespace Catch;
+
+namespace {
+
+// A non symmetric, diagonally dominant tridiagonal system with a known solution
+utils::CsrMatrix<double> tridiagonal(std::size_t n) {
+  auto A = utils::CsrMatrix<double>{};
+  for (std::size_t i = 0; i < n; ++i) {
+    A.addEntry(i, 4.0);
+    if (i > 0)
+      A.addEntry(i - 1, -1.5);
+    if (i + 1 < n)
+      A.addEntry(i + 1, -0.5);
+    A.endRow();
+  }
+  return A;
+}
+
+} // namespace
+
+TEST_CASE("CsrMatrix stores rows in order", "[utils][sparse_linear_solver]") {
+  const auto A = tridiagonal(3);
+  CHECK(A.size() == 3);
+  CHECK(A.nEntries() == 7);
+  CHECK(A.diagonal() == std::vector<double>{4.0, 4.0, 4.0});
+
+  auto y = std::vector<double>{};
+  A.multiply({1.0, 2.0, 3.0}, y);
+  CHECK(y == std::vector<double>{3.0, 5.0, 9.0});
+}
+
+TEST_CASE("bicgstab solves a non symmetric system", "[utils][sparse_linear_solver]") {
+  constexpr std::size_t n = 50;
+  const auto A = tridiagonal(n);
+  auto expected = std::vector<double>(n);
+  for (std::size_t i = 0; i < n; ++i)
+    expected[i] = static_cast<double>(i % 7) - 3.0;
+  auto b = std::vector<double>{};
+  A.multiply(expected, b);
+
+  SECTION("From a zero initial guess") {
+    auto x = std::vector<double>(n, 0.0);
+    const auto result = utils::bicgstab(A, b, x, 1e-10);
+    CHECK(result.residual <= 1e-10);
+    CHECK(result.iterations < n);
+    for (std::size_t i = 0; i < n; ++i)
+      CHECK(x[i] == Approx(expected[i]).margin(1e-8));
+
+    // The reported residual is that of the returned x
+    auto Ax = std::vector<double>{};
+    A.multiply(x, Ax);
+    double residual = 0;
+    for (std::size_t i = 0; i < n; ++i)
+      residual = std::max(residual, std::abs(b[i] - Ax[i]));
+    CHECK(result.residual == residual);
+  }
+
+  SECTION("An exact initial guess needs no iterations") {
+    auto x = expected;
+    CHECK(utils::bicgstab(A, b, x, 1e-10).iterations == 0);
+  }
+
+  SECTION("Mismatched dimensions are rejected") {
+    auto x = std::vector<double>(n - 1, 0.0);
+    CHECK_THROWS_AS(utils::bicgstab(A, b, x, 1e-10), std::invalid_argument);
+  }
+
+  SECTION("Running out of iterations throws") {
+    auto x = std::vector<double>(n, 0.0);
+    CHECK_THROWS_AS(utils::bicgstab(A, b, x, 1e-10, 1), std::runtime_error);
+  }
+}
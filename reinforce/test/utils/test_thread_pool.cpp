@@ -0,0 +1,54 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <reinforce/utils/thread_pool.hpp>
+
+TEST_CASE("ThreadPool splits a range into contiguous chunks", "[utils][thread_pool]") {
+
+  auto pool = utils::ThreadPool(4);
+  CHECK(pool.size() == 4);
+
+  SECTION("Every index is visited exactly once") {
+    for (const std::size_t n : {0, 1, 3, 4, 1001}) {
+      auto visits = std::vector<int>(n);
+      pool.run(n, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+          ++visits[i];
+      });
+      CHECK(std::count(visits.begin(), visits.end(), 1) == static_cast<long>(n));
+    }
+  }
+
+  SECTION("Per worker reductions are deterministic") {
+    auto partial = std::vector<std::size_t>(pool.size());
+    for (int repeat = 0; repeat < 20; ++repeat) {
+      pool.run(1000, [&](std::size_t worker, std::size_t begin, std::size_t end) {
+        partial[worker] = 0;
+        for (auto i = begin; i < end; ++i)
+          partial[worker] += i;
+      });
+      CHECK(std::accumulate(partial.begin(), partial.end(), std::size_t{0}) == 999 * 1000 / 2);
+    }
+    const auto [begin, end] = pool.chunk(3, 10);
+    CHECK(begin == 8);
+    CHECK(end == 10);
+  }
+
+  SECTION("Exceptions are rethrown on the calling thread") {
+    CHECK_THROWS_AS(
+        pool.run(
+            100,
+            [](std::size_t worker, std::size_t, std::size_t) {
+              if (worker == 2)
+                throw std::runtime_error("failed");
+            }),
+        std::runtime_error);
+    // The pool is still usable afterwards
+    auto count = std::vector<int>(pool.size());
+    pool.run(100, [&](std::size_t worker, std::size_t, std::size_t) { count[worker] = 1; });
+    CHECK(std::accumulate(count.begin(), count.end(), 0) == 4);
+  }
+}